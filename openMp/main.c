@@ -1,4 +1,5 @@
 #include "define.h"
+#include <string.h>
 /***********************************************************************
  * main.c written by DSU_410 team ...
  *
@@ -6,8 +7,12 @@
  * and store the result. Performs matrix multiplication concurrently 
  * using openMP.
  *
- * compile: %gcc main.c 2DArray.c -o mmopenmp -fopenmp
- * execute: ./mmopenmp
+ * compile: %gcc main.c 2DArray.c perf.c -o mmopenmp -fopenmp
+ * execute: ./mmopenmp [--perf]
+ *
+ * --perf writes hardware counters for each phase, and for each thread
+ * of the OpenMP region in multiply, to stderr as JSON lines (see
+ * perf.c).
  *
  * Process:
  * 1.) Fill two 2D arrays A and B with random values.
@@ -31,7 +36,8 @@ int C[N][M];
  * row, and stores the result into array C.
  *
  * Process:
- * 1.) Perform multiplication and store result.
+ * 1.) Perform multiplication and store result, each thread measuring
+ *     its share of the rows with perf.c.
  *
  * Parameter     Direction   Description
  * ----------------------------------------------------------------------------
@@ -52,11 +58,23 @@ int C[N][M];
 void multiply()
 {
     int i, j, k;
-    #pragma omp parallel for private(i, j, k)
-    for (i = 0; i < N; i++)
-        for (j = 0; j < M; j++)
-            for (k = 0; k < P; k++)
-                C[i][j] += A[i][k] * B[k][j];
+    #pragma omp parallel private(i, j, k)
+    {
+        PerfCounters pc;
+        int bMeasure = perfEnabled();
+        if (bMeasure)
+            perfStart(&pc);
+        #pragma omp for
+        for (i = 0; i < N; i++)
+            for (j = 0; j < M; j++)
+                for (k = 0; k < P; k++)
+                    C[i][j] += A[i][k] * B[k][j];
+        if (bMeasure)
+        {
+            perfStop(&pc);
+            perfReport("multiply.thread", THREAD_NUM(), &pc);
+        }
+    }
 }
 
 /*******************************  setUpMatrices  *************************
@@ -129,17 +147,34 @@ void printResult()
 
 int main(int argc, const char * argv[])
 {
+    PerfCounters pc;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--perf") == 0)
+            perfEnable(stderr);
+    }
     
     // Set up Matrices, includes memory allocation and assigning values
+    perfStartProcess(&pc);
     setUpMatrices();
+    perfStop(&pc);
+    perfReport("setup", -1, &pc);
     
     // Try to multiply Matrices A B, store result into Matrix C
     // If multiplication not performed FALSE is returned
+    perfStartProcess(&pc);
     multiply();
+    perfStop(&pc);
+    perfReport("multiply", -1, &pc);
     
     // Matrix multiplication was performed, print out results stored
     // in Matrix C
+    perfStartProcess(&pc);
     printResult();
+    perfStop(&pc);
+    perfReport("output", -1, &pc);
     
     return 0;
 }
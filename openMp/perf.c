@@ -0,0 +1,350 @@
+#include "define.h"
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/***********************************************************************
+ * perf.c written by DSU_410 team ...
+ *
+ * Description: Hardware performance counters around the phases of a
+ * run (set up, multiply, output) and around each thread's share of the
+ * multiply. Uses perf_event_open to count cycles, instructions, L1D and
+ * last level cache misses and dTLB misses. Every measurement is written
+ * as one JSON object per line so it can be fed straight to scripts.
+ *
+ * perfStart counts the calling thread only. perfStartProcess counts
+ * every thread of the process: the threads already running (e.g. an
+ * OpenMP pool started by an earlier parallel region) each get their own
+ * counters, and threads created later are followed with inherit.
+ *
+ * Counters the kernel refuses (containers, perf_event_paranoid, other
+ * operating systems) are reported as null. Wall time is always
+ * reported, so a report is still useful with no counters at all.
+ *
+ * Functions:
+ * - perfEnable
+ * - perfEnabled
+ * - perfStart
+ * - perfStartProcess
+ * - perfStop
+ * - perfReport
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// Names used in the report, in the order of the PERF_* constants
+static const char *perfNames[PERF_EVENTS] =
+{
+    "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses"
+};
+
+// Where reports go, NULL while instrumentation is off
+static FILE *perfOut = NULL;
+
+/*****************************   perfEnable   ***************************
+ * void perfEnable(FILE *out)
+ *
+ * Description: Turns instrumentation on, reporting to out, or off when
+ * out is NULL.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * out           in          Stream receiving JSON lines, or NULL.
+ ***********************************************************************/
+void perfEnable(FILE *out)
+{
+    perfOut = out;
+}
+
+/*****************************   perfEnabled   **************************
+ * int perfEnabled(void)
+ *
+ * Description: Tells callers whether to measure at all, so disabled
+ * instrumentation costs a single test.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          perfEnable was given a stream.
+ * FALSE         Instrumentation is off.
+ ***********************************************************************/
+int perfEnabled(void)
+{
+    return perfOut != NULL;
+}
+
+#ifdef __linux__
+// Cache event config for read misses, OR'd with the cache id
+#define CACHE_READ_MISS     ((PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/****************************   openCounter   ***************************
+ * static int openCounter(unsigned int type, unsigned long long config,
+ *                        pid_t tid, int bInherit)
+ *
+ * Description: Opens one disabled counter for thread tid, counting user
+ * space only.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * type          in          PERF_TYPE_* event type.
+ * config        in          Event within type.
+ * tid           in          Thread id, 0 for the calling thread.
+ * bInherit      in          Boolean, TRUE also counts threads the thread
+ *                           creates from now on.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * fd            Counter file descriptor.
+ * -1            Counter not available.
+ ***********************************************************************/
+static int openCounter(unsigned int type, unsigned long long config,
+                       pid_t tid, int bInherit)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = bInherit ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0);
+}
+
+/****************************   openCounters   **************************
+ * static void openCounters(int *fd, pid_t tid, int bInherit)
+ *
+ * Description: Opens and starts all PERF_EVENTS counters for thread tid
+ * into fd, -1 for those not available. See openCounter.
+ ***********************************************************************/
+static void openCounters(int *fd, pid_t tid, int bInherit)
+{
+    int i;
+    fd[PERF_CYCLES] = openCounter(PERF_TYPE_HARDWARE,
+                                  PERF_COUNT_HW_CPU_CYCLES, tid, bInherit);
+    fd[PERF_INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE,
+                                        PERF_COUNT_HW_INSTRUCTIONS, tid,
+                                        bInherit);
+    fd[PERF_L1D_MISSES] = openCounter(PERF_TYPE_HW_CACHE,
+                                      PERF_COUNT_HW_CACHE_L1D |
+                                      CACHE_READ_MISS, tid, bInherit);
+    fd[PERF_LLC_MISSES] = openCounter(PERF_TYPE_HARDWARE,
+                                      PERF_COUNT_HW_CACHE_MISSES, tid,
+                                      bInherit);
+    fd[PERF_DTLB_MISSES] = openCounter(PERF_TYPE_HW_CACHE,
+                                       PERF_COUNT_HW_CACHE_DTLB |
+                                       CACHE_READ_MISS, tid, bInherit);
+    for (i = 0; i < PERF_EVENTS; i++)
+        if (fd[i] >= 0)
+        {
+            ioctl(fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+}
+
+/****************************   readCounter   ***************************
+ * static long long readCounter(int fd)
+ *
+ * Description: Stops, reads and closes one counter. Returns -1 if fd is
+ * -1 or the read fails.
+ ***********************************************************************/
+static long long readCounter(int fd)
+{
+    long long value = -1;
+    if (fd < 0)
+        return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &value, sizeof(long long)) != sizeof(long long))
+        value = -1;
+    close(fd);
+    return value;
+}
+#endif
+
+/*****************************   perfStart   ****************************
+ * void perfStart(PerfCounters *pc)
+ *
+ * Description: Opens and starts the counters for the calling thread.
+ * While instrumentation is off only the wall clock is started.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * pc            out         ptr to PerfCounters structure, see define.h.
+ *
+ * NOTES:
+ * - Must be matched by perfStop on the same thread.
+ ***********************************************************************/
+void perfStart(PerfCounters *pc)
+{
+    int i;
+    for (i = 0; i < PERF_EVENTS; i++)
+        pc->fd[i] = -1;
+    pc->taskFd = NULL;
+    pc->numTasks = 0;
+#ifdef __linux__
+    if (perfOut != NULL)
+        openCounters(pc->fd, 0, FALSE);
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &pc->start);
+}
+
+/**************************   perfStartProcess   ************************
+ * void perfStartProcess(PerfCounters *pc)
+ *
+ * Description: Like perfStart, but counts every thread of the process,
+ * for measurements reported with thread -1.
+ *
+ * Process:
+ * 1.) Open the calling thread's counters with inherit, which also
+ *     counts the threads it creates during the measurement.
+ * 2.) Open counters for every other thread in /proc/self/task, e.g.
+ *     OpenMP pool threads left over from earlier parallel regions.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * pc            out         ptr to PerfCounters structure, see define.h.
+ *
+ * NOTES:
+ * - Must be matched by perfStop on the same thread.
+ * - Threads created by threads other than the caller after the start
+ *   are only counted if their creator is.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void perfStartProcess(PerfCounters *pc)
+{
+#ifdef __linux__
+    DIR *dir;
+    struct dirent *entry;
+    pid_t self;
+    pid_t tid;
+    int cap = 0;
+#endif
+    int i;
+    for (i = 0; i < PERF_EVENTS; i++)
+        pc->fd[i] = -1;
+    pc->taskFd = NULL;
+    pc->numTasks = 0;
+#ifdef __linux__
+    if (perfOut != NULL)
+    {
+        openCounters(pc->fd, 0, TRUE);
+        self = (pid_t) syscall(SYS_gettid);
+        dir = opendir("/proc/self/task");
+        while (dir != NULL && (entry = readdir(dir)) != NULL)
+        {
+            tid = (pid_t) atoi(entry->d_name);
+            if (tid <= 0 || tid == self)
+                continue;
+            if (pc->numTasks == cap)
+            {
+                cap = cap ? cap * 2 : 16;
+                pc->taskFd = realloc(pc->taskFd,
+                                     sizeof(int) * PERF_EVENTS * cap);
+                if (pc->taskFd == NULL)
+                {
+                    printf("Error: no memory for array\n");
+                    exit(ARRAY_MEMORY_ERROR);
+                }
+            }
+            openCounters(pc->taskFd + pc->numTasks * PERF_EVENTS, tid,
+                         TRUE);
+            pc->numTasks++;
+        }
+        if (dir != NULL)
+            closedir(dir);
+    }
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &pc->start);
+}
+
+/*****************************   perfStop   *****************************
+ * void perfStop(PerfCounters *pc)
+ *
+ * Description: Stops the counters, reads their values and closes them.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * pc            in/out      ptr to PerfCounters started by perfStart
+ *                           or perfStartProcess.
+ *                           value[i] is -1 for unavailable counters.
+ ***********************************************************************/
+void perfStop(PerfCounters *pc)
+{
+    struct timespec end;
+#ifdef __linux__
+    long long value;
+    int t;
+#endif
+    int i;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pc->wallNs = (end.tv_sec - pc->start.tv_sec) * 1000000000LL +
+                 (end.tv_nsec - pc->start.tv_nsec);
+    for (i = 0; i < PERF_EVENTS; i++)
+    {
+        pc->value[i] = -1;
+#ifdef __linux__
+        pc->value[i] = readCounter(pc->fd[i]);
+        // Other threads' counts add to the caller's, a thread that
+        // refused a counter the caller got is left out
+        for (t = 0; t < pc->numTasks; t++)
+        {
+            value = readCounter(pc->taskFd[t * PERF_EVENTS + i]);
+            if (pc->value[i] >= 0 && value >= 0)
+                pc->value[i] += value;
+        }
+#endif
+    }
+    free(pc->taskFd);
+    pc->taskFd = NULL;
+    pc->numTasks = 0;
+}
+
+/*****************************   perfReport   ***************************
+ * void perfReport(const char *phase, int thread, PerfCounters *pc)
+ *
+ * Description: Writes one measurement as a JSON line, e.g.
+ * {"phase":"multiply","thread":-1,"wall_ns":1200,"cycles":null,...}
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * phase         in          Name of what was measured.
+ * thread        in          Thread number, -1 for the whole process.
+ * pc            in          ptr to PerfCounters filled by perfStop.
+ *
+ * NOTES:
+ * - Does nothing while instrumentation is off.
+ * - The line is written with a single call so lines from different
+ *   threads do not interleave.
+ ***********************************************************************/
+void perfReport(const char *phase, int thread, PerfCounters *pc)
+{
+    char line[512];
+    int len;
+    int i;
+    if (perfOut == NULL)
+        return;
+    len = snprintf(line, sizeof(line),
+                   "{\"phase\":\"%s\",\"thread\":%d,\"wall_ns\":%lld",
+                   phase, thread, pc->wallNs);
+    for (i = 0; i < PERF_EVENTS; i++)
+    {
+        if (pc->value[i] < 0)
+            len += snprintf(line + len, sizeof(line) - len, ",\"%s\":null",
+                            perfNames[i]);
+        else
+            len += snprintf(line + len, sizeof(line) - len, ",\"%s\":%lld",
+                            perfNames[i], pc->value[i]);
+    }
+    snprintf(line + len, sizeof(line) - len, "}\n");
+    fputs(line, perfOut);
+}
@@ -1,4 +1,5 @@
 #include "define.h"
+#include <string.h>
 
 /***********************************************************************
  * 2DArray.c written by DSU_410 team ...
@@ -13,6 +14,8 @@
  * - fill2DRandom2D
  * - print2D
  * - free2D
+ * - save2D
+ * - load2D
  *
  * compile: Used with main.c, not meant to be independently executable
  *
@@ -21,7 +24,7 @@
  ************************************************************************/
 
 /*****************************   setUp2D   ******************************
- * void setUp2D(Matrix *a, int bFillRand)
+ * void setUp2D(Matrix *a, int numRows, int numCols, int bFillRand)
  *
  * Description: Assigns values to Matrix structure, allocates memory
  * for it, and assigns random values to it.
@@ -36,14 +39,18 @@
  * a             in/out      ptr to Matrix structure, see define.h.
  *                           Assigns values to a->rows and a->cols and stores
  *                           reference to dynamic 2D array.
+ * numRows       in          Total number of rows in 2D array
+ * numCols       in          Total number of columns in 2D array
  * bFillRand     in          Boolean used to determine values for array
  *
  * NOTES:
  * - Assumes numRows and numCols are accurate and viable.
  * - Failure of memory allocation aborts program.
  ***********************************************************************/
-void setUp2D(Matrix *a, int bFillRand)
+void setUp2D(Matrix *a, int numRows, int numCols, int bFillRand)
 {
+    a->rows = numRows;
+    a->cols = numCols;
     allocate2D(a);
     if (bFillRand)
     {
@@ -59,11 +66,12 @@ void setUp2D(Matrix *a, int bFillRand)
  * void allocate2D(Matrix *a)
  *
  * Description: Dynamically allocates memory for Matrix structure's 2D
- * array.  
+ * array. The array of row pointers and all rows share one block, from
+ * the arena selected with setArena2D if there is one.
  *
  * Process:
- * 1.) Allocate memory for array of pointers.
- * 2.) Allocate memory for every of integers, pointed to by above.
+ * 1.) Allocate one block for the pointers followed by the integers.
+ * 2.) Point every row pointer at its row inside the block.
  *
  * Parameter     Direction   Description
  * ---------------------------------------------------------------------
@@ -77,24 +85,17 @@ void setUp2D(Matrix *a, int bFillRand)
 void allocate2D(Matrix *a)
 {
     int i;
-    // Allocate memory for array of pointers
-    a->m = malloc(sizeof(int *) * (a->rows));
-    if (a->m == NULL)
-    {
-        printf("Error: no memory for array\n");
-        exit(ARRAY_MEMORY_ERROR);
-    }
-    // Allocate memory for each array of integers pointed to by
-    // array of pointers from above
+    int *data;
+    // Row pointers first, rounded up so the integers start aligned.
+    // Room for max(rows, cols) of them, so transposeInPlace can point
+    // at the rows of the transpose.
+    size_t ptrBytes = (sizeof(int *) * (a->rows > a->cols ? a->rows
+                                                          : a->cols) +
+                       ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    a->m = allocScratch(ptrBytes + sizeof(int) * a->rows * a->cols);
+    data = (int *) ((char *) a->m + ptrBytes);
     for (i = 0; i < a->rows; i++)
-    {
-        a->m[i] = malloc(sizeof(int) * (a->cols));
-        if (a->m[i] == NULL)
-        {
-            printf("Error: no memory for array\n");
-            exit(ARRAY_MEMORY_ERROR);
-        }
-    }
+        a->m[i] = data + (size_t) i * a->cols;
 }
 
 /*****************************  fillRandom2D  *****************************
@@ -190,8 +191,8 @@ void print2D(Matrix *a)
  * Frees the 2D array within matrix.
  *
  * Process:
- * 1.) Free each array pointed to by a->m
- * 2.) Free array of pointers a->m
+ * 1.) Free the block holding a->m and the rows, returning it to its
+ *     arena if it came from one.
  *
  * Parameter     Direction   Description
  * ---------------------------------------------------------------------
@@ -199,13 +200,86 @@ void print2D(Matrix *a)
  *                           memory is freed.
  *
  * NOTES:
- * - Assumes matrix has been allocated and values of a->rows and a->cols
- *   are accurate and viable.
+ * - Assumes matrix has been allocated by allocate2D.
  ***********************************************************************/
 void free2D(Matrix *a)
 {
+    freeScratch(a->m);  // frees a->m and the rows after it
+}
+
+/****************************   save2D   ********************************
+ * int save2D(Matrix *a, const char *path)
+ *
+ * Description: Writes a matrix in the binary format read by load2D: the
+ * MATRIX_MAGIC bytes, rows and cols as ints, then the values row by
+ * row, all in native byte order.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          Matrix structure, see define.h.
+ * path          in          File to write.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          File written.
+ * FALSE         File could not be opened or written.
+ ***********************************************************************/
+int save2D(Matrix *a, const char *path)
+{
+    FILE *fp = fopen(path, "wb");
+    int bVal;
     int i;
-    for (i = 0; i < a->rows; i++)
-        free(a->m[i]);   // frees each array pointed at by a->m
-    free(a->m);          // frees a->m, array of pointers
-}
\ No newline at end of file
+    if (fp == NULL)
+        return FALSE;
+    bVal = fwrite(MATRIX_MAGIC, 1, 4, fp) == 4 &&
+           fwrite(&a->rows, sizeof(int), 1, fp) == 1 &&
+           fwrite(&a->cols, sizeof(int), 1, fp) == 1;
+    for (i = 0; i < a->rows && bVal; i++)
+        bVal = fwrite(a->m[i], sizeof(int), a->cols, fp) ==
+               (size_t) a->cols;
+    return fclose(fp) == 0 && bVal;
+}
+
+/****************************   load2D   ********************************
+ * int load2D(Matrix *a, const char *path)
+ *
+ * Description: Reads a matrix written by save2D into newly allocated
+ * memory.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             out         Matrix structure, see define.h. Allocated
+ *                           with allocate2D, release with free2D.
+ * path          in          File to read.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Matrix loaded.
+ * FALSE         Missing, short or not a matrix file. Nothing is left
+ *               allocated.
+ ***********************************************************************/
+int load2D(Matrix *a, const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    char magic[4];
+    int bVal;
+    int i;
+    if (fp == NULL)
+        return FALSE;
+    bVal = fread(magic, 1, 4, fp) == 4 &&
+           memcmp(magic, MATRIX_MAGIC, 4) == 0 &&
+           fread(&a->rows, sizeof(int), 1, fp) == 1 &&
+           fread(&a->cols, sizeof(int), 1, fp) == 1 &&
+           a->rows > 0 && a->cols > 0;
+    if (bVal)
+    {
+        allocate2D(a);
+        for (i = 0; i < a->rows && bVal; i++)
+            bVal = fread(a->m[i], sizeof(int), a->cols, fp) ==
+                   (size_t) a->cols;
+        if (!bVal)
+            free2D(a);
+    }
+    fclose(fp);
+    return bVal;
+}
@@ -0,0 +1,553 @@
+#include "define.h"
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT      26   // log2 page size goes in the top flag bits
+#endif
+
+/***********************************************************************
+ * arena.c written by DSU_410 team ...
+ *
+ * Description: Arena allocator for Matrix buffers and temporaries.
+ * Memory comes from a few large, aligned regions mapped straight from
+ * the OS, optionally on huge pages: explicit 2 MB / 1 GB hugetlb pages,
+ * or transparent huge pages on 2 MB aligned regions. Large matrices on
+ * huge pages need far fewer TLB entries, e.g. 8 instead of 4096 for a
+ * 16 MB matrix with 2 MB pages. Blocks are handed out by
+ * bumping a pointer. Freed blocks go onto a free list per power-of-two
+ * size class and are reused by later requests of the same class. A
+ * scope can be rolled back in one step with arenaMark/arenaReset.
+ *
+ * Once regions have been mapped, loops that allocate and free the same
+ * shapes over and over (chains, powers, recursive splits) make no
+ * system allocations at all. regionsMapped counts the mappings so this
+ * can be checked.
+ *
+ * While an arena is selected with setArena2D, allocate2D/free2D and
+ * allocScratch/freeScratch on that thread route through it.
+ *
+ * Functions:
+ * - arenaInit
+ * - arenaDestroy
+ * - arenaAlloc
+ * - arenaFree
+ * - arenaMark
+ * - arenaReset
+ * - arenaReport
+ * - setArena2D
+ * - getArena2D
+ * - allocScratch
+ * - freeScratch
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// Bookkeeping in front of every block, payload starts ARENA_ALIGN later
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;    // free list link
+    int sizeClass;              // block is ARENA_ALIGN << sizeClass bytes
+    int region;                 // index of region holding the block
+    MatrixArena *owner;         // arena the block came from, NULL for
+                                // blocks from the C library
+} ArenaBlock;
+
+// Arena selected on this thread, see setArena2D
+static __thread MatrixArena *currentArena = NULL;
+
+/*****************************   mapHuge   ******************************
+ * static void *mapHuge(size_t *size, int mode, int *backing)
+ *
+ * Description: Maps *size bytes backed as close to mode as the system
+ * allows.
+ *
+ * Process:
+ * 1.) ARENA_HUGE_1GB / ARENA_HUGE_2MB: try MAP_HUGETLB with that page
+ *     size, the size rounded up to whole pages. This needs pages
+ *     reserved in the hugetlb pool (vm.nr_hugepages). Without them try
+ *     the next smaller mode.
+ * 2.) ARENA_HUGE_THP: map HUGE_PAGE_SIZE extra, unmap the ends so the
+ *     region starts and ends on 2 MB boundaries, and madvise it for
+ *     transparent huge pages. Whether the kernel then backs it with
+ *     huge pages is only known after it is touched, see arenaReport.
+ * 3.) ARENA_HUGE_NONE: plain mapping.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * size          in/out      Bytes wanted, rounded up to the page size
+ *                           actually used.
+ * mode          in          ARENA_HUGE_* asked for.
+ * backing       out         ARENA_HUGE_* obtained.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * ptr           Start of the mapping, MAP_FAILED if even a plain
+ *               mapping failed.
+ ***********************************************************************/
+static void *mapHuge(size_t *size, int mode, int *backing)
+{
+    size_t bytes;
+    char *p = MAP_FAILED;
+    char *start;
+#ifdef MAP_HUGETLB
+    size_t page;
+    int flag;
+    for (; mode >= ARENA_HUGE_2MB; mode--)
+    {
+        page = mode == ARENA_HUGE_1GB ? HUGE_PAGE_SIZE_1GB : HUGE_PAGE_SIZE;
+        flag = (mode == ARENA_HUGE_1GB ? 30 : 21) << MAP_HUGE_SHIFT;
+        bytes = (*size + page - 1) / page * page;
+        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | flag, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            *size = bytes;
+            *backing = mode;
+            return p;
+        }
+    }
+#else
+    if (mode > ARENA_HUGE_THP)
+        mode = ARENA_HUGE_THP;
+#endif
+    if (mode == ARENA_HUGE_THP)
+    {
+        bytes = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        p = mmap(NULL, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return p;
+        start = (char *) (((uintptr_t) p + HUGE_PAGE_SIZE - 1) &
+                          ~(uintptr_t) (HUGE_PAGE_SIZE - 1));
+        if (start > p)
+            munmap(p, start - p);
+        munmap(start + bytes, p + HUGE_PAGE_SIZE - start);
+#ifdef MADV_HUGEPAGE
+        madvise(start, bytes, MADV_HUGEPAGE);
+#endif
+        *size = bytes;
+        *backing = ARENA_HUGE_THP;
+        return start;
+    }
+    *backing = ARENA_HUGE_NONE;
+    return mmap(NULL, *size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+}
+
+/*****************************   prefault   *****************************
+ * static void prefault(char *p, size_t size, int backing)
+ *
+ * Description: Touches every page of a new region, in parallel, so the
+ * page faults (and zeroing) happen here and not inside the first
+ * multiply. Each thread first touches its own share of the pages,
+ * which also spreads them over the NUMA nodes the threads run on.
+ ***********************************************************************/
+static void prefault(char *p, size_t size, int backing)
+{
+    long step = backing == ARENA_HUGE_1GB ? (long) HUGE_PAGE_SIZE_1GB
+              : backing == ARENA_HUGE_2MB ? (long) HUGE_PAGE_SIZE : 4096;
+    long numPages = (long) (size / step);
+    long i;
+    #pragma omp parallel for schedule(static)
+    for (i = 0; i < numPages; i++)
+        p[i * step] = 0;
+}
+
+/****************************   mapRegion   *****************************
+ * static int mapRegion(MatrixArena *ar, size_t need)
+ *
+ * Description: Maps a new region of at least need bytes and appends it
+ * to the arena's region list.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            in/out      ptr to MatrixArena structure.
+ * need          in          bytes the new region must hold.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * index         Index of the new region.
+ *
+ * NOTES:
+ * - Aborts program if the mapping fails.
+ ***********************************************************************/
+static int mapRegion(MatrixArena *ar, size_t need)
+{
+    size_t size = need > ar->regionSize ? need : ar->regionSize;
+    void *p;
+    int backing;
+    if (ar->numRegions == ar->capRegions)
+    {
+        ar->capRegions = ar->capRegions ? ar->capRegions * 2 : 8;
+        ar->base = realloc(ar->base, sizeof(char *) * ar->capRegions);
+        ar->size = realloc(ar->size, sizeof(size_t) * ar->capRegions);
+        ar->backing = realloc(ar->backing, sizeof(int) * ar->capRegions);
+        if (ar->base == NULL || ar->size == NULL || ar->backing == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
+    }
+    p = mapHuge(&size, ar->hugeMode & ARENA_HUGE_MASK, &backing);
+    if (p == MAP_FAILED)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    if (ar->hugeMode & ARENA_PREFAULT)
+        prefault(p, size, backing);
+    ar->base[ar->numRegions] = p;
+    ar->size[ar->numRegions] = size;
+    ar->backing[ar->numRegions] = backing;
+    ar->regionsMapped++;
+    return ar->numRegions++;
+}
+
+/*****************************   arenaInit   ****************************
+ * void arenaInit(MatrixArena *ar, size_t regionSize, int hugeMode)
+ *
+ * Description: Sets up an empty arena. No memory is mapped until the
+ * first allocation.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            out         ptr to MatrixArena structure, see define.h.
+ * regionSize    in          bytes mapped at a time, 0 for
+ *                           ARENA_REGION_SIZE.
+ * hugeMode      in          Page backing, ARENA_HUGE_NONE (FALSE),
+ *                           ARENA_HUGE_THP (TRUE), ARENA_HUGE_2MB or
+ *                           ARENA_HUGE_1GB, optionally | ARENA_PREFAULT
+ *                           to touch new regions in parallel.
+ *
+ * NOTES:
+ * - Explicit huge pages fall back to smaller ones, down to THP, when
+ *   the system has none free. arenaReport shows what was obtained.
+ ***********************************************************************/
+void arenaInit(MatrixArena *ar, size_t regionSize, int hugeMode)
+{
+    memset(ar, 0, sizeof(MatrixArena));
+    ar->regionSize = regionSize ? regionSize : ARENA_REGION_SIZE;
+    ar->hugeMode = hugeMode;
+    ar->current = -1;
+}
+
+/****************************   arenaDestroy   **************************
+ * void arenaDestroy(MatrixArena *ar)
+ *
+ * Description: Returns every region to the OS. All blocks handed out
+ * by the arena become invalid.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            in/out      ptr to MatrixArena structure, see define.h.
+ ***********************************************************************/
+void arenaDestroy(MatrixArena *ar)
+{
+    int i;
+    for (i = 0; i < ar->numRegions; i++)
+        munmap(ar->base[i], ar->size[i]);
+    free(ar->base);
+    free(ar->size);
+    free(ar->backing);
+    if (currentArena == ar)
+        currentArena = NULL;
+    arenaInit(ar, ar->regionSize, ar->hugeMode);
+}
+
+/*****************************   arenaAlloc   ***************************
+ * void *arenaAlloc(MatrixArena *ar, size_t bytes)
+ *
+ * Description: Returns an ARENA_ALIGN aligned block of at least bytes.
+ *
+ * Process:
+ * 1.) Round the request, plus its header, up to a size class.
+ * 2.) Reuse a block from that class's free list if there is one.
+ * 3.) Otherwise bump allocate from the current region, moving on to
+ *     the next region (mapping one if needed) when it is full.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            in/out      ptr to MatrixArena structure, see define.h.
+ * bytes         in          Size of the block wanted.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * ptr           Start of the block.
+ *
+ * NOTES:
+ * - Not thread safe, use one arena per thread.
+ * - Aborts program if memory cannot be mapped.
+ ***********************************************************************/
+void *arenaAlloc(MatrixArena *ar, size_t bytes)
+{
+    ArenaBlock *blk;
+    size_t blockSize = ARENA_ALIGN;
+    int sizeClass = 0;
+    while (blockSize < bytes + ARENA_ALIGN)
+    {
+        blockSize <<= 1;
+        sizeClass++;
+    }
+    blk = ar->freeList[sizeClass];
+    if (blk != NULL)
+    {
+        ar->freeList[sizeClass] = blk->next;
+        return (char *) blk + ARENA_ALIGN;
+    }
+    while (ar->current < 0 || ar->used + blockSize > ar->size[ar->current])
+    {
+        // Regions past current are empty, either never used or rolled
+        // back by arenaReset
+        if (ar->current + 1 < ar->numRegions)
+            ar->current++;
+        else
+            ar->current = mapRegion(ar, blockSize);
+        ar->used = 0;
+    }
+    blk = (ArenaBlock *) (ar->base[ar->current] + ar->used);
+    blk->sizeClass = sizeClass;
+    blk->region = ar->current;
+    blk->owner = ar;
+    ar->used += blockSize;
+    return (char *) blk + ARENA_ALIGN;
+}
+
+/*****************************   arenaFree   ****************************
+ * void arenaFree(MatrixArena *ar, void *p)
+ *
+ * Description: Gives a block back to its size class for reuse.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            in/out      ptr to MatrixArena the block came from.
+ * p             in          Block returned by arenaAlloc, or NULL.
+ ***********************************************************************/
+void arenaFree(MatrixArena *ar, void *p)
+{
+    ArenaBlock *blk;
+    if (p == NULL)
+        return;
+    blk = (ArenaBlock *) ((char *) p - ARENA_ALIGN);
+    blk->next = ar->freeList[blk->sizeClass];
+    ar->freeList[blk->sizeClass] = blk;
+}
+
+/*****************************   arenaMark   ****************************
+ * ArenaMark arenaMark(MatrixArena *ar)
+ *
+ * Description: Records the arena's bump position so everything
+ * allocated after it can be released at once with arenaReset.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            in          ptr to MatrixArena structure, see define.h.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * mark          Position to pass to arenaReset.
+ ***********************************************************************/
+ArenaMark arenaMark(MatrixArena *ar)
+{
+    ArenaMark mark;
+    mark.region = ar->current;
+    mark.used = ar->used;
+    return mark;
+}
+
+/*****************************   arenaReset   ***************************
+ * void arenaReset(MatrixArena *ar, ArenaMark mark)
+ *
+ * Description: Releases every block bump allocated after mark. The
+ * regions stay mapped and are reused by later allocations.
+ *
+ * Process:
+ * 1.) Drop free list entries that lie past the mark.
+ * 2.) Move the bump position back to the mark.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            in/out      ptr to MatrixArena structure, see define.h.
+ * mark          in          Position from arenaMark.
+ *
+ * NOTES:
+ * - Blocks from before the mark, free or in use, are not affected.
+ ***********************************************************************/
+void arenaReset(MatrixArena *ar, ArenaMark mark)
+{
+    ArenaBlock **link;
+    ArenaBlock *blk;
+    size_t offset;
+    int c;
+    for (c = 0; c < ARENA_CLASSES; c++)
+    {
+        link = (ArenaBlock **) &ar->freeList[c];
+        while (*link != NULL)
+        {
+            blk = *link;
+            offset = (char *) blk - ar->base[blk->region];
+            if (blk->region > mark.region ||
+                (blk->region == mark.region && offset >= mark.used))
+                *link = blk->next;
+            else
+                link = &blk->next;
+        }
+    }
+    ar->current = mark.region;
+    ar->used = mark.used;
+}
+
+/*****************************   hugeBytes   ****************************
+ * static size_t hugeBytes(char *base, size_t size)
+ *
+ * Description: Returns the bytes of [base, base + size) the kernel has
+ * backed with transparent huge pages, the AnonHugePages lines of the
+ * mappings inside that range in /proc/self/smaps. 0 if it cannot be
+ * read.
+ ***********************************************************************/
+static size_t hugeBytes(char *base, size_t size)
+{
+    FILE *fp = fopen("/proc/self/smaps", "r");
+    char line[256];
+    unsigned long start;
+    unsigned long end;
+    unsigned long kb;
+    size_t total = 0;
+    int bInside = FALSE;
+    if (fp == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+            bInside = start >= (uintptr_t) base &&
+                      end <= (uintptr_t) base + size;
+        else if (bInside && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1)
+            total += (size_t) kb << 10;
+    }
+    fclose(fp);
+    return total;
+}
+
+/*****************************   arenaReport   **************************
+ * void arenaReport(MatrixArena *ar, FILE *fp)
+ *
+ * Description: Writes one JSON line per region: its size, the backing
+ * asked for and obtained, and how many bytes are on huge pages. For
+ * hugetlb regions that is the whole region. For the others it is what
+ * the kernel reports in /proc/self/smaps, so it only counts pages that
+ * have been touched.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            in          ptr to MatrixArena structure, see define.h.
+ * fp            in          Stream written to, e.g. stderr.
+ ***********************************************************************/
+void arenaReport(MatrixArena *ar, FILE *fp)
+{
+    static const char *names[] = {"none", "thp", "2mb", "1gb"};
+    int i;
+    for (i = 0; i < ar->numRegions; i++)
+        fprintf(fp, "{\"region\":%d,\"bytes\":%zu,\"requested\":\"%s\","
+                "\"backing\":\"%s\",\"huge_bytes\":%zu}\n", i, ar->size[i],
+                names[ar->hugeMode & ARENA_HUGE_MASK],
+                names[ar->backing[i]],
+                ar->backing[i] >= ARENA_HUGE_2MB
+                    ? ar->size[i] : hugeBytes(ar->base[i], ar->size[i]));
+}
+
+/*****************************   setArena2D   ***************************
+ * MatrixArena *setArena2D(MatrixArena *ar)
+ *
+ * Description: Selects the arena allocate2D and allocScratch use on the
+ * calling thread. NULL goes back to malloc.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * ar            in          ptr to MatrixArena structure, or NULL.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * ptr           The previously selected arena, for restoring it.
+ ***********************************************************************/
+MatrixArena *setArena2D(MatrixArena *ar)
+{
+    MatrixArena *old = currentArena;
+    currentArena = ar;
+    return old;
+}
+
+/*****************************   getArena2D   ***************************
+ * MatrixArena *getArena2D(void)
+ *
+ * Description: Returns the arena selected on the calling thread.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * ptr           Selected arena, NULL when malloc is used.
+ ***********************************************************************/
+MatrixArena *getArena2D(void)
+{
+    return currentArena;
+}
+
+/****************************   allocScratch   **************************
+ * void *allocScratch(size_t bytes)
+ *
+ * Description: Allocates a buffer from the selected arena, or from the
+ * C library when none is selected. Every block remembers where it came
+ * from so freeScratch works either way.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * bytes         in          Size of the buffer wanted.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * ptr           ARENA_ALIGN aligned buffer.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void *allocScratch(size_t bytes)
+{
+    void *p;
+    ArenaBlock *blk;
+    if (currentArena != NULL)
+        return arenaAlloc(currentArena, bytes);
+    if (posix_memalign(&p, ARENA_ALIGN, bytes + ARENA_ALIGN) != 0)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    blk = p;
+    blk->owner = NULL;
+    return (char *) blk + ARENA_ALIGN;
+}
+
+/****************************   freeScratch   ***************************
+ * void freeScratch(void *p)
+ *
+ * Description: Releases a buffer from allocScratch.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * p             in          Buffer from allocScratch, or NULL.
+ *
+ * NOTES:
+ * - Arena blocks go back to the arena they came from, whichever arena
+ *   is selected now.
+ ***********************************************************************/
+void freeScratch(void *p)
+{
+    ArenaBlock *blk;
+    if (p == NULL)
+        return;
+    blk = (ArenaBlock *) ((char *) p - ARENA_ALIGN);
+    if (blk->owner == NULL)
+        free(blk);
+    else
+        arenaFree(blk->owner, p);
+}
@@ -0,0 +1,345 @@
+#include "define.h"
+#include <pthread.h>
+
+/***********************************************************************
+ * async.c written by DSU_410 team ...
+ *
+ * Description: Non-blocking multiplies. multiplyAsync queues a product
+ * on a shared executor and returns a MatrixTask handle straight away.
+ * The caller can do other work, queue more products, and collect the
+ * result later with taskWait. An optional callback runs as soon as the
+ * product is finished, on whichever thread ran it.
+ *
+ * A task may list other tasks it depends on. It is not started until
+ * they have all finished, so C = A*B followed by D = C*E can be queued
+ * back to back without waiting in between. If a dependency fails, the
+ * task fails too, without running.
+ *
+ * taskWait helps rather than sleeps: while its task is unfinished, the
+ * waiting thread runs other ready tasks itself.
+ *
+ * The executor has ASYNC_WORKERS threads, started on first use. Each
+ * task runs the ordinary multiply, so it uses the OpenMP team of the
+ * thread running it.
+ *
+ * Functions:
+ * - multiplyAsync
+ * - taskDone
+ * - taskWait
+ * - taskFree
+ * - asyncShutdown
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// A task waiting for another to finish
+typedef struct TaskLink
+{
+    MatrixTask *task;
+    struct TaskLink *next;
+} TaskLink;
+
+static pthread_mutex_t execLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t execCond = PTHREAD_COND_INITIALIZER;
+static MatrixTask *readyHead = NULL;    // tasks with no unfinished deps
+static MatrixTask *readyTail = NULL;
+static pthread_t workers[ASYNC_WORKERS];
+static int numWorkers = 0;
+static int bStopping = FALSE;           // set until the join is done
+static __thread int bOnWorker = FALSE;  // this thread is an executor
+
+/*****************************   pushReady   ****************************
+ * static void pushReady(MatrixTask *t)
+ *
+ * Description: Appends t to the ready queue. Caller holds execLock.
+ ***********************************************************************/
+static void pushReady(MatrixTask *t)
+{
+    t->next = NULL;
+    if (readyTail == NULL)
+        readyHead = t;
+    else
+        readyTail->next = t;
+    readyTail = t;
+}
+
+/*****************************   popReady   *****************************
+ * static MatrixTask *popReady(void)
+ *
+ * Description: Takes the oldest ready task, or NULL. Caller holds
+ * execLock.
+ ***********************************************************************/
+static MatrixTask *popReady(void)
+{
+    MatrixTask *t = readyHead;
+    if (t != NULL)
+    {
+        readyHead = t->next;
+        if (readyHead == NULL)
+            readyTail = NULL;
+        t->state = TASK_RUNNING;
+    }
+    return t;
+}
+
+/******************************   runTask   *****************************
+ * static void runTask(MatrixTask *t)
+ *
+ * Description: Runs a task taken from the ready queue, called without
+ * execLock.
+ *
+ * Process:
+ * 1.) Multiply, unless a dependency failed.
+ * 2.) Run the callback.
+ * 3.) Mark the task done and release the tasks waiting on it. Those
+ *     whose last dependency this was become ready.
+ ***********************************************************************/
+static void runTask(MatrixTask *t)
+{
+    TaskLink *link;
+    TaskLink *next;
+    if (!t->bDepFailed)
+        t->result = multiply(t->a, t->b, t->c);
+    if (t->callback != NULL)
+        t->callback(t, t->arg);
+    pthread_mutex_lock(&execLock);
+    t->state = TASK_DONE;
+    for (link = t->dependents; link != NULL; link = next)
+    {
+        next = link->next;
+        if (!t->result)
+            link->task->bDepFailed = TRUE;
+        if (--link->task->numDeps == 0)
+            pushReady(link->task);
+        free(link);
+    }
+    t->dependents = NULL;
+    pthread_cond_broadcast(&execCond);
+    pthread_mutex_unlock(&execLock);
+}
+
+/****************************   workerLoop   ****************************
+ * static void *workerLoop(void *arg)
+ *
+ * Description: Executor thread, runs ready tasks until asyncShutdown.
+ ***********************************************************************/
+static void *workerLoop(void *arg)
+{
+    MatrixTask *t;
+    (void) arg;
+    bOnWorker = TRUE;
+    pthread_mutex_lock(&execLock);
+    for (;;)
+    {
+        t = popReady();
+        if (t != NULL)
+        {
+            pthread_mutex_unlock(&execLock);
+            runTask(t);
+            pthread_mutex_lock(&execLock);
+        }
+        else if (bStopping)
+            break;
+        else
+            pthread_cond_wait(&execCond, &execLock);
+    }
+    pthread_mutex_unlock(&execLock);
+    return NULL;
+}
+
+/****************************   multiplyAsync   *************************
+ * MatrixTask *multiplyAsync(Matrix *a, Matrix *b, Matrix *c,
+ *                           MatrixTask **deps, int numDeps,
+ *                           TaskCallback callback, void *arg)
+ *
+ * Description: Queues c += a*b and returns without waiting for it.
+ *
+ * Process:
+ * 1.) Wait out an asyncShutdown in progress, then start the executor
+ *     if it is not running. A callback on an executor thread does not
+ *     wait, since its own thread is being joined; the task joins the
+ *     queue the shutdown is draining.
+ * 2.) Register the task with every unfinished dependency, or make it
+ *     ready straight away if there are none.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a, b          in          Operands, must stay valid until the task
+ *                           is done. May be outputs of deps.
+ * c             in/out      Result, as for multiply.
+ * deps          in          Tasks that must finish first, or NULL.
+ * numDeps       in          Number of entries in deps.
+ * callback      in          Called when the product is finished, with
+ *                           the task and arg, or NULL.
+ * arg           in          Passed to callback.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * task          Handle for taskDone, taskWait and taskFree.
+ *
+ * NOTES:
+ * - Dependencies must not be freed before this task is queued.
+ * - The callback runs before taskWait on the task returns. It must not
+ *   wait on its own task.
+ ***********************************************************************/
+MatrixTask *multiplyAsync(Matrix *a, Matrix *b, Matrix *c,
+                          MatrixTask **deps, int numDeps,
+                          TaskCallback callback, void *arg)
+{
+    MatrixTask *t = calloc(1, sizeof(MatrixTask));
+    TaskLink *link;
+    int i;
+    if (t == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    t->a = a;
+    t->b = b;
+    t->c = c;
+    t->callback = callback;
+    t->arg = arg;
+    t->result = FALSE;
+    t->state = TASK_WAITING;
+    pthread_mutex_lock(&execLock);
+    while (bStopping && !bOnWorker)
+        pthread_cond_wait(&execCond, &execLock);
+    while (!bStopping && numWorkers < ASYNC_WORKERS &&
+           pthread_create(&workers[numWorkers], NULL, workerLoop,
+                          NULL) == 0)
+        numWorkers++;
+    for (i = 0; i < numDeps; i++)
+    {
+        if (deps[i]->state == TASK_DONE)
+        {
+            t->bDepFailed |= !deps[i]->result;
+            continue;
+        }
+        link = malloc(sizeof(TaskLink));
+        if (link == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
+        link->task = t;
+        link->next = deps[i]->dependents;
+        deps[i]->dependents = link;
+        t->numDeps++;
+    }
+    if (t->numDeps == 0)
+    {
+        pushReady(t);
+        pthread_cond_broadcast(&execCond);
+    }
+    pthread_mutex_unlock(&execLock);
+    return t;
+}
+
+/******************************   taskDone   ****************************
+ * int taskDone(MatrixTask *t)
+ *
+ * Description: Polls a task without waiting.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Finished, taskWait will return at once.
+ * FALSE         Still waiting or running.
+ ***********************************************************************/
+int taskDone(MatrixTask *t)
+{
+    int bVal;
+    pthread_mutex_lock(&execLock);
+    bVal = t->state == TASK_DONE;
+    pthread_mutex_unlock(&execLock);
+    return bVal;
+}
+
+/******************************   taskWait   ****************************
+ * int taskWait(MatrixTask *t)
+ *
+ * Description: Waits for a task, running other ready tasks meanwhile.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * t             in          Handle from multiplyAsync.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Not performed, the product was undefined or a
+ *               dependency failed.
+ ***********************************************************************/
+int taskWait(MatrixTask *t)
+{
+    MatrixTask *other;
+    pthread_mutex_lock(&execLock);
+    while (t->state != TASK_DONE)
+    {
+        other = popReady();
+        if (other != NULL)
+        {
+            pthread_mutex_unlock(&execLock);
+            runTask(other);
+            pthread_mutex_lock(&execLock);
+        }
+        else
+            pthread_cond_wait(&execCond, &execLock);
+    }
+    pthread_mutex_unlock(&execLock);
+    return t->result;
+}
+
+/******************************   taskFree   ****************************
+ * void taskFree(MatrixTask *t)
+ *
+ * Description: Releases a handle. The task must be done, taskWait it
+ * first.
+ ***********************************************************************/
+void taskFree(MatrixTask *t)
+{
+    free(t);
+}
+
+/****************************   asyncShutdown   *************************
+ * void asyncShutdown(void)
+ *
+ * Description: Runs every queued task, then stops the executor threads.
+ * A later multiplyAsync starts them again.
+ *
+ * Process:
+ * 1.) If another shutdown is joining, wait for it and return.
+ * 2.) Set bStopping and join the executor threads. bStopping stays set
+ *     through the join, so multiplyAsync calls made meanwhile wait.
+ * 3.) Clear numWorkers and bStopping together and wake the waiters.
+ *
+ * NOTES:
+ * - Tasks whose dependencies are never finished are not run.
+ * - Must not be called from a task callback.
+ ***********************************************************************/
+void asyncShutdown(void)
+{
+    int n;
+    int i;
+    pthread_mutex_lock(&execLock);
+    if (bStopping)
+    {
+        while (bStopping)
+            pthread_cond_wait(&execCond, &execLock);
+        pthread_mutex_unlock(&execLock);
+        return;
+    }
+    bStopping = TRUE;
+    n = numWorkers;
+    pthread_cond_broadcast(&execCond);
+    pthread_mutex_unlock(&execLock);
+    for (i = 0; i < n; i++)
+        pthread_join(workers[i], NULL);
+    pthread_mutex_lock(&execLock);
+    numWorkers = 0;
+    bStopping = FALSE;
+    pthread_cond_broadcast(&execCond);
+    pthread_mutex_unlock(&execLock);
+}
@@ -0,0 +1,209 @@
+#include "define.h"
+#include <string.h>
+
+/***********************************************************************
+ * band.c written by DSU_410 team ...
+ *
+ * Description: Band matrices, where a(i, j) is zero unless
+ * i - lower <= j <= i + upper. Only the band is stored, row by row, in
+ * lower + upper + 1 slots per row (see BAND_AT), and the kernels only
+ * visit stored elements:
+ * - bandMultiply, band times dense, O(rows * width * cols of B).
+ * - bandBandMultiply, band times band, giving a band with the sums of
+ *   the bandwidths, O(rows * width of A * width of B).
+ * Both run in parallel over blocks of BAND_ROW_BLOCK rows of C.
+ *
+ * Functions:
+ * - bandInit
+ * - bandFromDense
+ * - bandToDense
+ * - bandFree
+ * - bandMultiply
+ * - bandBandMultiply
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/******************************   bandInit   ****************************
+ * void bandInit(BandMatrix *a, int numRows, int numCols, int lower,
+ *               int upper)
+ *
+ * Description: Allocates a zeroed band matrix.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             out         ptr to BandMatrix structure, see define.h.
+ * numRows       in          Rows.
+ * numCols       in          Columns.
+ * lower         in          Stored diagonals below the main one, >= 0.
+ * upper         in          Stored diagonals above the main one, >= 0.
+ *
+ * NOTES:
+ * - Slots of the band that fall outside the matrix (the corners) are
+ *   stored but always zero.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void bandInit(BandMatrix *a, int numRows, int numCols, int lower,
+              int upper)
+{
+    size_t bytes = sizeof(int) * (size_t) numRows * (lower + upper + 1);
+    a->rows = numRows;
+    a->cols = numCols;
+    a->lower = lower;
+    a->upper = upper;
+    a->data = allocScratch(bytes);
+    memset(a->data, 0, bytes);
+}
+
+/****************************   bandFromDense   *************************
+ * void bandFromDense(BandMatrix *a, Matrix *dense, int lower, int upper)
+ *
+ * Description: Allocates a band matrix holding the band of a dense
+ * one. Elements outside the band are ignored.
+ ***********************************************************************/
+void bandFromDense(BandMatrix *a, Matrix *dense, int lower, int upper)
+{
+    int i;
+    int j;
+    bandInit(a, dense->rows, dense->cols, lower, upper);
+    for (i = 0; i < a->rows; i++)
+        for (j = i - lower > 0 ? i - lower : 0;
+             j <= i + upper && j < a->cols; j++)
+            BAND_AT(a, i, j) = dense->m[i][j];
+}
+
+/*****************************   bandToDense   **************************
+ * void bandToDense(BandMatrix *a, Matrix *dense)
+ *
+ * Description: Writes a band matrix into an allocated dense matrix of
+ * the same shape, zeros outside the band.
+ ***********************************************************************/
+void bandToDense(BandMatrix *a, Matrix *dense)
+{
+    int i;
+    int j;
+    fillZeroes2D(dense);
+    for (i = 0; i < a->rows; i++)
+        for (j = i - a->lower > 0 ? i - a->lower : 0;
+             j <= i + a->upper && j < a->cols; j++)
+            dense->m[i][j] = BAND_AT(a, i, j);
+}
+
+/******************************   bandFree   ****************************
+ * void bandFree(BandMatrix *a)
+ *
+ * Description: Frees a band matrix's storage.
+ ***********************************************************************/
+void bandFree(BandMatrix *a)
+{
+    freeScratch(a->data);
+}
+
+/****************************   bandMultiply   **************************
+ * int bandMultiply(BandMatrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: C += A*B for band A and dense B.
+ *
+ * Process:
+ * 1.) Share row blocks of C amongst threads.
+ * 2.) Row i of C adds a(i, k) * row k of B for the k in A's band.
+ * 3.) With metrics on, the call is recorded under BACKEND_BAND.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to BandMatrix structure, see define.h.
+ * b             in          ptr to Matrix structure, a->cols rows.
+ * c             in/out      ptr to Matrix structure, a->rows by b->cols.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match.
+ ***********************************************************************/
+int bandMultiply(BandMatrix *a, Matrix *b, Matrix *c)
+{
+    long long start;
+    int numBlocks = (a->rows + BAND_ROW_BLOCK - 1) / BAND_ROW_BLOCK;
+    int *row;
+    int *bRow;
+    int aik;
+    int blk;
+    int i;
+    int j;
+    int k;
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    #pragma omp parallel for schedule(static) \
+        private(row, bRow, aik, i, j, k)
+    for (blk = 0; blk < numBlocks; blk++)
+        for (i = blk * BAND_ROW_BLOCK;
+             i < a->rows && i < (blk + 1) * BAND_ROW_BLOCK; i++)
+        {
+            row = c->m[i];
+            for (k = i - a->lower > 0 ? i - a->lower : 0;
+                 k <= i + a->upper && k < a->cols; k++)
+            {
+                aik = BAND_AT(a, i, k);
+                bRow = b->m[k];
+                for (j = 0; j < c->cols; j++)
+                    row[j] += aik * bRow[j];
+            }
+        }
+    if (start >= 0)
+        metricsRecord(BACKEND_BAND, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
+
+/**************************   bandBandMultiply   ************************
+ * int bandBandMultiply(BandMatrix *a, BandMatrix *b, BandMatrix *c)
+ *
+ * Description: C += A*B for band A, B and C. The product of bands with
+ * bandwidths (la, ua) and (lb, ub) lies in the band (la + lb, ua + ub),
+ * which C must cover.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a, b          in          ptr to BandMatrix structures.
+ * c             in/out      ptr to BandMatrix structure, a->rows by
+ *                           b->cols, bandwidths at least the sums.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match or C's band is too narrow.
+ ***********************************************************************/
+int bandBandMultiply(BandMatrix *a, BandMatrix *b, BandMatrix *c)
+{
+    long long start;
+    int numBlocks = (a->rows + BAND_ROW_BLOCK - 1) / BAND_ROW_BLOCK;
+    int aik;
+    int blk;
+    int i;
+    int j;
+    int k;
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols ||
+        c->lower < a->lower + b->lower || c->upper < a->upper + b->upper)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    #pragma omp parallel for schedule(static) private(aik, i, j, k)
+    for (blk = 0; blk < numBlocks; blk++)
+        for (i = blk * BAND_ROW_BLOCK;
+             i < a->rows && i < (blk + 1) * BAND_ROW_BLOCK; i++)
+            for (k = i - a->lower > 0 ? i - a->lower : 0;
+                 k <= i + a->upper && k < a->cols; k++)
+            {
+                aik = BAND_AT(a, i, k);
+                for (j = k - b->lower > 0 ? k - b->lower : 0;
+                     j <= k + b->upper && j < b->cols; j++)
+                    BAND_AT(c, i, j) += aik * BAND_AT(b, k, j);
+            }
+    if (start >= 0)
+        metricsRecord(BACKEND_BAND, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
@@ -0,0 +1,267 @@
+#include "define.h"
+#include <string.h>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/***********************************************************************
+ * bitmatrix.c written by DSU_410 team ...
+ *
+ * Description: Boolean matrices packed 64 entries per 64 bit word, 32
+ * times smaller than the same 0/1 values in a Matrix. The right operand
+ * of a product is packed transposed, so element (i, j) of the product
+ * combines word rows i of A and j of B^T:
+ * - bitMultiply, boolean product, set if any AND of the two rows is set.
+ * - bitCount, counting product, the popcount of the AND, which is the
+ *   number of k with a(i, k) and b(k, j), e.g. paths of length two.
+ *
+ * Rows are padded with zero words to a multiple of BIT_ROW_WORDS, 512
+ * bits, so the vector kernels need no tail loop. Every row therefore
+ * takes at least 64 bytes, and the 32 times saving only holds for rows
+ * of many times 512 columns: a 16 column matrix takes as much as with
+ * ints, and a 100 column one only 6 times less.
+ *
+ * The kernels use AVX-512 (VPOPCNTDQ for counting) or AVX2 when the
+ * compiler targets them, e.g. with -march=native, and plain 64 bit
+ * words with __builtin_popcountll otherwise.
+ *
+ * Functions:
+ * - bitInit
+ * - bitFromMatrix
+ * - bitToMatrix
+ * - bitFree
+ * - bitMultiply
+ * - bitCount
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/*******************************   andAny   *****************************
+ * static int andAny(const uint64_t *x, const uint64_t *y, int words)
+ *
+ * Description: Returns TRUE if x AND y has any bit set. Stops at the
+ * first vector with a common bit. words is a multiple of BIT_ROW_WORDS.
+ ***********************************************************************/
+static int andAny(const uint64_t *x, const uint64_t *y, int words)
+{
+    int w;
+#if defined(__AVX512F__)
+    for (w = 0; w < words; w += 8)
+        if (_mm512_test_epi64_mask(_mm512_loadu_si512(x + w),
+                                   _mm512_loadu_si512(y + w)))
+            return TRUE;
+#elif defined(__AVX2__)
+    __m256i v;
+    for (w = 0; w < words; w += 8)
+    {
+        v = _mm256_or_si256(
+                _mm256_and_si256(_mm256_loadu_si256((__m256i *) (x + w)),
+                                 _mm256_loadu_si256((__m256i *) (y + w))),
+                _mm256_and_si256(
+                    _mm256_loadu_si256((__m256i *) (x + w + 4)),
+                    _mm256_loadu_si256((__m256i *) (y + w + 4))));
+        if (!_mm256_testz_si256(v, v))
+            return TRUE;
+    }
+#else
+    for (w = 0; w < words; w++)
+        if (x[w] & y[w])
+            return TRUE;
+#endif
+    return FALSE;
+}
+
+/******************************   andCount   ****************************
+ * static int andCount(const uint64_t *x, const uint64_t *y, int words)
+ *
+ * Description: Returns the number of bits set in x AND y. words is a
+ * multiple of BIT_ROW_WORDS.
+ ***********************************************************************/
+static int andCount(const uint64_t *x, const uint64_t *y, int words)
+{
+    int count = 0;
+    int w;
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+    __m512i sum = _mm512_setzero_si512();
+    for (w = 0; w < words; w += 8)
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(
+                  _mm512_and_si512(_mm512_loadu_si512(x + w),
+                                   _mm512_loadu_si512(y + w))));
+    count = (int) _mm512_reduce_add_epi64(sum);
+#else
+    for (w = 0; w < words; w++)
+        count += __builtin_popcountll(x[w] & y[w]);
+#endif
+    return count;
+}
+
+/*******************************   bitInit   ****************************
+ * void bitInit(BitMatrix *a, int numRows, int numCols)
+ *
+ * Description: Allocates an all zero (false) bit matrix, each row
+ * padded to a multiple of BIT_ROW_WORDS words.
+ *
+ * NOTES:
+ * - A matrix with no rows or columns gets an empty buffer, which
+ *   allocScratch allows.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void bitInit(BitMatrix *a, int numRows, int numCols)
+{
+    size_t bytes;
+    a->rows = numRows;
+    a->cols = numCols;
+    a->words = (numCols + 64 * BIT_ROW_WORDS - 1) / (64 * BIT_ROW_WORDS)
+               * BIT_ROW_WORDS;
+    bytes = sizeof(uint64_t) * (size_t) numRows * a->words;
+    a->data = allocScratch(bytes);
+    memset(a->data, 0, bytes);
+}
+
+/****************************   bitFromMatrix   *************************
+ * void bitFromMatrix(BitMatrix *a, Matrix *src, int bTrans)
+ *
+ * Description: Allocates a bit matrix set where src is non-zero, or
+ * where src^T is non-zero with bTrans, the form for right operands.
+ ***********************************************************************/
+void bitFromMatrix(BitMatrix *a, Matrix *src, int bTrans)
+{
+    uint64_t *row;
+    int i;
+    int j;
+    if (bTrans)
+        bitInit(a, src->cols, src->rows);
+    else
+        bitInit(a, src->rows, src->cols);
+    // each row of a is built by one thread, reading a column of src
+    // with bTrans
+    #pragma omp parallel for schedule(static) private(row, j)
+    for (i = 0; i < a->rows; i++)
+    {
+        row = BIT_ROW(a, i);
+        for (j = 0; j < a->cols; j++)
+            if (bTrans ? src->m[j][i] : src->m[i][j])
+                row[j >> 6] |= (uint64_t) 1 << (j & 63);
+    }
+}
+
+/*****************************   bitToMatrix   **************************
+ * void bitToMatrix(BitMatrix *a, Matrix *dst)
+ *
+ * Description: Writes a bit matrix as 0/1 values into an allocated
+ * Matrix of the same shape.
+ ***********************************************************************/
+void bitToMatrix(BitMatrix *a, Matrix *dst)
+{
+    int i;
+    int j;
+    #pragma omp parallel for schedule(static) private(j)
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < a->cols; j++)
+            dst->m[i][j] = BIT_GET(a, i, j);
+}
+
+/*******************************   bitFree   ****************************
+ * void bitFree(BitMatrix *a)
+ *
+ * Description: Frees a bit matrix's storage.
+ ***********************************************************************/
+void bitFree(BitMatrix *a)
+{
+    freeScratch(a->data);
+}
+
+/*****************************   bitMultiply   **************************
+ * int bitMultiply(BitMatrix *a, BitMatrix *bT, BitMatrix *c)
+ *
+ * Description: Boolean product, c(i, j) = OR over k of a(i, k) AND
+ * b(k, j), with B given transposed.
+ *
+ * Process:
+ * 1.) Share blocks of BIT_ROW_BLOCK rows of C amongst threads.
+ * 2.) For each row of B^T, test it against every A row of the block
+ *     while it is in L1, and set the C bits that hit.
+ * 3.) With metrics on, the call is recorded under BACKEND_BIT.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to BitMatrix structure, see define.h.
+ * bT            in          ptr to BitMatrix holding B transposed.
+ * c             out         ptr to BitMatrix, a->rows by bT->rows. Its
+ *                           previous bits are replaced.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match.
+ ***********************************************************************/
+int bitMultiply(BitMatrix *a, BitMatrix *bT, BitMatrix *c)
+{
+    long long start;
+    int numBlocks = (a->rows + BIT_ROW_BLOCK - 1) / BIT_ROW_BLOCK;
+    int blk;
+    int i;
+    int j;
+    if (a->cols != bT->cols || c->rows != a->rows || c->cols != bT->rows)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    #pragma omp parallel for schedule(static) private(i, j)
+    for (blk = 0; blk < numBlocks; blk++)
+    {
+        for (i = blk * BIT_ROW_BLOCK;
+             i < a->rows && i < (blk + 1) * BIT_ROW_BLOCK; i++)
+            memset(BIT_ROW(c, i), 0, sizeof(uint64_t) * c->words);
+        for (j = 0; j < bT->rows; j++)
+            for (i = blk * BIT_ROW_BLOCK;
+                 i < a->rows && i < (blk + 1) * BIT_ROW_BLOCK; i++)
+                if (andAny(BIT_ROW(a, i), BIT_ROW(bT, j), a->words))
+                    BIT_ROW(c, i)[j >> 6] |= (uint64_t) 1 << (j & 63);
+    }
+    if (start >= 0)
+        metricsRecord(BACKEND_BIT, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
+
+/******************************   bitCount   ****************************
+ * int bitCount(BitMatrix *a, BitMatrix *bT, Matrix *c)
+ *
+ * Description: Counting product, c(i, j) += number of k with a(i, k)
+ * and b(k, j), with B given transposed. Same blocking as bitMultiply.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to BitMatrix structure, see define.h.
+ * bT            in          ptr to BitMatrix holding B transposed.
+ * c             in/out      ptr to Matrix, a->rows by bT->rows.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match.
+ ***********************************************************************/
+int bitCount(BitMatrix *a, BitMatrix *bT, Matrix *c)
+{
+    long long start;
+    int numBlocks = (a->rows + BIT_ROW_BLOCK - 1) / BIT_ROW_BLOCK;
+    int blk;
+    int i;
+    int j;
+    if (a->cols != bT->cols || c->rows != a->rows || c->cols != bT->rows)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    #pragma omp parallel for schedule(static) private(i, j)
+    for (blk = 0; blk < numBlocks; blk++)
+        for (j = 0; j < bT->rows; j++)
+            for (i = blk * BIT_ROW_BLOCK;
+                 i < a->rows && i < (blk + 1) * BIT_ROW_BLOCK; i++)
+                c->m[i][j] += andCount(BIT_ROW(a, i), BIT_ROW(bT, j),
+                                       a->words);
+    if (start >= 0)
+        metricsRecord(BACKEND_BIT, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
@@ -0,0 +1,265 @@
+#include "define.h"
+#include <string.h>
+
+/***********************************************************************
+ * blocksparse.c written by DSU_410 team ...
+ *
+ * Description: Block-sparse matrices, a grid of tile x tile dense tiles
+ * of which only the non-zero ones are stored. A bitmap, one bit per
+ * tile, records which tiles are present (see BSPARSE_HAS).
+ *
+ * The product only multiplies tile pairs A(i, k) * B(k, j) where both
+ * tiles are present, each pair with a dense tile kernel, so the cost
+ * follows the number of present pairs instead of the full grid. Meant
+ * for matrices with large zero regions; for scattered zeros every tile
+ * is present and this is just a blocked multiply.
+ *
+ * Functions:
+ * - bsparseFromMatrix
+ * - bsparseToMatrix
+ * - bsparseFree
+ * - bsparseMultiply
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/****************************   tileIsZero   ****************************
+ * static int tileIsZero(Matrix *a, int row0, int col0, int tile)
+ *
+ * Description: Returns TRUE if the tile at (row0, col0), clipped to the
+ * matrix, holds only zeros.
+ ***********************************************************************/
+static int tileIsZero(Matrix *a, int row0, int col0, int tile)
+{
+    int numRows = a->rows - row0 < tile ? a->rows - row0 : tile;
+    int numCols = a->cols - col0 < tile ? a->cols - col0 : tile;
+    int i;
+    int j;
+    for (i = 0; i < numRows; i++)
+        for (j = 0; j < numCols; j++)
+            if (a->m[row0 + i][col0 + j] != 0)
+                return FALSE;
+    return TRUE;
+}
+
+/*************************   bsparseFromMatrix   ************************
+ * void bsparseFromMatrix(BlockSparse *s, Matrix *a, int tile)
+ *
+ * Description: Builds the block-sparse form of a dense matrix.
+ *
+ * Process:
+ * 1.) Scan the tiles in parallel, each iteration filling one 64 bit
+ *     word of the bitmap so no two threads write the same word.
+ * 2.) Number the present tiles in order and allocate their storage.
+ * 3.) Copy the present tiles in parallel, zero padded at the edges.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * s             out         ptr to BlockSparse structure, see define.h.
+ * a             in          ptr to Matrix structure, see define.h.
+ * tile          in          Tile side, e.g. BSPARSE_TILE_SIDE.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void bsparseFromMatrix(BlockSparse *s, Matrix *a, int tile)
+{
+    size_t tileInts = (size_t) tile * tile;
+    int numTiles;
+    int numWords;
+    int numRows;
+    int numCols;
+    int row0;
+    int col0;
+    int *dst;
+    int w;
+    int t;
+    int b;
+    int i;
+    s->rows = a->rows;
+    s->cols = a->cols;
+    s->tile = tile;
+    s->tilesR = (a->rows + tile - 1) / tile;
+    s->tilesC = (a->cols + tile - 1) / tile;
+    numTiles = s->tilesR * s->tilesC;
+    numWords = (numTiles + 63) / 64;
+    s->present = malloc(sizeof(uint64_t) * numWords);
+    s->index = malloc(sizeof(int) * numTiles);
+    // an empty matrix has no tiles, and malloc(0) may give NULL
+    if (numTiles > 0 && (s->present == NULL || s->index == NULL))
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    #pragma omp parallel for schedule(dynamic) private(t, b)
+    for (w = 0; w < numWords; w++)
+    {
+        s->present[w] = 0;
+        for (b = 0; b < 64 && (t = w * 64 + b) < numTiles; b++)
+            if (!tileIsZero(a, t / s->tilesC * tile, t % s->tilesC * tile,
+                            tile))
+                s->present[w] |= (uint64_t) 1 << b;
+    }
+    s->numPresent = 0;
+    for (t = 0; t < numTiles; t++)
+        s->index[t] = BSPARSE_HAS(s, t / s->tilesC, t % s->tilesC)
+                      ? s->numPresent++ : -1;
+    s->data = allocScratch(sizeof(int) * tileInts * s->numPresent);
+    #pragma omp parallel for schedule(static) \
+        private(numRows, numCols, row0, col0, dst, i)
+    for (t = 0; t < numTiles; t++)
+        if (s->index[t] >= 0)
+        {
+            row0 = t / s->tilesC * tile;
+            col0 = t % s->tilesC * tile;
+            numRows = a->rows - row0 < tile ? a->rows - row0 : tile;
+            numCols = a->cols - col0 < tile ? a->cols - col0 : tile;
+            dst = s->data + tileInts * s->index[t];
+            memset(dst, 0, sizeof(int) * tileInts);
+            for (i = 0; i < numRows; i++)
+                memcpy(dst + i * tile, a->m[row0 + i] + col0,
+                       sizeof(int) * numCols);
+        }
+}
+
+/**************************   bsparseToMatrix   *************************
+ * void bsparseToMatrix(BlockSparse *s, Matrix *a)
+ *
+ * Description: Writes a block-sparse matrix into an allocated dense
+ * matrix of the same shape, zeros for the missing tiles.
+ ***********************************************************************/
+void bsparseToMatrix(BlockSparse *s, Matrix *a)
+{
+    int *src;
+    int ti;
+    int tj;
+    int i;
+    int j;
+    fillZeroes2D(a);
+    #pragma omp parallel for schedule(static) private(tj, src, i, j)
+    for (ti = 0; ti < s->tilesR; ti++)
+        for (tj = 0; tj < s->tilesC; tj++)
+            if (BSPARSE_HAS(s, ti, tj))
+            {
+                src = BSPARSE_TILE(s, ti, tj);
+                for (i = 0; i < s->tile && ti * s->tile + i < s->rows; i++)
+                    for (j = 0; j < s->tile && tj * s->tile + j < s->cols;
+                         j++)
+                        a->m[ti * s->tile + i][tj * s->tile + j] =
+                            src[i * s->tile + j];
+            }
+}
+
+/****************************   bsparseFree   ***************************
+ * void bsparseFree(BlockSparse *s)
+ *
+ * Description: Frees a block-sparse matrix's storage.
+ ***********************************************************************/
+void bsparseFree(BlockSparse *s)
+{
+    free(s->present);
+    free(s->index);
+    freeScratch(s->data);
+}
+
+/**************************   bsparseMultiply   *************************
+ * int bsparseMultiply(BlockSparse *a, BlockSparse *b, Matrix *c)
+ *
+ * Description: C += A*B for block-sparse A and B with the same tile
+ * size and dense C.
+ *
+ * Process:
+ * 1.) Share the tiles of C amongst threads, dynamically since their
+ *     work depends on how many pairs are present.
+ * 2.) For C tile (i, j) accumulate A(i, k) * B(k, j) over the k where
+ *     both bits are set, skipping the pair otherwise.
+ * 3.) Add the accumulator into C, unless no pair was present.
+ * 4.) With metrics on, the call is recorded under BACKEND_BSPARSE.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to BlockSparse structure, left operand.
+ * b             in          ptr to BlockSparse structure, right operand.
+ * c             in/out      ptr to Matrix structure, a->rows by b->cols.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes or tile sizes do not match.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int bsparseMultiply(BlockSparse *a, BlockSparse *b, Matrix *c)
+{
+    long long start;
+    int tile = a->tile;
+    int numTiles = a->tilesR * b->tilesC;
+    int t;
+    if (a->cols != b->rows || a->tile != b->tile ||
+        c->rows != a->rows || c->cols != b->cols)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    #pragma omp parallel
+    {
+        int *acc = malloc(sizeof(int) * tile * tile);
+        int *aTile;
+        int *bTile;
+        int *accRow;
+        int *bRow;
+        int aik;
+        int bAny;
+        int ti;
+        int tj;
+        int tk;
+        int i;
+        int j;
+        int k;
+        if (acc == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
+        #pragma omp for schedule(dynamic)
+        for (t = 0; t < numTiles; t++)
+        {
+            ti = t / b->tilesC;
+            tj = t % b->tilesC;
+            bAny = FALSE;
+            for (tk = 0; tk < a->tilesC; tk++)
+            {
+                if (!BSPARSE_HAS(a, ti, tk) || !BSPARSE_HAS(b, tk, tj))
+                    continue;
+                if (!bAny)
+                    memset(acc, 0, sizeof(int) * tile * tile);
+                bAny = TRUE;
+                aTile = BSPARSE_TILE(a, ti, tk);
+                bTile = BSPARSE_TILE(b, tk, tj);
+                for (i = 0; i < tile; i++)
+                {
+                    accRow = acc + i * tile;
+                    for (k = 0; k < tile; k++)
+                    {
+                        aik = aTile[i * tile + k];
+                        bRow = bTile + k * tile;
+                        for (j = 0; j < tile; j++)
+                            accRow[j] += aik * bRow[j];
+                    }
+                }
+            }
+            if (bAny)
+                for (i = 0; i < tile && ti * tile + i < c->rows; i++)
+                    for (j = 0; j < tile && tj * tile + j < c->cols; j++)
+                        c->m[ti * tile + i][tj * tile + j] +=
+                            acc[i * tile + j];
+        }
+        free(acc);
+    }
+    if (start >= 0)
+        metricsRecord(BACKEND_BSPARSE, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
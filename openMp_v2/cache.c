@@ -0,0 +1,510 @@
+#include "define.h"
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/***********************************************************************
+ * cache.c written by DSU_410 team ...
+ *
+ * Description: Optional cache of products for operand pairs that come
+ * back again and again. Entries are keyed by a content hash of A and of
+ * B, so a repeated pair costs two O(n^2) hashes and an add instead of
+ * an O(n^3) multiply. Changing an operand changes its hash, so an entry
+ * can never be returned for a matrix that has since been modified.
+ *
+ * The hash runs in parallel over rows. Each row is folded into 8
+ * independent 32-bit lanes that the compiler turns into SIMD, then the
+ * row hashes are combined with a commutative reduction. Keys are 128
+ * bits per operand, two 64-bit halves from independently seeded lanes.
+ * They are not cryptographic, and products are not compared after a
+ * key match.
+ *
+ * Resident products are kept within a memory budget, least recently
+ * used first out. With a spill directory, evicted products are written
+ * there with save2D and read back on their next hit. Without one they
+ * are dropped, as are those that would take the spilled products past
+ * CACHE_SPILL_MAX bytes.
+ *
+ * When the cache is enabled, multiply goes through multiplyCached.
+ *
+ * Functions:
+ * - hashMatrix
+ * - cacheEnable
+ * - cacheEnabled
+ * - cacheClear
+ * - cacheStats
+ * - multiplyCached
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// One cached product, resident or spilled
+typedef struct CacheEntry
+{
+    unsigned long long keyA[2];
+    unsigned long long keyB[2];
+    Matrix product;
+    int bResident;                  // FALSE once spilled to disk
+    size_t bytes;
+    struct CacheEntry *prev;        // LRU list of resident entries,
+    struct CacheEntry *next;        // most recently used first
+    struct CacheEntry *chain;       // hash bucket
+} CacheEntry;
+
+static int bEnabled = FALSE;
+static size_t budget = 0;
+static size_t used = 0;             // bytes of resident products
+static size_t spilled = 0;          // bytes of spilled products
+static char spillDir[CACHE_PATH_MAX - 80];   // room for the file name
+static CacheEntry *buckets[CACHE_BUCKETS];
+static CacheEntry *lruHead = NULL;
+static CacheEntry *lruTail = NULL;
+static long long hits = 0;
+static long long misses = 0;
+static pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*******************************   mix64   ******************************
+ * static unsigned long long mix64(unsigned long long x)
+ *
+ * Description: 64-bit finaliser, every input bit affects every output
+ * bit.
+ ***********************************************************************/
+static unsigned long long mix64(unsigned long long x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/******************************   hashRow   *****************************
+ * static void hashRow(const int *row, int n, int i,
+ *                     unsigned long long h[2])
+ *
+ * Description: Two independent 64-bit hashes of one row, seeded with
+ * its index.
+ *
+ * Process:
+ * 1.) Fold values j, j + 8, j + 16, ... into lane j % 8 of two sets of
+ *     lanes, with different seeds, multipliers and shifts. The lanes
+ *     are independent so the loop over them vectorises.
+ * 2.) Combine each set of lanes and the length into 64 bits.
+ ***********************************************************************/
+static void hashRow(const int *row, int n, int i, unsigned long long h[2])
+{
+    unsigned int lane1[CACHE_LANES];
+    unsigned int lane2[CACHE_LANES];
+    unsigned int v;
+    int j;
+    int l;
+    for (l = 0; l < CACHE_LANES; l++)
+    {
+        lane1[l] = (unsigned int) i * 0x9e3779b1U + l * 0x85ebca77U;
+        lane2[l] = (unsigned int) i * 0x27d4eb2fU + l * 0x165667b1U + 1;
+    }
+    for (j = 0; j + CACHE_LANES <= n; j += CACHE_LANES)
+    {
+        #pragma omp simd private(v)
+        for (l = 0; l < CACHE_LANES; l++)
+        {
+            v = (unsigned int) row[j + l];
+            lane1[l] = (lane1[l] ^ v) * 0x9e3779b1U;
+            lane1[l] ^= lane1[l] >> 15;
+            lane2[l] = (lane2[l] + v) * 0xcc9e2d51U;
+            lane2[l] ^= lane2[l] >> 13;
+        }
+    }
+    for (l = 0; j + l < n; l++)
+    {
+        v = (unsigned int) row[j + l];
+        lane1[l] = (lane1[l] ^ v) * 0xc2b2ae3dU;
+        lane2[l] = (lane2[l] + v) * 0x1b873593U;
+    }
+    h[0] = (unsigned long long) n;
+    h[1] = (unsigned long long) n ^ 0x6c62272e07bb0142ULL;
+    for (l = 0; l < CACHE_LANES; l++)
+    {
+        h[0] = (h[0] ^ lane1[l]) * 0x100000001b3ULL;
+        h[1] = (h[1] + lane2[l]) * 0xff51afd7ed558ccdULL;
+    }
+    h[0] = mix64(h[0]);
+    h[1] = mix64(h[1]);
+}
+
+/*****************************   hashMatrix   ***************************
+ * void hashMatrix(Matrix *a, unsigned long long key[2])
+ *
+ * Description: 128-bit content hash of a matrix, including its shape.
+ * The two halves come from the two independent row hashes, so a
+ * collision needs both to collide.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          Matrix structure, see define.h.
+ * key           out         Two 64-bit halves of the hash.
+ ***********************************************************************/
+void hashMatrix(Matrix *a, unsigned long long key[2])
+{
+    unsigned long long h1 = 0;
+    unsigned long long h2 = 0;
+    unsigned long long r[2];
+    int i;
+    #pragma omp parallel for schedule(static) private(r) \
+        reduction(+:h1) reduction(^:h2)
+    for (i = 0; i < a->rows; i++)
+    {
+        hashRow(a->m[i], a->cols, i, r);
+        h1 += mix64(r[0] ^ 0x2545f4914f6cdd1dULL);
+        h2 ^= mix64(r[1] + (unsigned long long) i * 0x9e3779b97f4a7c15ULL);
+    }
+    key[0] = mix64(h1 ^ ((unsigned long long) a->rows << 32 | a->cols));
+    key[1] = mix64(h2 + (unsigned long long) a->rows * a->cols);
+}
+
+/*****************************   spillPath   ****************************
+ * static void spillPath(CacheEntry *e, char *path)
+ *
+ * Description: File an entry is spilled to, named after its keys.
+ ***********************************************************************/
+static void spillPath(CacheEntry *e, char *path)
+{
+    snprintf(path, CACHE_PATH_MAX, "%s/%016llx%016llx%016llx%016llx.mm2d",
+             spillDir, e->keyA[0], e->keyA[1], e->keyB[0], e->keyB[1]);
+}
+
+/******************************   lruUnlink   ***************************
+ * static void lruUnlink(CacheEntry *e)
+ *
+ * Description: Takes a resident entry off the LRU list.
+ ***********************************************************************/
+static void lruUnlink(CacheEntry *e)
+{
+    if (e->prev != NULL)
+        e->prev->next = e->next;
+    else
+        lruHead = e->next;
+    if (e->next != NULL)
+        e->next->prev = e->prev;
+    else
+        lruTail = e->prev;
+    e->prev = NULL;
+    e->next = NULL;
+}
+
+/******************************   lruPush   *****************************
+ * static void lruPush(CacheEntry *e)
+ *
+ * Description: Puts an entry at the most recently used end.
+ ***********************************************************************/
+static void lruPush(CacheEntry *e)
+{
+    e->prev = NULL;
+    e->next = lruHead;
+    if (lruHead != NULL)
+        lruHead->prev = e;
+    else
+        lruTail = e;
+    lruHead = e;
+}
+
+/*****************************   bucketOf   *****************************
+ * static CacheEntry **bucketOf(unsigned long long *keyA,
+ *                              unsigned long long *keyB)
+ *
+ * Description: Hash bucket for a pair of keys.
+ ***********************************************************************/
+static CacheEntry **bucketOf(unsigned long long *keyA,
+                             unsigned long long *keyB)
+{
+    return &buckets[(keyA[0] ^ mix64(keyB[0])) % CACHE_BUCKETS];
+}
+
+/*****************************   findEntry   ****************************
+ * static CacheEntry *findEntry(unsigned long long *keyA,
+ *                              unsigned long long *keyB)
+ *
+ * Description: Entry for a pair of keys, or NULL. Caller holds
+ * cacheLock.
+ ***********************************************************************/
+static CacheEntry *findEntry(unsigned long long *keyA,
+                             unsigned long long *keyB)
+{
+    CacheEntry *e;
+    for (e = *bucketOf(keyA, keyB); e != NULL; e = e->chain)
+        if (memcmp(e->keyA, keyA, 2 * sizeof(*keyA)) == 0 &&
+            memcmp(e->keyB, keyB, 2 * sizeof(*keyB)) == 0)
+            break;
+    return e;
+}
+
+/****************************   removeEntry   ***************************
+ * static void removeEntry(CacheEntry *e)
+ *
+ * Description: Drops an entry altogether, with its memory and its spill
+ * file. Caller holds cacheLock.
+ ***********************************************************************/
+static void removeEntry(CacheEntry *e)
+{
+    CacheEntry **p = bucketOf(e->keyA, e->keyB);
+    char path[CACHE_PATH_MAX];
+    while (*p != e)
+        p = &(*p)->chain;
+    *p = e->chain;
+    if (e->bResident)
+    {
+        lruUnlink(e);
+        used -= e->bytes;
+        free2D(&e->product);
+    }
+    else
+    {
+        spillPath(e, path);
+        unlink(path);
+        spilled -= e->bytes;
+    }
+    free(e);
+}
+
+/*****************************   evictFor   *****************************
+ * static void evictFor(CacheEntry *keep)
+ *
+ * Description: Evicts least recently used products until the resident
+ * ones fit the budget, spilling them if there is a spill directory with
+ * room under CACHE_SPILL_MAX. keep is never evicted. Caller holds
+ * cacheLock.
+ ***********************************************************************/
+static void evictFor(CacheEntry *keep)
+{
+    CacheEntry *victim;
+    char path[CACHE_PATH_MAX];
+    while (used > budget && lruTail != NULL)
+    {
+        victim = lruTail != keep ? lruTail : keep->prev;
+        if (victim == NULL)
+            break;
+        if (spillDir[0] != '\0' &&
+            spilled + victim->bytes <= CACHE_SPILL_MAX)
+        {
+            spillPath(victim, path);
+            if (save2D(&victim->product, path))
+            {
+                lruUnlink(victim);
+                used -= victim->bytes;
+                free2D(&victim->product);
+                victim->bResident = FALSE;
+                spilled += victim->bytes;
+                continue;
+            }
+        }
+        removeEntry(victim);
+    }
+}
+
+/****************************   cacheEnable   ***************************
+ * void cacheEnable(size_t bytes, const char *dir)
+ *
+ * Description: Turns the cache on with a memory budget, or off (and
+ * empties it) when bytes is 0.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * bytes         in          Most bytes of products kept in memory.
+ * dir           in          Existing directory for spilled products,
+ *                           or NULL to drop them instead. Products
+ *                           spilled to a previous directory are
+ *                           forgotten and their files deleted.
+ ***********************************************************************/
+void cacheEnable(size_t bytes, const char *dir)
+{
+    CacheEntry *e;
+    CacheEntry *next;
+    int i;
+    if (bytes == 0)
+        cacheClear();
+    pthread_mutex_lock(&cacheLock);
+    if (dir == NULL)
+        dir = "";
+    // Spilled products cannot be found in a new directory
+    if (strcmp(dir, spillDir) != 0)
+        for (i = 0; i < CACHE_BUCKETS; i++)
+            for (e = buckets[i]; e != NULL; e = next)
+            {
+                next = e->chain;
+                if (!e->bResident)
+                    removeEntry(e);
+            }
+    snprintf(spillDir, sizeof(spillDir), "%s", dir);
+    budget = bytes;
+    bEnabled = bytes > 0;
+    evictFor(NULL);
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/****************************   cacheEnabled   **************************
+ * int cacheEnabled(void)
+ *
+ * Description: Tells multiply whether to go through the cache.
+ ***********************************************************************/
+int cacheEnabled(void)
+{
+    return bEnabled;
+}
+
+/*****************************   cacheClear   ***************************
+ * void cacheClear(void)
+ *
+ * Description: Empties the cache, deleting any spill files. Hit and
+ * miss counts are kept.
+ ***********************************************************************/
+void cacheClear(void)
+{
+    int i;
+    pthread_mutex_lock(&cacheLock);
+    for (i = 0; i < CACHE_BUCKETS; i++)
+        while (buckets[i] != NULL)
+            removeEntry(buckets[i]);
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/*****************************   cacheStats   ***************************
+ * void cacheStats(long long *numHits, long long *numMisses)
+ *
+ * Description: Calls answered from the cache, and calls that had to
+ * multiply, since the program started.
+ ***********************************************************************/
+void cacheStats(long long *numHits, long long *numMisses)
+{
+    pthread_mutex_lock(&cacheLock);
+    *numHits = hits;
+    *numMisses = misses;
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/******************************   addInto   *****************************
+ * static void addInto(Matrix *c, Matrix *p)
+ *
+ * Description: c += p, for matrices of the same shape.
+ ***********************************************************************/
+static void addInto(Matrix *c, Matrix *p)
+{
+    int i;
+    int j;
+    #pragma omp parallel for schedule(static) private(j)
+    for (i = 0; i < c->rows; i++)
+        for (j = 0; j < c->cols; j++)
+            c->m[i][j] += p->m[i][j];
+}
+
+/***************************   multiplyCached   *************************
+ * int multiplyCached(Matrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: c += a*b, using a cached a*b when there is one.
+ *
+ * Process:
+ * 1.) Hash both operands and look the pair up. A spilled product is
+ *     read back and becomes resident again.
+ * 2.) On a hit, add the product to c.
+ * 3.) On a miss, multiply into a new matrix, add it to c and keep it
+ *     if it fits the budget.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a, b, c       in/out      As for multiply.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Matrices cannot be multiplied.
+ *
+ * NOTES:
+ * - Products are allocated outside any arena set with setArena2D, as
+ *   they outlive the call.
+ ***********************************************************************/
+int multiplyCached(Matrix *a, Matrix *b, Matrix *c)
+{
+    unsigned long long keyA[2];
+    unsigned long long keyB[2];
+    char path[CACHE_PATH_MAX];
+    CacheEntry *e;
+    MatrixArena *old;
+    MatrixView va;
+    MatrixView vb;
+    MatrixView vp;
+    Matrix p;
+    long long start = metricsEnabled() ? metricsNow() : 0;
+    if (!isDefined(a, b) || c->rows != a->rows || c->cols != b->cols)
+        return FALSE;
+    hashMatrix(a, keyA);
+    hashMatrix(b, keyB);
+    pthread_mutex_lock(&cacheLock);
+    e = findEntry(keyA, keyB);
+    if (e != NULL && !e->bResident)
+    {
+        spillPath(e, path);
+        old = setArena2D(NULL);
+        if (load2D(&e->product, path))
+        {
+            unlink(path);
+            spilled -= e->bytes;
+            e->bResident = TRUE;
+            used += e->bytes;
+            lruPush(e);
+        }
+        else
+        {
+            removeEntry(e);         // unreadable, forget it
+            e = NULL;
+        }
+        setArena2D(old);
+    }
+    if (e != NULL)
+    {
+        lruUnlink(e);
+        lruPush(e);
+        evictFor(e);
+        addInto(c, &e->product);
+        hits++;
+        pthread_mutex_unlock(&cacheLock);
+        if (metricsEnabled())
+            metricsRecord(BACKEND_CACHE, c->rows, c->cols, a->cols,
+                          metricsNow() - start);
+        return TRUE;
+    }
+    misses++;
+    pthread_mutex_unlock(&cacheLock);
+    old = setArena2D(NULL);
+    setUp2D(&p, a->rows, b->cols, FALSE);
+    setArena2D(old);
+    makeView(&va, a, FALSE);
+    makeView(&vb, b, FALSE);
+    makeView(&vp, &p, FALSE);
+    multiplyView(&va, &vb, &vp);
+    addInto(c, &p);
+    // Keep it unless another thread got there first or it never fits
+    pthread_mutex_lock(&cacheLock);
+    e = NULL;
+    if (bEnabled && findEntry(keyA, keyB) == NULL &&
+        sizeof(int) * (size_t) p.rows * p.cols <= budget)
+        e = calloc(1, sizeof(CacheEntry));
+    if (e != NULL)
+    {
+        memcpy(e->keyA, keyA, sizeof(keyA));
+        memcpy(e->keyB, keyB, sizeof(keyB));
+        e->product = p;
+        e->bResident = TRUE;
+        e->bytes = sizeof(int) * (size_t) p.rows * p.cols;
+        e->chain = *bucketOf(keyA, keyB);
+        *bucketOf(keyA, keyB) = e;
+        used += e->bytes;
+        lruPush(e);
+        evictFor(e);
+    }
+    else
+        free2D(&p);
+    pthread_mutex_unlock(&cacheLock);
+    return TRUE;
+}
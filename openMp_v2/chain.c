@@ -0,0 +1,394 @@
+#include "define.h"
+
+/***********************************************************************
+ * chain.c written by DSU_410 team ...
+ *
+ * Description: Matrix chain products A1*A2*...*An. The order in which
+ * the products are taken is chosen by dynamic programming over the
+ * dimensions so the fewest multiply-adds are spent, and intermediate
+ * results live in a small set of reusable buffers (taken from the
+ * selected arena, if any, see arena.c).
+ *
+ * A ChainExpr collects the operands of A*B*C... lazily; nothing is
+ * multiplied until chainEval is called with the destination.
+ *
+ * Functions:
+ * - chainBegin
+ * - chainTimes
+ * - chainEval
+ * - multiplyChain
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// Intermediate result storage, reshaped for each product it holds
+typedef struct
+{
+    Matrix mat;     // current shape, rows point into data
+    int *data;      // contiguous values
+    int capacity;   // ints available in data
+    int rowCap;     // row pointers available in mat.m
+    int bInUse;     // TRUE while holding a live intermediate
+} ChainBuffer;
+
+// Everything the recursive evaluation needs
+typedef struct
+{
+    Matrix **mats;      // operands of the chain
+    int count;          // number of operands
+    int *split;         // count x count, best split of (i..j)
+    int *need;          // count x count, buffers to evaluate (i..j)
+    ChainBuffer buf[MAX_CHAIN];
+    int numBuf;
+} ChainPlan;
+
+/*****************************   chainBegin   ***************************
+ * void chainBegin(ChainExpr *e, Matrix *a)
+ *
+ * Description: Starts a lazy chain expression with a as its first
+ * operand.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * e             out         ptr to ChainExpr structure, see define.h.
+ * a             in          ptr to first Matrix of the chain.
+ ***********************************************************************/
+void chainBegin(ChainExpr *e, Matrix *a)
+{
+    e->mats[0] = a;
+    e->count = 1;
+    e->bValid = TRUE;
+}
+
+/*****************************   chainTimes   ***************************
+ * ChainExpr *chainTimes(ChainExpr *e, Matrix *a)
+ *
+ * Description: Appends a to the right end of the chain, the lazy
+ * equivalent of e * a.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * e             in/out      ptr to ChainExpr structure, see define.h.
+ * a             in          ptr to Matrix appended to the chain.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * e             So calls can be nested, chainTimes(chainTimes(e, B), C).
+ *
+ * NOTES:
+ * - A link that is not defined, or more than MAX_CHAIN operands, marks
+ *   the expression invalid and chainEval then refuses it.
+ ***********************************************************************/
+ChainExpr *chainTimes(ChainExpr *e, Matrix *a)
+{
+    if (e->count >= MAX_CHAIN || !isDefined(e->mats[e->count - 1], a))
+        e->bValid = FALSE;
+    else
+        e->mats[e->count++] = a;
+    return e;
+}
+
+/*****************************   chainEval   ****************************
+ * int chainEval(ChainExpr *e, Matrix *c)
+ *
+ * Description: Evaluates a lazy chain expression into c.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * e             in          ptr to ChainExpr structure, see define.h.
+ * c             out         ptr to Matrix receiving the product.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Product was computed.
+ * FALSE         Expression invalid or c has the wrong shape.
+ ***********************************************************************/
+int chainEval(ChainExpr *e, Matrix *c)
+{
+    if (!e->bValid)
+        return FALSE;
+    return multiplyChain(e->mats, e->count, c);
+}
+
+/****************************   acquireBuffer   *************************
+ * static ChainBuffer *acquireBuffer(ChainPlan *plan, int rows, int cols)
+ *
+ * Description: Hands out a zeroed rows-by-cols intermediate, reusing
+ * a free buffer whenever one is large enough.
+ *
+ * Process:
+ * 1.) Pick the smallest free buffer that fits, else grow the largest
+ *     free one, which needs the least extra room, else create a new
+ *     one.
+ * 2.) Reshape it to rows-by-cols and fill with 0s.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * plan          in/out      ptr to ChainPlan owning the buffers.
+ * rows, cols    in          Shape of the intermediate.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * ptr           Buffer marked in use.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+static ChainBuffer *acquireBuffer(ChainPlan *plan, int rows, int cols)
+{
+    ChainBuffer *best = NULL;
+    ChainBuffer *cb;
+    int size = rows * cols;
+    int i;
+    // Smallest free buffer that fits
+    for (i = 0; i < plan->numBuf; i++)
+    {
+        cb = &plan->buf[i];
+        if (!cb->bInUse && cb->capacity >= size &&
+            (best == NULL || cb->capacity < best->capacity))
+            best = cb;
+    }
+    // Otherwise the largest free one, which is then grown
+    for (i = 0; i < plan->numBuf; i++)
+    {
+        cb = &plan->buf[i];
+        if (!cb->bInUse && cb->capacity < size &&
+            (best == NULL || cb->capacity > best->capacity))
+            best = cb;
+    }
+    if (best == NULL)
+    {
+        best = &plan->buf[plan->numBuf++];
+        best->data = NULL;
+        best->mat.m = NULL;
+        best->capacity = 0;
+        best->rowCap = 0;
+    }
+    if (best->capacity < size)
+    {
+        freeScratch(best->data);
+        best->data = allocScratch(sizeof(int) * size);
+        best->capacity = size;
+    }
+    if (best->rowCap < rows)
+    {
+        freeScratch(best->mat.m);
+        best->mat.m = allocScratch(sizeof(int *) * rows);
+        best->rowCap = rows;
+    }
+    best->mat.rows = rows;
+    best->mat.cols = cols;
+    for (i = 0; i < rows; i++)
+        best->mat.m[i] = best->data + i * cols;
+    fillZeroes2D(&best->mat);
+    best->bInUse = TRUE;
+    return best;
+}
+
+/*****************************   planChain   ****************************
+ * static void planChain(ChainPlan *plan, int *dims)
+ *
+ * Description: Classic O(n^3) matrix chain order dynamic program. Also
+ * works out, for every subchain, how many intermediate buffers its
+ * evaluation needs and which side to evaluate first to keep that low.
+ *
+ * Process:
+ * 1.) cost(i, j) = min over s of cost(i, s) + cost(s+1, j)
+ *                  + dims[i] * dims[s+1] * dims[j+1].
+ * 2.) need(i, j) = buffers live at the peak while evaluating (i..j)
+ *     into a buffer supplied by the caller.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * plan          in/out      ptr to ChainPlan, split and need filled in.
+ * dims          in          count + 1 dimensions, operand i is
+ *                           dims[i]-by-dims[i + 1].
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+static void planChain(ChainPlan *plan, int *dims)
+{
+    int n = plan->count;
+    long long *cost = allocScratch(sizeof(long long) * n * n);
+    long long trial;
+    int len;
+    int i;
+    int j;
+    int s;
+    int evalL;
+    int evalR;
+    int holdL;
+    int holdR;
+    int leftFirst;
+    int rightFirst;
+    for (i = 0; i < n; i++)
+    {
+        cost[i * n + i] = 0;
+        plan->need[i * n + i] = 0;
+    }
+    for (len = 2; len <= n; len++)
+        for (i = 0; i + len - 1 < n; i++)
+        {
+            j = i + len - 1;
+            cost[i * n + j] = -1;
+            for (s = i; s < j; s++)
+            {
+                trial = cost[i * n + s] + cost[(s + 1) * n + j] +
+                        (long long) dims[i] * dims[s + 1] * dims[j + 1];
+                if (cost[i * n + j] < 0 || trial < cost[i * n + j])
+                {
+                    cost[i * n + j] = trial;
+                    plan->split[i * n + j] = s;
+                }
+            }
+            // An internal child holds one buffer for its result on top
+            // of what it needs while being evaluated
+            s = plan->split[i * n + j];
+            holdL = s > i;
+            holdR = s + 1 < j;
+            evalL = holdL + plan->need[i * n + s];
+            evalR = holdR + plan->need[(s + 1) * n + j];
+            leftFirst = evalL > holdL + evalR ? evalL : holdL + evalR;
+            rightFirst = evalR > holdR + evalL ? evalR : holdR + evalL;
+            plan->need[i * n + j] = leftFirst < rightFirst ? leftFirst
+                                                           : rightFirst;
+        }
+    freeScratch(cost);
+}
+
+/*****************************   evalChain   ****************************
+ * static void evalChain(ChainPlan *plan, int i, int j, MatrixView *dst)
+ *
+ * Description: Adds the product of operands i..j into dst following the
+ * planned parenthesisation.
+ *
+ * Process:
+ * 1.) Evaluate each internal side into a buffer, the side needing more
+ *     buffers first. Single operands are used in place.
+ * 2.) Multiply the two sides into dst and release the buffers.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * plan          in/out      ptr to ChainPlan.
+ * i, j          in          First and last operand, i < j.
+ * dst           in/out      ptr to MatrixView receiving the product.
+ ***********************************************************************/
+static void evalChain(ChainPlan *plan, int i, int j, MatrixView *dst)
+{
+    int n = plan->count;
+    int s = plan->split[i * n + j];
+    ChainBuffer *left = NULL;
+    ChainBuffer *right = NULL;
+    MatrixView vl;
+    MatrixView vr;
+    int needL = s > i ? 1 + plan->need[i * n + s] : 0;
+    int needR = s + 1 < j ? 1 + plan->need[(s + 1) * n + j] : 0;
+    int bLeftFirst = needL >= needR;
+    int side;
+    for (side = 0; side < 2; side++)
+    {
+        if ((side == 0) == bLeftFirst)
+        {
+            if (s > i)
+            {
+                left = acquireBuffer(plan, plan->mats[i]->rows,
+                                     plan->mats[s]->cols);
+                makeView(&vl, &left->mat, FALSE);
+                evalChain(plan, i, s, &vl);
+            }
+            else
+                makeView(&vl, plan->mats[i], FALSE);
+        }
+        else
+        {
+            if (s + 1 < j)
+            {
+                right = acquireBuffer(plan, plan->mats[s + 1]->rows,
+                                      plan->mats[j]->cols);
+                makeView(&vr, &right->mat, FALSE);
+                evalChain(plan, s + 1, j, &vr);
+            }
+            else
+                makeView(&vr, plan->mats[j], FALSE);
+        }
+    }
+    multiplyView(&vl, &vr, dst);
+    if (left != NULL)
+        left->bInUse = FALSE;
+    if (right != NULL)
+        right->bInUse = FALSE;
+}
+
+/****************************   multiplyChain   *************************
+ * int multiplyChain(Matrix **mats, int count, Matrix *c)
+ *
+ * Description: Computes mats[0] * mats[1] * ... * mats[count - 1] in the
+ * cheapest order and adds the result into c.
+ *
+ * Process:
+ * 1.) Check every link with isDefined and the shape of c.
+ * 2.) Plan the order with planChain.
+ * 3.) Evaluate with evalChain, then free the intermediate buffers.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * mats          in          Array of count ptrs to Matrix structures.
+ * count         in          Number of operands, 1..MAX_CHAIN.
+ * c             out         ptr to Matrix, mats[0]->rows by
+ *                           mats[count - 1]->cols.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Product was computed.
+ * FALSE         Chain undefined or c has the wrong shape.
+ *
+ * NOTES:
+ * - Like multiply, accumulates into c, so c is normally zeroed first.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int multiplyChain(Matrix **mats, int count, Matrix *c)
+{
+    ChainPlan plan;
+    MatrixView vc;
+    int dims[MAX_CHAIN + 1];
+    int i;
+    int j;
+    if (count < 1 || count > MAX_CHAIN)
+        return FALSE;
+    for (i = 0; i + 1 < count; i++)
+        if (!isDefined(mats[i], mats[i + 1]))
+            return FALSE;
+    if (c->rows != mats[0]->rows || c->cols != mats[count - 1]->cols)
+        return FALSE;
+    if (count == 1)
+    {
+        // c += mats[0], nothing to multiply
+        for (i = 0; i < c->rows; i++)
+            for (j = 0; j < c->cols; j++)
+                c->m[i][j] += mats[0]->m[i][j];
+        return TRUE;
+    }
+    for (i = 0; i < count; i++)
+        dims[i] = mats[i]->rows;
+    dims[count] = mats[count - 1]->cols;
+    plan.mats = mats;
+    plan.count = count;
+    plan.numBuf = 0;
+    plan.split = allocScratch(sizeof(int) * count * count);
+    plan.need = allocScratch(sizeof(int) * count * count);
+    planChain(&plan, dims);
+    makeView(&vc, c, FALSE);
+    evalChain(&plan, 0, count - 1, &vc);
+    for (i = 0; i < plan.numBuf; i++)
+    {
+        freeScratch(plan.buf[i].data);
+        freeScratch(plan.buf[i].mat.m);
+    }
+    freeScratch(plan.split);
+    freeScratch(plan.need);
+    return TRUE;
+}
@@ -0,0 +1,1150 @@
+#include "define.h"
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+/***********************************************************************
+ * check.c written by DSU_410 team ...
+ *
+ * Description: Self check of the numeric entry points. Each check runs
+ * a kernel on small random operands, chosen to reach its edge cases
+ * (tails shorter than a block, split shared dimensions, dimensions of
+ * 1), and compares the result with a naive triple loop. One line is
+ * printed per check.
+ *
+ * compile: %gcc check.c 2DArray.c matrix.c view.c chain.c epilogue.c
+ *          power.c arena.c perf.c metrics.c tune.c transport.c dist.c
+ *          server.c client.c async.c cache.c incremental.c syrk.c
+ *          band.c triangular.c blocksparse.c bitmatrix.c m4rm.c
+ *          semiring.c modular.c transpose.c morton.c splitk.c gemv.c
+ *          -o mmcheck -fopenmp -lpthread
+ * execute: ./mmcheck
+ *
+ * Exit status is 0 when every check passes, 1 otherwise. Run it with
+ * OMP_NUM_THREADS above 1 as well, so the parallel paths are taken.
+ *
+ * Process:
+ * 1.) Run every check, printing its name and ok or FAILED.
+ * 2.) Print the number of failed checks.
+ ************************************************************************/
+
+static int numFailed = 0;
+
+/******************************   report   ******************************
+ * static void report(const char *name, int bOk)
+ *
+ * Description: Prints the outcome of one check and counts failures.
+ ***********************************************************************/
+static void report(const char *name, int bOk)
+{
+    printf("%-36s %s\n", name, bOk ? "ok" : "FAILED");
+    if (!bOk)
+        numFailed++;
+}
+
+/***************************   naiveMultiply   **************************
+ * static void naiveMultiply(Matrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: Reference c += a*b, the plain i, j, k loop.
+ ***********************************************************************/
+static void naiveMultiply(Matrix *a, Matrix *b, Matrix *c)
+{
+    int i;
+    int j;
+    int k;
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < b->cols; j++)
+            for (k = 0; k < a->cols; k++)
+                c->m[i][j] += a->m[i][k] * b->m[k][j];
+}
+
+/*****************************   sameMatrix   ***************************
+ * static int sameMatrix(Matrix *x, Matrix *y)
+ *
+ * Description: TRUE when x and y have the same shape and values.
+ ***********************************************************************/
+static int sameMatrix(Matrix *x, Matrix *y)
+{
+    int i;
+    if (x->rows != y->rows || x->cols != y->cols)
+        return FALSE;
+    for (i = 0; i < x->rows; i++)
+        if (memcmp(x->m[i], y->m[i], sizeof(int) * x->cols) != 0)
+            return FALSE;
+    return TRUE;
+}
+
+/******************************   fillValue   ***************************
+ * static void fillValue(Matrix *a, int value)
+ *
+ * Description: Sets every element of a to value.
+ ***********************************************************************/
+static void fillValue(Matrix *a, int value)
+{
+    int i;
+    int j;
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < a->cols; j++)
+            a->m[i][j] = value;
+}
+
+/******************************   copyMatrix   **************************
+ * static void copyMatrix(Matrix *dst, Matrix *src)
+ *
+ * Description: Copies src into dst, of the same shape.
+ ***********************************************************************/
+static void copyMatrix(Matrix *dst, Matrix *src)
+{
+    int i;
+    for (i = 0; i < src->rows; i++)
+        memcpy(dst->m[i], src->m[i], sizeof(int) * src->cols);
+}
+
+/*******************************   fillBits   ***************************
+ * static void fillBits(Matrix *a, int percent)
+ *
+ * Description: Fills a with 0/1 values, about percent of them 1.
+ ***********************************************************************/
+static void fillBits(Matrix *a, int percent)
+{
+    int i;
+    int j;
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < a->cols; j++)
+            a->m[i][j] = rand() % 100 < percent;
+}
+
+/*****************************   checkShape   ***************************
+ * static int checkShape(int n, int p, int m)
+ *
+ * Description: TRUE when multiply of a random n-by-p A and p-by-m B,
+ * into a C that does not start at zero, matches the naive product.
+ ***********************************************************************/
+static int checkShape(int n, int p, int m)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix ref;
+    int bOk;
+    setUp2D(&a, n, p, TRUE);
+    setUp2D(&b, p, m, TRUE);
+    setUp2D(&c, n, m, FALSE);
+    setUp2D(&ref, n, m, FALSE);
+    fillValue(&c, 3);
+    fillValue(&ref, 3);
+    bOk = multiply(&a, &b, &c);
+    naiveMultiply(&a, &b, &ref);
+    bOk = bOk && sameMatrix(&c, &ref);
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&ref);
+    return bOk;
+}
+
+/****************************   metricsHas   ****************************
+ * static int metricsHas(const char *backend)
+ *
+ * Description: Tells whether the metrics report has a class recorded
+ * under the named backend.
+ ***********************************************************************/
+static int metricsHas(const char *backend)
+{
+    FILE *f = tmpfile();
+    char line[1024];
+    char key[64];
+    int bFound = FALSE;
+    if (f == NULL)
+        return FALSE;
+    snprintf(key, sizeof(key), "\"backend\":\"%s\"", backend);
+    metricsDump(f);
+    rewind(f);
+    while (!bFound && fgets(line, sizeof(line), f) != NULL)
+        bFound = strstr(line, key) != NULL;
+    fclose(f);
+    return bFound;
+}
+
+/****************************   checkMultiply   *************************
+ * static void checkMultiply(void)
+ *
+ * Description: multiply for square, ragged, thin and vector shapes, and
+ * multiplySplitK with a forced slice count, whatever the thread count.
+ ***********************************************************************/
+static void checkMultiply(void)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix ref;
+    MatrixView va;
+    MatrixView vb;
+    MatrixView vc;
+    TuneParams tp;
+    int bOk;
+    report("multiply square", checkShape(67, 67, 67));
+    report("multiply ragged", checkShape(33, 129, 65));
+    report("multiply long shared dimension", checkShape(8, 3000, 8));
+    report("multiply matrix-vector", checkShape(100, 77, 1));
+    report("multiply vector-matrix", checkShape(1, 77, 100));
+    report("multiply outer product", checkShape(100, 1, 77));
+    report("multiply 1x1", checkShape(1, 1, 1));
+    setUp2D(&a, 9, 2000, TRUE);
+    setUp2D(&b, 2000, 11, TRUE);
+    setUp2D(&c, 9, 11, FALSE);
+    setUp2D(&ref, 9, 11, FALSE);
+    fillValue(&c, -2);
+    fillValue(&ref, -2);
+    makeView(&va, &a, FALSE);
+    makeView(&vb, &b, FALSE);
+    makeView(&vc, &c, FALSE);
+    getTuneParams(c.rows, c.cols, a.cols, &tp);
+    multiplySplitK(&va, &vb, &vc, NULL, &tp, 4);
+    naiveMultiply(&a, &b, &ref);
+    bOk = sameMatrix(&c, &ref);
+    report("multiplySplitK 4 slices", bOk);
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&ref);
+}
+
+/****************************   checkTranspose   ************************
+ * static void checkTranspose(void)
+ *
+ * Description: transposeMatrix, and transposeInPlace on a square and a
+ * rectangular matrix.
+ ***********************************************************************/
+static void checkTranspose(void)
+{
+    Matrix a;
+    Matrix t;
+    Matrix ref;
+    int shapes[2][2] = { { 67, 67 }, { 37, 101 } };
+    int bOk;
+    int s;
+    int i;
+    int j;
+    setUp2D(&a, 70, 130, TRUE);
+    setUp2D(&t, 130, 70, FALSE);
+    bOk = transposeMatrix(&a, &t);
+    for (i = 0; i < a.rows; i++)
+        for (j = 0; j < a.cols; j++)
+            bOk = bOk && t.m[j][i] == a.m[i][j];
+    report("transposeMatrix", bOk);
+    free2D(&a);
+    free2D(&t);
+    for (s = 0; s < 2; s++)
+    {
+        setUp2D(&a, shapes[s][0], shapes[s][1], TRUE);
+        setUp2D(&ref, shapes[s][1], shapes[s][0], FALSE);
+        for (i = 0; i < a.rows; i++)
+            for (j = 0; j < a.cols; j++)
+                ref.m[j][i] = a.m[i][j];
+        bOk = transposeInPlace(&a) && sameMatrix(&a, &ref);
+        report(s == 0 ? "transposeInPlace square"
+                      : "transposeInPlace rectangular", bOk);
+        free2D(&a);
+        free2D(&ref);
+    }
+}
+
+/*****************************   checkMorton   **************************
+ * static void checkMorton(void)
+ *
+ * Description: mortonEncode / mortonDecode round trip, and
+ * mortonMultiply of ragged matrices converted in and out.
+ ***********************************************************************/
+static void checkMorton(void)
+{
+    MortonMatrix ma;
+    MortonMatrix mb;
+    MortonMatrix mc;
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix ref;
+    FILE *out = tmpfile();
+    unsigned i;
+    unsigned j;
+    unsigned ri;
+    unsigned rj;
+    int bOk = TRUE;
+    for (i = 0; i < 300; i += 7)
+        for (j = 0; j < 300; j += 11)
+        {
+            mortonDecode(mortonEncode(i, j), &ri, &rj);
+            bOk = bOk && ri == i && rj == j;
+        }
+    report("mortonEncode/mortonDecode", bOk);
+    setUp2D(&a, 70, 45, TRUE);
+    setUp2D(&b, 45, 90, TRUE);
+    setUp2D(&c, 70, 90, FALSE);
+    setUp2D(&ref, 70, 90, FALSE);
+    mortonFromMatrix(&ma, &a);
+    mortonFromMatrix(&mb, &b);
+    mortonInit(&mc, 70, 90);
+    metricsEnable(out);
+    bOk = mortonMultiply(&ma, &mb, &mc) && metricsHas("morton");
+    metricsEnable(NULL);
+    if (out != NULL)
+        fclose(out);
+    mortonToMatrix(&mc, &c);
+    naiveMultiply(&a, &b, &ref);
+    report("mortonMultiply", bOk && sameMatrix(&c, &ref));
+    mortonFree(&ma);
+    mortonFree(&mb);
+    mortonFree(&mc);
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&ref);
+}
+
+/******************************   checkBits   ***************************
+ * static void checkBits(void)
+ *
+ * Description: bitMultiply, bitCount and both forms of m4rm against the
+ * counting product of the same 0/1 matrices.
+ ***********************************************************************/
+static void checkBits(void)
+{
+    BitMatrix ba;
+    BitMatrix bb;
+    BitMatrix bbT;
+    BitMatrix bc;
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix count;
+    FILE *out = tmpfile();
+    int bOk[4];
+    int v;
+    int i;
+    int j;
+    metricsEnable(out);
+    setUp2D(&a, 75, 600, FALSE);
+    setUp2D(&b, 600, 130, FALSE);
+    setUp2D(&c, 75, 130, FALSE);
+    setUp2D(&count, 75, 130, FALSE);
+    fillBits(&a, 2);
+    fillBits(&b, 2);
+    naiveMultiply(&a, &b, &count);
+    bitFromMatrix(&ba, &a, FALSE);
+    bitFromMatrix(&bb, &b, FALSE);
+    bitFromMatrix(&bbT, &b, TRUE);
+    bitInit(&bc, 75, 130);
+    bOk[0] = bitMultiply(&ba, &bbT, &bc);
+    bitToMatrix(&bc, &c);
+    for (i = 0; i < c.rows; i++)
+        for (j = 0; j < c.cols; j++)
+            bOk[0] = bOk[0] && c.m[i][j] == (count.m[i][j] > 0);
+    fillZeroes2D(&c);
+    bOk[1] = bitCount(&ba, &bbT, &c) && sameMatrix(&c, &count);
+    bOk[0] = bOk[0] && metricsHas("bit");
+    for (v = 0; v < 2; v++)
+    {
+        bOk[2 + v] = m4rm(&ba, &bb, &bc, v == 0);
+        bitToMatrix(&bc, &c);
+        for (i = 0; i < c.rows; i++)
+            for (j = 0; j < c.cols; j++)
+                bOk[2 + v] = bOk[2 + v] &&
+                             c.m[i][j] == (v == 0 ? count.m[i][j] % 2
+                                                  : count.m[i][j] > 0);
+    }
+    bOk[2] = bOk[2] && metricsHas("m4rm");
+    metricsEnable(NULL);
+    if (out != NULL)
+        fclose(out);
+    report("bitMultiply", bOk[0]);
+    report("bitCount", bOk[1]);
+    report("m4rm GF(2)", bOk[2]);
+    report("m4rm boolean", bOk[3]);
+    bitFree(&ba);
+    bitFree(&bb);
+    bitFree(&bbT);
+    bitFree(&bc);
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&count);
+}
+
+/****************************   checkModular   **************************
+ * static void checkModular(void)
+ *
+ * Description: modMultiply with large and negative values, whose sums
+ * overflow an int, and modMultiplyExact with a product needing more
+ * than 64 bits.
+ ***********************************************************************/
+static void checkModular(void)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    __int128 *x;
+    __int128 exact;
+    long long sum;
+    FILE *out = tmpfile();
+    int modulus = 1000003;
+    int bOk;
+    int i;
+    int j;
+    int k;
+    metricsEnable(out);
+    setUp2D(&a, 31, 300, FALSE);
+    setUp2D(&b, 300, 29, FALSE);
+    setUp2D(&c, 31, 29, FALSE);
+    for (i = 0; i < a.rows; i++)
+        for (j = 0; j < a.cols; j++)
+            a.m[i][j] = rand() - RAND_MAX / 2;
+    for (i = 0; i < b.rows; i++)
+        for (j = 0; j < b.cols; j++)
+            b.m[i][j] = rand() - RAND_MAX / 2;
+    fillValue(&c, -5);
+    bOk = modMultiply(&a, &b, &c, modulus);
+    for (i = 0; i < c.rows; i++)
+        for (j = 0; j < c.cols; j++)
+        {
+            sum = -5;
+            for (k = 0; k < a.cols; k++)
+                sum = (sum + (long long) (a.m[i][k] % modulus) *
+                             (b.m[k][j] % modulus)) % modulus;
+            if (sum < 0)
+                sum += modulus;
+            bOk = bOk && c.m[i][j] == sum;
+        }
+    report("modMultiply", bOk && metricsHas("modular"));
+    // c(0, 0) = 300 * 2^62, which needs more than 64 bits
+    for (k = 0; k < a.cols; k++)
+    {
+        a.m[0][k] = INT_MIN;
+        b.m[k][0] = INT_MIN;
+    }
+    for (i = 1; i < a.rows; i++)
+        a.m[i][0] = i % 2 ? INT_MAX : INT_MIN;
+    x = malloc(sizeof(__int128) * c.rows * c.cols);
+    if (x == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    bOk = modMultiplyExact(&a, &b, x);
+    for (i = 0; i < c.rows; i++)
+        for (j = 0; j < c.cols; j++)
+        {
+            exact = 0;
+            for (k = 0; k < a.cols; k++)
+                exact += (__int128) a.m[i][k] * b.m[k][j];
+            bOk = bOk && x[i * c.cols + j] == exact;
+        }
+    report("modMultiplyExact", bOk);
+    metricsEnable(NULL);
+    if (out != NULL)
+        fclose(out);
+    free(x);
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+}
+
+/*****************************   closureCase   **************************
+ * static int closureCase(int kind, int n, int bDag, int lo, int hi)
+ *
+ * Description: semiringClosure of a random sparse graph against Floyd-
+ * Warshall. Weights are in [lo..hi], a DAG keeps negative (min-plus)
+ * or positive (max-plus) weights free of cycles. Many pairs are left
+ * unreachable.
+ ***********************************************************************/
+static int closureCase(int kind, int n, int bDag, int lo, int hi)
+{
+    Semiring sr;
+    Matrix d;
+    Matrix ref;
+    int bOk;
+    int v;
+    int i;
+    int j;
+    int k;
+    semiringInit(&sr, kind);
+    setUp2D(&d, n, n, FALSE);
+    setUp2D(&ref, n, n, FALSE);
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+            d.m[i][j] = rand() % 25 == 0 && (!bDag || i < j)
+                        ? lo + rand() % (hi - lo + 1) : sr.zero;
+    copyMatrix(&ref, &d);
+    for (i = 0; i < n; i++)
+        ref.m[i][i] = sr.add(ref.m[i][i], sr.one);
+    for (k = 0; k < n; k++)
+        for (i = 0; i < n; i++)
+            for (j = 0; j < n; j++)
+            {
+                if (ref.m[i][k] == sr.zero || ref.m[k][j] == sr.zero)
+                    continue;
+                v = ref.m[i][k] + ref.m[k][j];
+                ref.m[i][j] = sr.add(ref.m[i][j], v);
+            }
+    bOk = semiringClosure(&d, &sr) && sameMatrix(&d, &ref);
+    free2D(&d);
+    free2D(&ref);
+    return bOk;
+}
+
+/*****************************   checkClosure   *************************
+ * static void checkClosure(void)
+ *
+ * Description: Min-plus and max-plus closures with unreachable pairs,
+ * which must stay at the semiring zero whatever the weights.
+ ***********************************************************************/
+static void checkClosure(void)
+{
+    Semiring sr;
+    Matrix d;
+    FILE *out = tmpfile();
+    int bOk;
+    metricsEnable(out);
+    // one edge 0 -> 1 of weight -5, nothing reaches 2 or leaves it
+    semiringInit(&sr, SEMIRING_MIN_PLUS);
+    setUp2D(&d, 3, 3, FALSE);
+    fillValue(&d, SEMIRING_INF);
+    d.m[0][1] = -5;
+    bOk = semiringClosure(&d, &sr) && d.m[0][1] == -5 &&
+          d.m[0][2] == SEMIRING_INF && d.m[2][1] == SEMIRING_INF &&
+          d.m[1][0] == SEMIRING_INF && d.m[2][2] == 0 &&
+          metricsHas("semiring");
+    metricsEnable(NULL);
+    if (out != NULL)
+        fclose(out);
+    free2D(&d);
+    report("semiringClosure unreachable", bOk);
+    report("semiringClosure min-plus",
+           closureCase(SEMIRING_MIN_PLUS, 120, FALSE, 1, 50));
+    report("semiringClosure min-plus negative",
+           closureCase(SEMIRING_MIN_PLUS, 120, TRUE, -50, 20));
+    report("semiringClosure max-plus",
+           closureCase(SEMIRING_MAX_PLUS, 120, TRUE, 1, 50));
+}
+
+/******************************   checkPower   **************************
+ * static void checkPower(void)
+ *
+ * Description: matrixPower for k = 0, 1 and 11, exact and modulo a
+ * prime, against repeated naive products.
+ ***********************************************************************/
+static void checkPower(void)
+{
+    Matrix a;
+    Matrix c;
+    Matrix ref;
+    Matrix next;
+    int powers[3] = { 0, 1, 11 };
+    int bOk = TRUE;
+    int modulus;
+    int p;
+    int s;
+    int i;
+    int j;
+    setUp2D(&a, 23, 23, FALSE);
+    setUp2D(&c, 23, 23, FALSE);
+    setUp2D(&ref, 23, 23, FALSE);
+    setUp2D(&next, 23, 23, FALSE);
+    fillBits(&a, 15);
+    for (modulus = 0; modulus <= 97; modulus += 97)
+        for (p = 0; p < 3; p++)
+        {
+            fillZeroes2D(&ref);
+            for (i = 0; i < ref.rows; i++)
+                ref.m[i][i] = 1;
+            for (s = 0; s < powers[p]; s++)
+            {
+                fillZeroes2D(&next);
+                naiveMultiply(&ref, &a, &next);
+                for (i = 0; i < next.rows; i++)
+                    for (j = 0; j < next.cols; j++)
+                        if (modulus > 0)
+                            next.m[i][j] %= modulus;
+                copyMatrix(&ref, &next);
+            }
+            bOk = bOk && matrixPower(&a, powers[p], &c, modulus) &&
+                  sameMatrix(&c, &ref);
+        }
+    bOk = bOk && !matrixPower(&a, 2, &a, 0);
+    report("matrixPower", bOk);
+    free2D(&a);
+    free2D(&c);
+    free2D(&ref);
+    free2D(&next);
+}
+
+/*****************************   checkChain   ***************************
+ * static void checkChain(void)
+ *
+ * Description: multiplyChain and chainEval of five ragged operands
+ * against naive products taken left to right.
+ ***********************************************************************/
+static void checkChain(void)
+{
+    Matrix mats[5];
+    Matrix *ptrs[5];
+    Matrix c;
+    Matrix ref;
+    Matrix next;
+    ChainExpr e;
+    int dims[6] = { 13, 70, 4, 55, 9, 31 };
+    int bOk;
+    int i;
+    for (i = 0; i < 5; i++)
+    {
+        setUp2D(&mats[i], dims[i], dims[i + 1], TRUE);
+        ptrs[i] = &mats[i];
+    }
+    setUp2D(&ref, dims[0], dims[1], FALSE);
+    copyMatrix(&ref, &mats[0]);
+    for (i = 1; i < 5; i++)
+    {
+        setUp2D(&next, dims[0], dims[i + 1], FALSE);
+        naiveMultiply(&ref, &mats[i], &next);
+        free2D(&ref);
+        ref = next;
+    }
+    setUp2D(&c, dims[0], dims[5], FALSE);
+    bOk = multiplyChain(ptrs, 5, &c) && sameMatrix(&c, &ref);
+    report("multiplyChain", bOk);
+    fillZeroes2D(&c);
+    chainBegin(&e, &mats[0]);
+    for (i = 1; i < 5; i++)
+        chainTimes(&e, &mats[i]);
+    bOk = chainEval(&e, &c) && sameMatrix(&c, &ref);
+    report("chainEval", bOk);
+    for (i = 0; i < 5; i++)
+        free2D(&mats[i]);
+    free2D(&c);
+    free2D(&ref);
+}
+
+/****************************   naiveMultiplyView   *********************
+ * static void naiveMultiplyView(MatrixView *a, MatrixView *b,
+ *                               MatrixView *c)
+ *
+ * Description: Reference c += a*b over views, element by element with
+ * VIEW_AT.
+ ***********************************************************************/
+static void naiveMultiplyView(MatrixView *a, MatrixView *b, MatrixView *c)
+{
+    int i;
+    int j;
+    int k;
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < b->cols; j++)
+            for (k = 0; k < a->cols; k++)
+                VIEW_AT(c, i, j) += VIEW_AT(a, i, k) * VIEW_AT(b, k, j);
+}
+
+/*****************************   checkViews   ***************************
+ * static void checkViews(void)
+ *
+ * Description: multiplyView with a block of a transposed A, a block of
+ * a transposed B and a block of a larger C. Elements of C outside the
+ * block must be left alone.
+ ***********************************************************************/
+static void checkViews(void)
+{
+    Matrix a;
+    Matrix bT;
+    Matrix c;
+    Matrix ref;
+    MatrixView pa;
+    MatrixView pb;
+    MatrixView va;
+    MatrixView vb;
+    MatrixView vc;
+    int bOk;
+    setUp2D(&a, 80, 50, TRUE);
+    setUp2D(&bT, 75, 60, TRUE);
+    setUp2D(&c, 100, 100, FALSE);
+    setUp2D(&ref, 100, 100, FALSE);
+    fillValue(&c, 1);
+    fillValue(&ref, 1);
+    // A is 41x60 of a^T, B is 60x70 of bT^T
+    makeView(&pa, &a, TRUE);
+    makeView(&pb, &bT, TRUE);
+    bOk = subView(&va, &pa, 4, 7, 41, 60) &&
+          subView(&vb, &pb, 0, 5, 60, 70);
+    makeView(&pa, &c, FALSE);
+    bOk = bOk && subView(&vc, &pa, 20, 15, 41, 70);
+    bOk = bOk && multiplyView(&va, &vb, &vc);
+    makeView(&pa, &ref, FALSE);
+    subView(&vc, &pa, 20, 15, 41, 70);
+    naiveMultiplyView(&va, &vb, &vc);
+    report("multiplyView transposed blocks", bOk && sameMatrix(&c, &ref));
+    makeView(&pb, &bT, FALSE);
+    bOk = !subView(&vb, &pb, 70, 0, 10, 60);
+    report("subView out of range refused", bOk);
+    free2D(&a);
+    free2D(&bT);
+    free2D(&c);
+    free2D(&ref);
+}
+
+/***************************   checkEpilogue   **************************
+ * static void checkEpilogue(void)
+ *
+ * Description: multiplyEpilogue with a chain of operations, against
+ * the reference multiply with the operations applied afterwards.
+ ***********************************************************************/
+static void checkEpilogue(void)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix ref;
+    MatrixView va;
+    MatrixView vb;
+    MatrixView vc;
+    Epilogue e;
+    int rowBias[45];
+    int colBias[37];
+    int i;
+    int j;
+    int v;
+    int bOk;
+    setUp2D(&a, 37, 29, TRUE);
+    setUp2D(&b, 29, 45, TRUE);
+    setUp2D(&c, 37, 45, TRUE);
+    setUp2D(&ref, 37, 45, FALSE);
+    copyMatrix(&ref, &c);
+    for (j = 0; j < 45; j++)
+        rowBias[j] = j * 7 - 150;
+    for (i = 0; i < 37; i++)
+        colBias[i] = 90 - i * 5;
+    makeView(&va, &a, FALSE);
+    makeView(&vb, &b, FALSE);
+    makeView(&vc, &c, FALSE);
+    epilogueInit(&e);
+    bOk = epilogueAdd(&e, EPI_BIAS_ROW, 0, 0, rowBias) &&
+          epilogueAdd(&e, EPI_BIAS_COL, 0, 0, colBias) &&
+          epilogueAdd(&e, EPI_SCALE, -3, 0, NULL) &&
+          epilogueAdd(&e, EPI_CLAMP, -500, 300, NULL) &&
+          epilogueAdd(&e, EPI_RELU, 0, 0, NULL) &&
+          epilogueAdd(&e, EPI_MOD, 7, 0, NULL);
+    bOk = bOk && multiplyEpilogue(&va, &vb, &vc, &e);
+    naiveMultiply(&a, &b, &ref);
+    for (i = 0; i < 37; i++)
+    {
+        for (j = 0; j < 45; j++)
+        {
+            v = (ref.m[i][j] + rowBias[j] + colBias[i]) * -3;
+            v = v < -500 ? -500 : (v > 300 ? 300 : v);
+            v = v < 0 ? 0 : v;
+            ref.m[i][j] = v % 7;
+        }
+    }
+    report("multiplyEpilogue", bOk && sameMatrix(&c, &ref));
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&ref);
+}
+
+/*****************************   shutdownLoop   *************************
+ * static void *shutdownLoop(void *arg)
+ *
+ * Description: Thread body for checkAsync, stops the executor
+ * ASYNC_ROUNDS times while the main thread keeps queueing.
+ ***********************************************************************/
+#define ASYNC_ROUNDS 200
+static void *shutdownLoop(void *arg)
+{
+    int i;
+    (void) arg;
+    for (i = 0; i < ASYNC_ROUNDS; i++)
+        asyncShutdown();
+    return NULL;
+}
+
+/*****************************   checkAsync   ***************************
+ * static void checkAsync(void)
+ *
+ * Description: A dependent pair of async products, then products
+ * queued while another thread keeps shutting the executor down. Every
+ * task must finish with the right result.
+ ***********************************************************************/
+static void checkAsync(void)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix d;
+    Matrix e;
+    Matrix ref;
+    Matrix refD;
+    MatrixTask *t1;
+    MatrixTask *t2;
+    pthread_t stopper;
+    int i;
+    int bOk = TRUE;
+    setUp2D(&a, 30, 40, TRUE);
+    setUp2D(&b, 40, 25, TRUE);
+    setUp2D(&c, 30, 25, FALSE);
+    setUp2D(&d, 30, 20, FALSE);
+    setUp2D(&e, 25, 20, TRUE);
+    setUp2D(&ref, 30, 25, FALSE);
+    setUp2D(&refD, 30, 20, FALSE);
+    // d = (a*b)*e, the second product queued before the first is done
+    t1 = multiplyAsync(&a, &b, &c, NULL, 0, NULL, NULL);
+    t2 = multiplyAsync(&c, &e, &d, &t1, 1, NULL, NULL);
+    bOk = taskWait(t2) && taskWait(t1);
+    naiveMultiply(&a, &b, &ref);
+    naiveMultiply(&ref, &e, &refD);
+    report("multiplyAsync with dependency",
+           bOk && sameMatrix(&c, &ref) && sameMatrix(&d, &refD));
+    taskFree(t1);
+    taskFree(t2);
+    fillValue(&c, 0);
+    bOk = pthread_create(&stopper, NULL, shutdownLoop, NULL) == 0;
+    for (i = 0; bOk && i < ASYNC_ROUNDS; i++)
+    {
+        t1 = multiplyAsync(&a, &b, &c, NULL, 0, NULL, NULL);
+        bOk = taskWait(t1);
+        taskFree(t1);
+    }
+    if (bOk)
+        pthread_join(stopper, NULL);
+    fillValue(&ref, 0);
+    for (i = 0; i < ASYNC_ROUNDS; i++)
+        naiveMultiply(&a, &b, &ref);
+    report("multiplyAsync during asyncShutdown",
+           bOk && sameMatrix(&c, &ref));
+    asyncShutdown();
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&d);
+    free2D(&e);
+    free2D(&ref);
+    free2D(&refD);
+}
+
+/*****************************   checkCache   ***************************
+ * static void checkCache(void)
+ *
+ * Description: Repeated products through the cache, with a changed
+ * operand, and with a budget small enough that one product is spilled
+ * to disk and read back.
+ ***********************************************************************/
+static void checkCache(void)
+{
+    Matrix a;
+    Matrix b;
+    Matrix b2;
+    Matrix c;
+    Matrix ref;
+    char dir[] = "/tmp/mmcheckXXXXXX";
+    long long numHits;
+    long long numMisses;
+    long long hits0;
+    long long misses0;
+    int bOk;
+    setUp2D(&a, 45, 38, TRUE);
+    setUp2D(&b, 38, 52, TRUE);
+    setUp2D(&b2, 38, 52, TRUE);
+    setUp2D(&c, 45, 52, TRUE);
+    setUp2D(&ref, 45, 52, FALSE);
+    copyMatrix(&ref, &c);
+    cacheStats(&hits0, &misses0);
+    cacheEnable(1 << 20, NULL);
+    // miss, hit, then a miss once A has changed
+    bOk = multiply(&a, &b, &c) && multiply(&a, &b, &c);
+    naiveMultiply(&a, &b, &ref);
+    naiveMultiply(&a, &b, &ref);
+    a.m[44][37]++;
+    bOk = bOk && multiply(&a, &b, &c);
+    naiveMultiply(&a, &b, &ref);
+    cacheStats(&numHits, &numMisses);
+    report("multiplyCached", bOk && sameMatrix(&c, &ref) &&
+           numHits - hits0 == 1 && numMisses - misses0 == 2);
+    // room for one product, the other goes to dir
+    bOk = mkdtemp(dir) != NULL;
+    cacheClear();
+    cacheEnable(45 * 52 * sizeof(int) + 1024, dir);
+    bOk = bOk && multiply(&a, &b, &c) && multiply(&a, &b2, &c) &&
+          multiply(&a, &b, &c);
+    naiveMultiply(&a, &b, &ref);
+    naiveMultiply(&a, &b2, &ref);
+    naiveMultiply(&a, &b, &ref);
+    cacheStats(&hits0, &misses0);
+    report("multiplyCached spilled", bOk && sameMatrix(&c, &ref) &&
+           hits0 - numHits == 1 && misses0 - numMisses == 2);
+    cacheEnable(0, NULL);
+    rmdir(dir);
+    free2D(&a);
+    free2D(&b);
+    free2D(&b2);
+    free2D(&c);
+    free2D(&ref);
+}
+
+/**************************   checkIncremental   ************************
+ * static void checkIncremental(void)
+ *
+ * Description: Row updates of A and B and a scattered delta, each
+ * applied to a maintained C, which must match a fresh product of the
+ * final A and B added to C's starting values.
+ ***********************************************************************/
+static void checkIncremental(void)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix ref;
+    MatrixDelta d;
+    int rowA[33];
+    int rowB[47];
+    int i;
+    int bOk;
+    setUp2D(&a, 40, 33, TRUE);
+    setUp2D(&b, 33, 47, TRUE);
+    setUp2D(&c, 40, 47, TRUE);
+    setUp2D(&ref, 40, 47, FALSE);
+    copyMatrix(&ref, &c);
+    bOk = multiply(&a, &b, &c);
+    for (i = 0; i < 33; i++)
+        rowA[i] = rand() % 21 - 10;
+    for (i = 0; i < 47; i++)
+        rowB[i] = rand() % 21 - 10;
+    bOk = bOk && updateRowA(&a, &b, &c, 5, rowA) &&
+          updateRowB(&a, &b, &c, 32, rowB);
+    deltaInit(&d);
+    for (i = 0; i < 12; i++)
+    {
+        deltaSet(&d, FALSE, rand() % 40, rand() % 33, rand() % 50);
+        deltaSet(&d, TRUE, rand() % 33, rand() % 47, rand() % 50);
+    }
+    // set twice, the last value wins
+    deltaSet(&d, TRUE, 3, 4, 99);
+    deltaSet(&d, TRUE, 3, 4, -7);
+    bOk = bOk && deltaApply(&a, &b, &c, &d);
+    deltaFree(&d);
+    naiveMultiply(&a, &b, &ref);
+    report("updateRowA, updateRowB, deltaApply",
+           bOk && b.m[3][4] == -7 && sameMatrix(&c, &ref));
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&ref);
+}
+
+/*****************************   checkSyrk   ****************************
+ * static void checkSyrk(void)
+ *
+ * Description: syrk on one triangle without mirroring, so the other
+ * must keep its values, and on the other triangle of A^T*A mirrored.
+ ***********************************************************************/
+static void checkSyrk(void)
+{
+    Matrix a;
+    Matrix t;
+    Matrix c;
+    Matrix ref;
+    int i;
+    int j;
+    int bOk;
+    setUp2D(&a, 150, 37, TRUE);
+    setUp2D(&t, 37, 150, FALSE);
+    for (i = 0; i < 150; i++)
+        for (j = 0; j < 37; j++)
+            t.m[j][i] = a.m[i][j];
+    setUp2D(&c, 150, 150, FALSE);
+    setUp2D(&ref, 150, 150, FALSE);
+    fillValue(&c, 1);
+    fillValue(&ref, 1);
+    bOk = syrk(&a, &c, FALSE, UPLO_UPPER, FALSE);
+    naiveMultiply(&a, &t, &ref);
+    for (i = 0; i < 150; i++)
+        for (j = 0; j < i; j++)
+            ref.m[i][j] = 1;
+    report("syrk upper", bOk && sameMatrix(&c, &ref));
+    free2D(&c);
+    free2D(&ref);
+    setUp2D(&c, 37, 37, FALSE);
+    setUp2D(&ref, 37, 37, FALSE);
+    bOk = syrk(&a, &c, TRUE, UPLO_LOWER, TRUE);
+    naiveMultiply(&t, &a, &ref);
+    report("syrk transposed lower, mirrored", bOk && sameMatrix(&c, &ref));
+    free2D(&a);
+    free2D(&t);
+    free2D(&c);
+    free2D(&ref);
+}
+
+/*****************************   checkBand   ****************************
+ * static void checkBand(void)
+ *
+ * Description: Band times dense, band times band, and packed
+ * triangular times dense for both triangles, each recorded in the
+ * metrics under its own backend.
+ ***********************************************************************/
+static void checkBand(void)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix ref;
+    Matrix dense;
+    BandMatrix ba;
+    BandMatrix bb;
+    BandMatrix bc;
+    TriMatrix t;
+    FILE *out = tmpfile();
+    int uplo;
+    int i;
+    int j;
+    int bOk;
+    metricsEnable(out);
+    setUp2D(&a, 70, 55, TRUE);
+    setUp2D(&b, 55, 60, TRUE);
+    setUp2D(&c, 70, 60, TRUE);
+    setUp2D(&ref, 70, 60, FALSE);
+    setUp2D(&dense, 70, 55, FALSE);
+    copyMatrix(&ref, &c);
+    bandFromDense(&ba, &a, 3, 5);
+    bandToDense(&ba, &dense);
+    bOk = bandMultiply(&ba, &b, &c);
+    naiveMultiply(&dense, &b, &ref);
+    report("bandMultiply", bOk && sameMatrix(&c, &ref) &&
+           metricsHas("band"));
+    bandFromDense(&bb, &b, 2, 4);
+    bandInit(&bc, 70, 60, 5, 9);
+    bOk = bandBandMultiply(&ba, &bb, &bc);
+    free2D(&b);
+    setUp2D(&b, 55, 60, FALSE);
+    bandToDense(&bb, &b);
+    fillZeroes2D(&ref);
+    naiveMultiply(&dense, &b, &ref);
+    bandToDense(&bc, &c);
+    bandFree(&bc);
+    bandInit(&bc, 70, 60, 4, 9);
+    bOk = bOk && !bandBandMultiply(&ba, &bb, &bc);
+    report("bandBandMultiply", bOk && sameMatrix(&c, &ref));
+    free2D(&a);
+    free2D(&c);
+    free2D(&ref);
+    free2D(&dense);
+    setUp2D(&a, 55, 55, TRUE);
+    setUp2D(&dense, 55, 55, FALSE);
+    setUp2D(&c, 55, 60, TRUE);
+    setUp2D(&ref, 55, 60, FALSE);
+    for (uplo = UPLO_UPPER; uplo <= UPLO_LOWER; uplo++)
+    {
+        copyMatrix(&ref, &c);
+        triFromDense(&t, &a, uplo);
+        bOk = trmm(&t, &b, &c);
+        for (i = 0; i < 55; i++)
+            for (j = 0; j < 55; j++)
+                dense.m[i][j] = (uplo == UPLO_UPPER ? j < i : j > i) ?
+                                0 : a.m[i][j];
+        naiveMultiply(&dense, &b, &ref);
+        report(uplo == UPLO_UPPER ? "trmm upper" : "trmm lower",
+               bOk && sameMatrix(&c, &ref) && metricsHas("trmm"));
+        triFree(&t);
+    }
+    metricsEnable(NULL);
+    if (out != NULL)
+        fclose(out);
+    bandFree(&ba);
+    bandFree(&bb);
+    bandFree(&bc);
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&ref);
+    free2D(&dense);
+}
+
+/****************************   zeroSomeTiles   *************************
+ * static void zeroSomeTiles(Matrix *a, int tile)
+ *
+ * Description: Clears every third tile of a, on a diagonal pattern.
+ ***********************************************************************/
+static void zeroSomeTiles(Matrix *a, int tile)
+{
+    int i;
+    int j;
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < a->cols; j++)
+            if ((i / tile + j / tile) % 3 == 0)
+                a->m[i][j] = 0;
+}
+
+/****************************   checkBsparse   **************************
+ * static void checkBsparse(void)
+ *
+ * Description: Block-sparse products with ragged edge tiles and with
+ * an operand that has no tiles at all, and a round trip back to dense.
+ ***********************************************************************/
+static void checkBsparse(void)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    Matrix ref;
+    Matrix zero;
+    BlockSparse sa;
+    BlockSparse sb;
+    BlockSparse sz;
+    FILE *out = tmpfile();
+    int bOk;
+    metricsEnable(out);
+    setUp2D(&a, 150, 130, TRUE);
+    setUp2D(&b, 130, 90, TRUE);
+    setUp2D(&c, 150, 90, TRUE);
+    setUp2D(&ref, 150, 90, FALSE);
+    setUp2D(&zero, 130, 90, FALSE);
+    zeroSomeTiles(&a, 32);
+    zeroSomeTiles(&b, 32);
+    copyMatrix(&ref, &c);
+    bsparseFromMatrix(&sa, &a, 32);
+    bsparseFromMatrix(&sb, &b, 32);
+    bsparseFromMatrix(&sz, &zero, 32);
+    bOk = bsparseMultiply(&sa, &sb, &c) && bsparseMultiply(&sa, &sz, &c);
+    naiveMultiply(&a, &b, &ref);
+    report("bsparseMultiply", bOk && sz.numPresent == 0 &&
+           sameMatrix(&c, &ref) && metricsHas("bsparse"));
+    bsparseToMatrix(&sb, &zero);
+    report("bsparseToMatrix", sameMatrix(&zero, &b));
+    metricsEnable(NULL);
+    if (out != NULL)
+        fclose(out);
+    bsparseFree(&sa);
+    bsparseFree(&sb);
+    bsparseFree(&sz);
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+    free2D(&ref);
+    free2D(&zero);
+}
+
+int main(void)
+{
+    srand(410);
+    checkMultiply();
+    checkTranspose();
+    checkMorton();
+    checkBits();
+    checkModular();
+    checkClosure();
+    checkPower();
+    checkChain();
+    checkViews();
+    checkEpilogue();
+    checkAsync();
+    checkCache();
+    checkIncremental();
+    checkSyrk();
+    checkBand();
+    checkBsparse();
+    printf("%d check%s failed\n", numFailed, numFailed == 1 ? "" : "s");
+    return numFailed == 0 ? 0 : 1;
+}
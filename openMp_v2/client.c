@@ -0,0 +1,205 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "define.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/***********************************************************************
+ * client.c written by DSU_410 team ...
+ *
+ * Description: Client side of the multiply service, see server.c.
+ * remoteAlloc gives the caller three ordinary Matrix structures whose
+ * storage is a memfd. The caller fills A and B in place, remoteMultiply
+ * hands the memfd to the daemon, and C is read back in place. The
+ * memfd's size is sealed, which the daemon requires, so it cannot be
+ * truncated under the daemon's mapping.
+ *
+ * Functions:
+ * - servedBytes
+ * - remoteAlloc
+ * - remoteMultiply
+ * - serveSend
+ * - remoteFree
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/*****************************   servedBytes   **************************
+ * size_t servedBytes(int n, int p, int m)
+ *
+ * Description: Bytes of shared memory for an n-by-p A, a p-by-m B and
+ * an n-by-m C stored one after another.
+ ***********************************************************************/
+size_t servedBytes(int n, int p, int m)
+{
+    return sizeof(int) * ((size_t) n * p + (size_t) p * m + (size_t) n * m);
+}
+
+/******************************   viewShared   **************************
+ * static void viewShared(Matrix *a, int *data, int numRows, int numCols)
+ *
+ * Description: Points a Matrix's rows into the shared mapping.
+ ***********************************************************************/
+static void viewShared(Matrix *a, int *data, int numRows, int numCols)
+{
+    int i;
+    a->rows = numRows;
+    a->cols = numCols;
+    a->m = malloc(sizeof(int *) * numRows);
+    if (a->m == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    for (i = 0; i < numRows; i++)
+        a->m[i] = data + (size_t) i * numCols;
+}
+
+/******************************   remoteAlloc   *************************
+ * int remoteAlloc(RemoteMatrices *r, int n, int p, int m)
+ *
+ * Description: Creates shared storage for one request. C starts zeroed.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * r             out         ptr to RemoteMatrices structure, see
+ *                           define.h. r->a is n-by-p, r->b p-by-m and
+ *                           r->c n-by-m.
+ * n, p, m       in          Sizes, all > 0.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Storage ready, release with remoteFree.
+ * FALSE         Bad sizes, or the system refused the memfd or its
+ *               seals.
+ ***********************************************************************/
+int remoteAlloc(RemoteMatrices *r, int n, int p, int m)
+{
+    int *base;
+    if (n <= 0 || p <= 0 || m <= 0)
+        return FALSE;
+    r->bytes = servedBytes(n, p, m);
+    r->fd = memfd_create("matrix", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (r->fd < 0)
+        return FALSE;
+    base = MAP_FAILED;
+    if (ftruncate(r->fd, r->bytes) == 0 &&
+        fcntl(r->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) == 0)
+        base = mmap(NULL, r->bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    r->fd, 0);
+    if (base == MAP_FAILED)
+    {
+        close(r->fd);
+        return FALSE;
+    }
+    r->base = base;
+    viewShared(&r->a, base, n, p);
+    viewShared(&r->b, base + (size_t) n * p, p, m);
+    viewShared(&r->c, base + (size_t) n * p + (size_t) p * m, n, m);
+    return TRUE;
+}
+
+/*****************************   remoteMultiply   ***********************
+ * int remoteMultiply(const char *path, RemoteMatrices *r)
+ *
+ * Description: Asks the daemon listening on path to add r->a * r->b to
+ * r->c, and waits for it to finish.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * path          in          Socket file given to serveMatrices.
+ * r             in/out      ptr to RemoteMatrices from remoteAlloc.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * SERVE_OK      r->c updated.
+ * SERVE_BUSY    Daemon queue full, nothing done, try again later.
+ * SERVE_ERROR   No daemon, or the request was refused.
+ ***********************************************************************/
+int remoteMultiply(const char *path, RemoteMatrices *r)
+{
+    ServeRequest req;
+    req.op = SERVE_MULTIPLY;
+    req.n = r->a.rows;
+    req.p = r->a.cols;
+    req.m = r->b.cols;
+    return serveSend(path, &req, r->fd);
+}
+
+/******************************   serveSend   ***************************
+ * int serveSend(const char *path, ServeRequest *req, int fd)
+ *
+ * Description: Sends one request, with fd attached unless it is -1, and
+ * waits for the reply. Used directly for SERVE_SHUTDOWN.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * status        SERVE_* reply from the daemon, SERVE_ERROR if none.
+ ***********************************************************************/
+int serveSend(const char *path, ServeRequest *req, int fd)
+{
+    struct sockaddr_un addr;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cm;
+    char control[CMSG_SPACE(sizeof(int))];
+    ServeReply reply;
+    int conn;
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return SERVE_ERROR;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    conn = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn < 0)
+        return SERVE_ERROR;
+    if (connect(conn, (struct sockaddr *) &addr, sizeof(addr)) != 0)
+    {
+        close(conn);
+        return SERVE_ERROR;
+    }
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = req;
+    iov.iov_len = sizeof(*req);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (fd >= 0)
+    {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+    }
+    reply.status = SERVE_ERROR;
+    if (sendmsg(conn, &msg, MSG_NOSIGNAL) != sizeof(*req) ||
+        recv(conn, &reply, sizeof(reply), MSG_WAITALL) != sizeof(reply))
+        reply.status = SERVE_ERROR;
+    close(conn);
+    return reply.status;
+}
+
+/******************************   remoteFree   **************************
+ * void remoteFree(RemoteMatrices *r)
+ *
+ * Description: Releases storage made by remoteAlloc.
+ ***********************************************************************/
+void remoteFree(RemoteMatrices *r)
+{
+    free(r->a.m);
+    free(r->b.m);
+    free(r->c.m);
+    munmap(r->base, r->bytes);
+    close(r->fd);
+}
@@ -3,9 +3,51 @@
 
 /***** Librarys/Headers ****/
 #include <stdio.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /**** Structs ****/
+// Region based allocator for Matrix buffers, see arena.c
+#define ARENA_CLASSES       48   // power-of-two size classes
+typedef struct
+{
+    char **base;            // start of each mapped region
+    size_t *size;           // bytes in each region
+    int numRegions;
+    int capRegions;
+    int current;            // region bump allocation is using, -1 none
+    size_t used;            // bytes handed out from current region
+    size_t regionSize;      // bytes mapped at a time
+    int hugeMode;           // ARENA_HUGE_* asked for, | ARENA_PREFAULT
+    int *backing;           // ARENA_HUGE_* obtained for each region
+    void *freeList[ARENA_CLASSES];  // freed blocks per size class
+    long regionsMapped;     // system allocations made so far
+} MatrixArena;
+
+// Bump position saved by arenaMark
+typedef struct
+{
+    int region;
+    size_t used;
+} ArenaMark;
+
+// Hardware counters for one phase on one thread, see perf.c
+#define PERF_EVENTS         5
+typedef struct
+{
+    int fd[PERF_EVENTS];            // counter descriptors, -1 unavailable
+    long long value[PERF_EVENTS];   // counts, -1 unavailable
+    long long wallNs;               // elapsed wall time
+    struct timespec start;
+    int *taskFd;                    // other threads, perfStartProcess
+    int numTasks;                   // PERF_EVENTS fds each in taskFd
+} PerfCounters;
+
 typedef struct
 {
     int rows;
@@ -13,6 +55,191 @@ typedef struct
     int **m;    // 2D matrix
 } Matrix;
 
+// Zero-copy window into a Matrix, optionally transposed. Rows are
+// reached through the Matrix's own row pointers (which play the part
+// of the leading dimension), so blocks of any Matrix can be viewed.
+typedef struct
+{
+    int **m;    // row pointers of the underlying storage, offset to block
+    int col0;   // column offset of the block within each storage row
+    int rows;   // logical rows (after any transpose)
+    int cols;   // logical columns (after any transpose)
+    int bTrans; // TRUE when logical (i, j) is storage (j, i)
+} MatrixView;
+
+// Lazily built chain product A*B*C..., evaluated by chainEval
+#define MAX_CHAIN           32   // most operands in one chain product
+typedef struct
+{
+    Matrix *mats[MAX_CHAIN];
+    int count;
+    int bValid; // FALSE once an undefined link was appended
+} ChainExpr;
+
+// Element-wise operation fused into the multiply, see epilogue.c
+typedef struct
+{
+    int op;     // EPI_* constant
+    int x;      // scale factor, or clamp low bound
+    int y;      // clamp high bound
+    int *vec;   // bias values, per column (EPI_BIAS_ROW) or row of C
+} EpilogueOp;
+
+#define MAX_EPILOGUE        8    // most operations in one epilogue
+typedef struct
+{
+    EpilogueOp ops[MAX_EPILOGUE];
+    int count;
+} Epilogue;
+
+// Multiply parameters for one shape class, see tune.c
+typedef struct
+{
+    int blockM;     // tile sizes, in place of BLOCK_M, BLOCK_N, BLOCK_K
+    int blockN;
+    int blockK;
+    int numThreads; // team size, 0 for MAX_THREADS()
+    int schedule;   // SCHED_* constant
+} TuneParams;
+
+// Byte streams between the ranks of a distributed multiply, filled in
+// by transportInit, see transport.c
+typedef struct Transport
+{
+    int rank;       // this process, -1 until attach
+    int size;       // number of ranks
+    int kind;       // TRANSPORT_* constant
+    void *state;    // private to the transport
+    int (*send)(struct Transport *t, int peer, const void *buf,
+                size_t bytes);
+    int (*recv)(struct Transport *t, int peer, void *buf, size_t bytes);
+    void (*attach)(struct Transport *t, int rank);
+    void (*destroy)(struct Transport *t);
+} Transport;
+
+// Request to the multiply service, see server.c. Sent with a memfd
+// holding A (n-by-p), B (p-by-m) and C (n-by-m) one after another.
+typedef struct
+{
+    int op;     // SERVE_MULTIPLY or SERVE_SHUTDOWN
+    int n;
+    int p;
+    int m;
+} ServeRequest;
+
+typedef struct
+{
+    int status; // SERVE_OK, SERVE_BUSY or SERVE_ERROR
+} ServeReply;
+
+// Client side shared storage for one request, see client.c
+typedef struct
+{
+    int fd;         // memfd passed to the service
+    int *base;      // mapping of the memfd
+    size_t bytes;
+    Matrix a;       // rows point into the mapping
+    Matrix b;
+    Matrix c;
+} RemoteMatrices;
+
+// Handle for a queued multiply, see async.c
+struct MatrixTask;
+typedef void (*TaskCallback)(struct MatrixTask *t, void *arg);
+typedef struct MatrixTask
+{
+    Matrix *a;
+    Matrix *b;
+    Matrix *c;
+    int result;                     // multiply's return, once done
+    int state;                      // TASK_* constant
+    int numDeps;                    // dependencies not yet finished
+    int bDepFailed;                 // TRUE skips the multiply
+    TaskCallback callback;
+    void *arg;
+    struct TaskLink *dependents;    // tasks waiting on this one
+    struct MatrixTask *next;        // ready queue
+} MatrixTask;
+
+// Batched element changes to A and B, see incremental.c
+typedef struct
+{
+    int bOfB;   // TRUE for an element of B
+    int row;
+    int col;
+    int value;  // new value
+} DeltaEntry;
+
+typedef struct
+{
+    DeltaEntry *entries;
+    int count;
+    int capacity;
+} MatrixDelta;
+
+// Band matrix, a(i, j) stored for i - lower <= j <= i + upper, see band.c
+typedef struct
+{
+    int rows;
+    int cols;
+    int lower;  // diagonals below the main one
+    int upper;  // diagonals above the main one
+    int *data;  // rows * (lower + upper + 1)
+} BandMatrix;
+
+// Square triangular matrix, packed by rows, see triangular.c
+typedef struct
+{
+    int n;
+    int uplo;   // UPLO_UPPER or UPLO_LOWER
+    int *data;  // n * (n + 1) / 2
+} TriMatrix;
+
+// Block-sparse matrix, only non-zero tiles stored, see blocksparse.c
+typedef struct
+{
+    int rows;
+    int cols;
+    int tile;           // tile side
+    int tilesR;         // tile grid
+    int tilesC;
+    int numPresent;     // non-zero tiles
+    uint64_t *present;  // bit ti * tilesC + tj set for non-zero tiles
+    int *index;         // per tile, its slot in data, -1 if absent
+    int *data;          // numPresent tiles, tile * tile row major each
+} BlockSparse;
+
+// Boolean matrix, 64 entries per word, rows padded to 512 bits, see
+// bitmatrix.c
+typedef struct
+{
+    int rows;
+    int cols;
+    int words;          // words per row, a multiple of BIT_ROW_WORDS
+    uint64_t *data;     // bit j of row i in word j / 64, bit j % 64
+} BitMatrix;
+
+// Semiring for semiringMultiply, c = add(c, mul(a, b)), see semiring.c
+typedef struct
+{
+    int kind;                   // SEMIRING_*, selects a specialised kernel
+    int zero;                   // identity of add, e.g. SEMIRING_INF
+    int one;                    // identity of mul
+    int (*add)(int x, int y);   // used by SEMIRING_GENERIC kernels
+    int (*mul)(int x, int y);
+} Semiring;
+
+// Matrix in tiles, tiles in Morton (Z curve) order, see morton.c
+typedef struct
+{
+    int rows;
+    int cols;
+    int tilesR;         // MORTON_TILE x MORTON_TILE tiles
+    int tilesC;
+    size_t numTiles;    // tiles stored, last tile's Morton position + 1
+    int *data;          // tile (ti, tj) at mortonEncode(ti, tj), row major
+} MortonMatrix;
+
 /**** Constants ****/
 // Booleans
 #define FALSE               0
@@ -21,9 +248,187 @@ typedef struct
 // Errors
 #define ARRAY_MEMORY_ERROR  10
 
+// Arena
+#define ARENA_ALIGN         64               // block alignment, bytes
+#define ARENA_REGION_SIZE   (64UL << 20)     // default region, 64 MB
+#define HUGE_PAGE_SIZE      (2UL << 20)      // 2 MB
+#define HUGE_PAGE_SIZE_1GB  (1UL << 30)      // 1 GB
+#define ARENA_HUGE_NONE     0                // 4 KB pages
+#define ARENA_HUGE_THP      1                // transparent, madvise
+#define ARENA_HUGE_2MB      2                // MAP_HUGETLB, else THP
+#define ARENA_HUGE_1GB      3                // MAP_HUGETLB, else 2 MB
+#define ARENA_HUGE_MASK     3
+#define ARENA_PREFAULT      4                // flag, touch in parallel
+
+// Performance counters, index into PerfCounters arrays
+#define PERF_CYCLES         0
+#define PERF_INSTRUCTIONS   1
+#define PERF_L1D_MISSES     2
+#define PERF_LLC_MISSES     3
+#define PERF_DTLB_MISSES    4
+
+// Metrics, see metrics.c
+#define METRIC_SLOTS        64   // shape classes per thread
+#define METRIC_BUCKETS      328  // latency histogram buckets, to ~2^42 ns
+#define BACKEND_BLOCKED     0    // multiplyEpilogue, blocked kernel
+#define BACKEND_DIST        1    // distMultiply, whole call on rank 0
+#define BACKEND_CACHE       2    // multiplyCached, answered from cache
+#define BACKEND_SYRK        3    // syrk, one triangle
+#define BACKEND_VECTOR      4    // multiplyVector, a dimension of 1
+#define BACKEND_BAND        5    // bandMultiply and bandBandMultiply
+#define BACKEND_TRMM        6    // trmm, packed triangular A
+#define BACKEND_BSPARSE     7    // bsparseMultiply, present tiles only
+#define BACKEND_BIT         8    // bitMultiply and bitCount
+#define BACKEND_M4RM        9    // m4rm, GF(2) or boolean
+#define BACKEND_SEMIRING    10   // semiringMultiply, any semiring
+#define BACKEND_MODULAR     11   // modMultiply and modMultiplyExact
+#define BACKEND_MORTON      12   // mortonMultiply, Z-order tiles
+#define NUM_BACKENDS        13
+
+// Binary matrix files, see save2D
+#define MATRIX_MAGIC        "MM2D"
+
 // Random numbers
 #define RANGE               4    // [0..RANGE)
 
+// Cache blocking used by multiplyView, sizes of the packed tiles
+#define BLOCK_M             64   // rows of A and C per tile
+#define BLOCK_N             64   // columns of B and C per tile
+#define BLOCK_K             256  // shared dimension per packed panel
+
+// Triangle of C updated by multiplyBlock and syrk
+#define UPLO_FULL           0
+#define UPLO_UPPER          1    // j >= i
+#define UPLO_LOWER          2    // j <= i
+
+// Epilogue operations, applied in order to each C value
+#define EPI_BIAS_ROW        1    // c += vec[column]
+#define EPI_BIAS_COL        2    // c += vec[row]
+#define EPI_SCALE           3    // c *= x
+#define EPI_CLAMP           4    // c = min(max(c, x), y)
+#define EPI_RELU            5    // c = max(c, 0)
+#define EPI_MOD             6    // c = c mod x, in [0..x)
+
+// Tuning, see tune.c
+#define SCHED_STATIC        0    // omp for schedule(static) over tiles
+#define SCHED_DYNAMIC       1    // omp for schedule(dynamic)
+#define TUNE_MAX_CLASSES    64   // shape classes in a profile
+#define TUNE_REPEATS        3    // timed runs per candidate, best kept
+#define TUNE_PROFILE        "mmtune.profile"
+
+// Distributed multiply, see dist.c and transport.c
+#define TRANSPORT_SOCKET    0    // Unix domain socket pairs
+#define TRANSPORT_SHM       1    // shared memory rings
+#define SHM_RING_SIZE       (256UL << 10)    // bytes per direction
+
+// Multiply service, see server.c and client.c
+#define SERVE_PATH          "/tmp/mmserve.sock"
+#define SERVE_MULTIPLY      1    // request ops
+#define SERVE_SHUTDOWN      2
+#define SERVE_OK            0    // reply status
+#define SERVE_BUSY          1    // queue full, retry later
+#define SERVE_ERROR         2    // bad request or no service
+#define SERVE_QUEUE_DEPTH   16   // requests waiting before SERVE_BUSY
+#define SERVE_MAX_DIM       65536
+#define SERVE_MAX_BYTES     (4UL << 30)
+#define SERVE_TIMEOUT_MS    1000 // to send a request once connected
+
+// Asynchronous multiply, see async.c
+#define ASYNC_WORKERS       2    // executor threads
+#define TASK_WAITING        0    // on dependencies or in the ready queue
+#define TASK_RUNNING        1
+#define TASK_DONE           2
+
+// Product cache, see cache.c
+#define CACHE_BUCKETS       1024 // hash table size
+#define CACHE_LANES         8    // 32-bit hash lanes per row
+#define CACHE_PATH_MAX      512
+#define CACHE_SPILL_MAX     (1ULL << 30)    // bytes of spilled products
+
+// Band and triangular kernels, see band.c and triangular.c
+#define BAND_ROW_BLOCK      32   // rows of C per parallel work item
+
+// Block-sparse matrices, see blocksparse.c
+#define BSPARSE_TILE_SIDE   64   // default tile side
+
+// Bit matrices, see bitmatrix.c
+#define BIT_ROW_WORDS       8    // row padding, one 512 bit vector
+#define BIT_ROW_BLOCK       16   // rows of C per parallel work item
+
+// Four Russians, see m4rm.c
+#define M4RM_BITS           8    // rows of B per table, divides 64
+#define M4RM_STRIPE_WORDS   32   // table width, 256 x 32 words = 64KB
+#define M4RM_ROW_BLOCK      2048 // rows of C per parallel work item
+
+// Semirings, see semiring.c
+#define SEMIRING_GENERIC    0    // add and mul through function pointers
+#define SEMIRING_PLUS_TIMES 1    // ordinary product
+#define SEMIRING_MIN_PLUS   2    // shortest paths
+#define SEMIRING_MAX_PLUS   3    // longest paths
+#define SEMIRING_MAX_MIN    4    // widest (bottleneck) paths
+#define SEMIRING_INF        (INT_MAX / 2)    // no path, min-plus zero
+
+// Exact products, see modular.c
+#define MOD_NUM_PRIMES      4    // CRT primes, ~2^112 covers any int product
+
+// Transposes, see transpose.c
+#define TRANSPOSE_BLOCK     64   // tile side, source + destination in L1
+#define TRANSPOSE_STREAM_BYTES  (8UL << 20)  // streaming stores from here
+
+// Morton order matrices, see morton.c
+#define MORTON_TILE         32   // leaf tile side, 3 tiles = 12KB of L1
+#define MORTON_TASK_TILES   4    // recursion below this is not tasked
+
+// Split shared dimension, see splitk.c
+#define SPLITK_MIN_K        4096        // shared dimension per slice
+#define SPLITK_MAX_C        (1 << 20)   // larger C is never split
+
+// Matrix-vector and outer products, see gemv.c
+#define GEMV_ROW_BLOCK      64   // rows of A per work item
+#define GEMV_COL_BLOCK      1024 // columns of B or C per work item
+
+/**** Macros ****/
+// Thread number inside parallel regions, and team size, with or
+// without OpenMP
+#ifdef _OPENMP
+#define THREAD_NUM()        omp_get_thread_num()
+#define MAX_THREADS()       omp_get_max_threads()
+#else
+#define THREAD_NUM()        0
+#define MAX_THREADS()       1
+#endif
+
+// Logical element (i, j) of a MatrixView
+#define VIEW_AT(v, i, j)    (*((v)->bTrans ? &(v)->m[(j)][(v)->col0 + (i)] \
+                                           : &(v)->m[(i)][(v)->col0 + (j)]))
+
+// Element (i, j) inside the band of a BandMatrix
+#define BAND_AT(b, i, j)    ((b)->data[(size_t) (i) * ((b)->lower + \
+                                (b)->upper + 1) + (j) - (i) + (b)->lower])
+
+// Element (i, j) inside the triangle of a TriMatrix. Upper row i starts
+// after i rows of lengths n, n-1, ...; lower row i after 1, 2, ..., i.
+#define TRI_AT(t, i, j)     ((t)->data[(t)->uplo == UPLO_UPPER ? \
+    (size_t) (i) * (t)->n - (size_t) (i) * ((i) - 1) / 2 + (j) - (i) : \
+    (size_t) (i) * ((i) + 1) / 2 + (j)])
+
+// Tile (ti, tj) of a BlockSparse, presence test and tile storage
+#define BSPARSE_HAS(s, ti, tj) \
+    (((s)->present[((ti) * (s)->tilesC + (tj)) >> 6] >> \
+      (((ti) * (s)->tilesC + (tj)) & 63)) & 1)
+#define BSPARSE_TILE(s, ti, tj) \
+    ((s)->data + (size_t) (s)->tile * (s)->tile * \
+                 (s)->index[(ti) * (s)->tilesC + (tj)])
+
+// Row i of a BitMatrix, and element (i, j) as 0 or 1
+#define BIT_ROW(b, i)       ((b)->data + (size_t) (i) * (b)->words)
+#define BIT_GET(b, i, j)    ((int) ((BIT_ROW(b, i)[(j) >> 6] >> \
+                                     ((j) & 63)) & 1))
+
+// Tile at Morton position z of a MortonMatrix
+#define MORTON_TILE_AT(a, z) \
+    ((a)->data + (size_t) (z) * MORTON_TILE * MORTON_TILE)
+
 /***** Function Prototypes *****/
 // main.c prototypes
 void test(Matrix *A, Matrix *B, Matrix *C);
@@ -38,9 +443,181 @@ void fillRandom2D(Matrix *a);
 void fillZeroes2D(Matrix *a);
 void print2D(Matrix *a);
 void free2D(Matrix *a);
+int save2D(Matrix *a, const char *path);
+int load2D(Matrix *a, const char *path);
 
 // matrix.c prototypes
 int isDefined(Matrix *a, Matrix *b);
 int multiply(Matrix *a, Matrix *b, Matrix *c);
+int multiplyView(MatrixView *a, MatrixView *b, MatrixView *c);
+int multiplyEpilogue(MatrixView *a, MatrixView *b, MatrixView *c,
+                     Epilogue *epi);
+void multiplyBlock(MatrixView *a, MatrixView *b, MatrixView *c, int row0,
+                   int col0, int uplo, Epilogue *epi, TuneParams *tp);
+
+// view.c prototypes
+void makeView(MatrixView *v, Matrix *a, int bTrans);
+int subView(MatrixView *v, MatrixView *parent, int row0, int col0,
+            int numRows, int numCols);
+void transposeView(MatrixView *v);
+int isDefinedView(MatrixView *a, MatrixView *b, MatrixView *c);
+
+// chain.c prototypes
+void chainBegin(ChainExpr *e, Matrix *a);
+ChainExpr *chainTimes(ChainExpr *e, Matrix *a);
+int chainEval(ChainExpr *e, Matrix *c);
+int multiplyChain(Matrix **mats, int count, Matrix *c);
+
+// epilogue.c prototypes
+void epilogueInit(Epilogue *e);
+int epilogueAdd(Epilogue *e, int op, int x, int y, int *vec);
+void applyEpilogue(Epilogue *e, int *tile, int numRows, int numCols,
+                   int row0, int col0);
+
+// arena.c prototypes
+void arenaInit(MatrixArena *ar, size_t regionSize, int hugeMode);
+void arenaDestroy(MatrixArena *ar);
+void *arenaAlloc(MatrixArena *ar, size_t bytes);
+void arenaFree(MatrixArena *ar, void *p);
+ArenaMark arenaMark(MatrixArena *ar);
+void arenaReset(MatrixArena *ar, ArenaMark mark);
+void arenaReport(MatrixArena *ar, FILE *fp);
+MatrixArena *setArena2D(MatrixArena *ar);
+MatrixArena *getArena2D(void);
+void *allocScratch(size_t bytes);
+void freeScratch(void *p);
+
+// perf.c prototypes
+void perfEnable(FILE *out);
+int perfEnabled(void);
+void perfStart(PerfCounters *pc);
+void perfStartProcess(PerfCounters *pc);
+void perfStop(PerfCounters *pc);
+void perfReport(const char *phase, int thread, PerfCounters *pc);
+
+// metrics.c prototypes
+void metricsEnable(FILE *out);
+int metricsEnabled(void);
+long long metricsNow(void);
+void metricsRecord(int backend, int m, int n, int k, long long ns);
+void metricsDump(FILE *out);
+
+// power.c prototypes
+int matrixPower(Matrix *a, int k, Matrix *c, int modulus);
+
+// tune.c prototypes
+void getTuneParams(int m, int n, int k, TuneParams *tp);
+int loadTuneProfile(const char *path);
+int saveTuneProfile(const char *path);
+void tuneShape(int m, int n, int k, FILE *log);
+
+// transport.c prototypes
+int transportInit(Transport *t, int kind, int size);
+
+// dist.c prototypes
+int distInit(int gridRows, int gridCols, int transport);
+int distFinish(void);
+int distMultiply(Matrix *a, Matrix *b, Matrix *c, int gridRows,
+                 int gridCols, int transport);
+
+// server.c prototypes
+int serveMatrices(const char *path);
+
+// client.c prototypes
+size_t servedBytes(int n, int p, int m);
+int remoteAlloc(RemoteMatrices *r, int n, int p, int m);
+int remoteMultiply(const char *path, RemoteMatrices *r);
+int serveSend(const char *path, ServeRequest *req, int fd);
+void remoteFree(RemoteMatrices *r);
+
+// async.c prototypes
+MatrixTask *multiplyAsync(Matrix *a, Matrix *b, Matrix *c,
+                          MatrixTask **deps, int numDeps,
+                          TaskCallback callback, void *arg);
+int taskDone(MatrixTask *t);
+int taskWait(MatrixTask *t);
+void taskFree(MatrixTask *t);
+void asyncShutdown(void);
+
+// cache.c prototypes
+void hashMatrix(Matrix *a, unsigned long long key[2]);
+void cacheEnable(size_t bytes, const char *dir);
+int cacheEnabled(void);
+void cacheClear(void);
+void cacheStats(long long *numHits, long long *numMisses);
+int multiplyCached(Matrix *a, Matrix *b, Matrix *c);
+
+// incremental.c prototypes
+int updateRowA(Matrix *a, Matrix *b, Matrix *c, int i, int *newRow);
+int updateRowB(Matrix *a, Matrix *b, Matrix *c, int k, int *newRow);
+void deltaInit(MatrixDelta *d);
+void deltaSet(MatrixDelta *d, int bOfB, int row, int col, int value);
+int deltaApply(Matrix *a, Matrix *b, Matrix *c, MatrixDelta *d);
+void deltaFree(MatrixDelta *d);
+
+// syrk.c prototypes
+int syrk(Matrix *a, Matrix *c, int bTrans, int uplo, int bMirror);
+
+// band.c prototypes
+void bandInit(BandMatrix *a, int numRows, int numCols, int lower,
+              int upper);
+void bandFromDense(BandMatrix *a, Matrix *dense, int lower, int upper);
+void bandToDense(BandMatrix *a, Matrix *dense);
+void bandFree(BandMatrix *a);
+int bandMultiply(BandMatrix *a, Matrix *b, Matrix *c);
+int bandBandMultiply(BandMatrix *a, BandMatrix *b, BandMatrix *c);
+
+// triangular.c prototypes
+void triInit(TriMatrix *a, int n, int uplo);
+void triFromDense(TriMatrix *a, Matrix *dense, int uplo);
+void triFree(TriMatrix *a);
+int trmm(TriMatrix *a, Matrix *b, Matrix *c);
+
+// blocksparse.c prototypes
+void bsparseFromMatrix(BlockSparse *s, Matrix *a, int tile);
+void bsparseToMatrix(BlockSparse *s, Matrix *a);
+void bsparseFree(BlockSparse *s);
+int bsparseMultiply(BlockSparse *a, BlockSparse *b, Matrix *c);
+
+// bitmatrix.c prototypes
+void bitInit(BitMatrix *a, int numRows, int numCols);
+void bitFromMatrix(BitMatrix *a, Matrix *src, int bTrans);
+void bitToMatrix(BitMatrix *a, Matrix *dst);
+void bitFree(BitMatrix *a);
+int bitMultiply(BitMatrix *a, BitMatrix *bT, BitMatrix *c);
+int bitCount(BitMatrix *a, BitMatrix *bT, Matrix *c);
+
+// m4rm.c prototypes
+int m4rm(BitMatrix *a, BitMatrix *b, BitMatrix *c, int bGF2);
+
+// semiring.c prototypes
+int semiringInit(Semiring *sr, int kind);
+int semiringMultiply(Matrix *a, Matrix *b, Matrix *c, Semiring *sr);
+int semiringClosure(Matrix *d, Semiring *sr);
+
+// modular.c prototypes
+int modMultiply(Matrix *a, Matrix *b, Matrix *c, int modulus);
+int modMultiplyExact(Matrix *a, Matrix *b, __int128 *c);
+
+// transpose.c prototypes
+int transposeMatrix(Matrix *a, Matrix *t);
+int transposeInPlace(Matrix *a);
+
+// morton.c prototypes
+unsigned mortonEncode(unsigned i, unsigned j);
+void mortonDecode(unsigned z, unsigned *i, unsigned *j);
+void mortonInit(MortonMatrix *a, int numRows, int numCols);
+void mortonFromMatrix(MortonMatrix *a, Matrix *src);
+void mortonToMatrix(MortonMatrix *a, Matrix *dst);
+void mortonFree(MortonMatrix *a);
+int mortonMultiply(MortonMatrix *a, MortonMatrix *b, MortonMatrix *c);
+
+// splitk.c prototypes
+int splitKSlices(int m, int n, int k, TuneParams *tp);
+void multiplySplitK(MatrixView *a, MatrixView *b, MatrixView *c,
+                    Epilogue *epi, TuneParams *tp, int numSlices);
+
+// gemv.c prototypes
+int multiplyVector(Matrix *a, Matrix *b, Matrix *c);
 
 #endif /* define_h */
@@ -0,0 +1,689 @@
+#include "define.h"
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/wait.h>
+
+/***********************************************************************
+ * dist.c written by DSU_410 team ...
+ *
+ * Description: Distributed multiply over a gridRows-by-gridCols grid of
+ * processes using SUMMA. A, B and C are cut into one block per rank.
+ * The shared dimension is walked in panels. For each panel, the rank
+ * holding that slice of A sends it along its grid row, the rank holding
+ * that slice of B sends it down its grid column, and every rank adds
+ * the panel product to its block of C with the blocked kernel.
+ *
+ * Panels are double buffered. A communication thread receives (or
+ * sends) panel s + 1 while the calling thread multiplies panel s.
+ *
+ * Ranks are forked processes talking through a Transport (see
+ * transport.c), so the same code runs over sockets or shared memory.
+ * The calling process is rank 0. It sends every rank its blocks, and
+ * collects the C blocks at the end.
+ *
+ * fork copies only the calling thread, and libgomp in the child then
+ * waits on pool threads that no longer exist. The ranks are therefore
+ * forked by distInit at the start of main, before anything has used
+ * OpenMP, and kept for every distMultiply until distFinish. Each rank
+ * starts its own OpenMP pool. distMultiply without distInit forks the
+ * ranks itself, but only while the process is still single threaded.
+ *
+ * Functions:
+ * - distInit
+ * - distFinish
+ * - distMultiply
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// State of one rank
+typedef struct
+{
+    Transport *t;
+    int gridRows;
+    int gridCols;
+    int myRow;
+    int myCol;
+    int n;                  // A is n-by-p, B is p-by-m
+    int p;
+    int m;
+    Matrix a;               // local blocks
+    Matrix b;
+    Matrix c;
+    Matrix panelA[2];       // double buffered panels
+    Matrix panelB[2];
+    int *steps;             // panel boundaries in the shared dimension
+    int numSteps;
+    int bReady[2];          // panel slot filled and not yet multiplied
+    int bFailed;            // communication failed, give up
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} DistRank;
+
+// Ranks started by distInit, pids == NULL when there are none
+typedef struct
+{
+    Transport t;
+    pid_t *pids;            // other ranks, indexed by rank
+    int size;               // ranks forked, plus rank 0
+    int gridRows;
+    int gridCols;
+    int kind;               // TRANSPORT_* constant
+    int bFailed;            // a multiply failed, ranks must be killed
+} DistPool;
+
+static DistPool pool;
+
+/****************************   blockStart   ****************************
+ * static int blockStart(int n, int parts, int i)
+ *
+ * Description: First index of part i when n items are cut into parts
+ * nearly equal parts. blockStart(n, parts, parts) is n.
+ ***********************************************************************/
+static int blockStart(int n, int parts, int i)
+{
+    return (int) ((long long) i * n / parts);
+}
+
+/*****************************   ownerOf   *****************************
+ * static int ownerOf(int n, int parts, int k)
+ *
+ * Description: Part holding index k.
+ ***********************************************************************/
+static int ownerOf(int n, int parts, int k)
+{
+    int i = 0;
+    while (blockStart(n, parts, i + 1) <= k)
+        i++;
+    return i;
+}
+
+/****************************   shapePanel   ****************************
+ * static void shapePanel(Matrix *panel, int numRows, int numCols)
+ *
+ * Description: Reshapes a panel to numRows-by-numCols with its rows
+ * packed one after another from the start of its storage, so the whole
+ * panel goes over the transport as one message.
+ *
+ * NOTES:
+ * - The panel must have been allocated at least numRows * numCols.
+ ***********************************************************************/
+static void shapePanel(Matrix *panel, int numRows, int numCols)
+{
+    int i;
+    panel->rows = numRows;
+    panel->cols = numCols;
+    for (i = 1; i < numRows; i++)
+        panel->m[i] = panel->m[0] + (size_t) i * numCols;
+}
+
+/*****************************   planSteps   ***************************
+ * static int planSteps(DistRank *d)
+ *
+ * Description: Cuts the shared dimension wherever a block of A's columns
+ * or of B's rows starts, so every panel has a single owner in each grid
+ * row and column.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * width         The widest panel.
+ ***********************************************************************/
+static int planSteps(DistRank *d)
+{
+    int widest = 0;
+    int k;
+    int i;
+    d->steps = malloc(sizeof(int) * (d->gridRows + d->gridCols + 1));
+    if (d->steps == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    d->numSteps = 0;
+    d->steps[0] = 0;
+    while (d->steps[d->numSteps] < d->p)
+    {
+        // Next boundary of either cut after the current one
+        k = d->p;
+        for (i = 1; i < d->gridCols; i++)
+            if (blockStart(d->p, d->gridCols, i) > d->steps[d->numSteps] &&
+                blockStart(d->p, d->gridCols, i) < k)
+                k = blockStart(d->p, d->gridCols, i);
+        for (i = 1; i < d->gridRows; i++)
+            if (blockStart(d->p, d->gridRows, i) > d->steps[d->numSteps] &&
+                blockStart(d->p, d->gridRows, i) < k)
+                k = blockStart(d->p, d->gridRows, i);
+        if (k - d->steps[d->numSteps] > widest)
+            widest = k - d->steps[d->numSteps];
+        d->steps[++d->numSteps] = k;
+    }
+    return widest;
+}
+
+/****************************   fillPanels   ****************************
+ * static int fillPanels(DistRank *d, int s)
+ *
+ * Description: Fills slot s % 2 with panel s of A and B, either from the
+ * local blocks (and passed on to the rest of the grid row or column) or
+ * from the owning rank.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Panels filled.
+ * FALSE         The transport failed.
+ ***********************************************************************/
+static int fillPanels(DistRank *d, int s)
+{
+    Matrix *pa = &d->panelA[s % 2];
+    Matrix *pb = &d->panelB[s % 2];
+    int k0 = d->steps[s];
+    int kw = d->steps[s + 1] - k0;
+    int owner;
+    int off;
+    int bVal = TRUE;
+    int i;
+    // A panel travels along the grid row
+    owner = ownerOf(d->p, d->gridCols, k0);
+    shapePanel(pa, d->a.rows, kw);
+    if (owner == d->myCol)
+    {
+        off = k0 - blockStart(d->p, d->gridCols, owner);
+        for (i = 0; i < pa->rows; i++)
+            memcpy(pa->m[i], d->a.m[i] + off, sizeof(int) * kw);
+        for (i = 0; i < d->gridCols && bVal; i++)
+            if (i != d->myCol)
+                bVal = d->t->send(d->t, d->myRow * d->gridCols + i, pa->m[0],
+                                  sizeof(int) * pa->rows * kw);
+    }
+    else
+        bVal = d->t->recv(d->t, d->myRow * d->gridCols + owner, pa->m[0],
+                          sizeof(int) * pa->rows * kw);
+    // B panel travels down the grid column
+    if (!bVal)
+        return FALSE;
+    owner = ownerOf(d->p, d->gridRows, k0);
+    shapePanel(pb, kw, d->b.cols);
+    if (owner == d->myRow)
+    {
+        off = k0 - blockStart(d->p, d->gridRows, owner);
+        for (i = 0; i < kw; i++)
+            memcpy(pb->m[i], d->b.m[off + i], sizeof(int) * pb->cols);
+        for (i = 0; i < d->gridRows && bVal; i++)
+            if (i != d->myRow)
+                bVal = d->t->send(d->t, i * d->gridCols + d->myCol, pb->m[0],
+                                  sizeof(int) * kw * pb->cols);
+    }
+    else
+        bVal = d->t->recv(d->t, owner * d->gridCols + d->myCol, pb->m[0],
+                          sizeof(int) * kw * pb->cols);
+    return bVal;
+}
+
+/****************************   commThread   ****************************
+ * static void *commThread(void *arg)
+ *
+ * Description: Fills panel slots in step order, each as soon as the
+ * multiply has finished with it.
+ ***********************************************************************/
+static void *commThread(void *arg)
+{
+    DistRank *d = arg;
+    int bVal = TRUE;
+    int s;
+    for (s = 0; s < d->numSteps && bVal; s++)
+    {
+        pthread_mutex_lock(&d->lock);
+        while (d->bReady[s % 2])
+            pthread_cond_wait(&d->cond, &d->lock);
+        pthread_mutex_unlock(&d->lock);
+        bVal = fillPanels(d, s);
+        pthread_mutex_lock(&d->lock);
+        if (bVal)
+            d->bReady[s % 2] = TRUE;
+        else
+            d->bFailed = TRUE;
+        pthread_cond_broadcast(&d->cond);
+        pthread_mutex_unlock(&d->lock);
+    }
+    return NULL;
+}
+
+/***************************   moveBlock   ******************************
+ * static int moveBlock(DistRank *d, Matrix *whole, Matrix *local,
+ *                      int rank, int row0, int col0, int bGather)
+ *
+ * Description: Rank 0's side of scatter and gather. Copies the block of
+ * whole at (row0, col0), the size of local, to rank (scatter), or adds
+ * the block received from rank into whole (gather). Rank 0's own block
+ * is copied without the transport.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Block moved.
+ * FALSE         The transport failed.
+ ***********************************************************************/
+static int moveBlock(DistRank *d, Matrix *whole, Matrix *local, int rank,
+                     int row0, int col0, int bGather)
+{
+    int *buf = local->m[0];
+    int bVal = TRUE;
+    int i;
+    int j;
+    if (rank != 0)
+        buf = allocScratch(sizeof(int) * local->rows * local->cols);
+    if (bGather)
+    {
+        if (rank != 0)
+            bVal = d->t->recv(d->t, rank, buf,
+                              sizeof(int) * local->rows * local->cols);
+        for (i = 0; i < local->rows && bVal; i++)
+            for (j = 0; j < local->cols; j++)
+                whole->m[row0 + i][col0 + j] += buf[i * local->cols + j];
+    }
+    else
+    {
+        for (i = 0; i < local->rows; i++)
+            memcpy(buf + (size_t) i * local->cols, whole->m[row0 + i] + col0,
+                   sizeof(int) * local->cols);
+        if (rank != 0)
+            bVal = d->t->send(d->t, rank, buf,
+                              sizeof(int) * local->rows * local->cols);
+    }
+    if (rank != 0)
+        freeScratch(buf);
+    return bVal;
+}
+
+/*****************************   scatter   ******************************
+ * static int scatter(DistRank *d, Matrix *a, Matrix *b, int bGather)
+ *
+ * Description: Moves the A and B blocks out of rank 0, or with bGather
+ * the C blocks back into a (which is then C). Other ranks send or
+ * receive their own blocks.
+ ***********************************************************************/
+static int scatter(DistRank *d, Matrix *a, Matrix *b, int bGather)
+{
+    Matrix blockA;
+    Matrix blockB;
+    int bVal = TRUE;
+    int r;
+    int c;
+    if (d->t->rank != 0)
+    {
+        if (bGather)
+            return d->t->send(d->t, 0, d->c.m[0],
+                              sizeof(int) * d->c.rows * d->c.cols);
+        return d->t->recv(d->t, 0, d->a.m[0],
+                          sizeof(int) * d->a.rows * d->a.cols) &&
+               d->t->recv(d->t, 0, d->b.m[0],
+                          sizeof(int) * d->b.rows * d->b.cols);
+    }
+    for (r = 0; r < d->gridRows && bVal; r++)
+        for (c = 0; c < d->gridCols && bVal; c++)
+        {
+            if (bGather)
+            {
+                blockA.rows = blockStart(d->n, d->gridRows, r + 1) -
+                              blockStart(d->n, d->gridRows, r);
+                blockA.cols = blockStart(d->m, d->gridCols, c + 1) -
+                              blockStart(d->m, d->gridCols, c);
+                blockA.m = d->c.m;
+                bVal = moveBlock(d, a, &blockA, r * d->gridCols + c,
+                                 blockStart(d->n, d->gridRows, r),
+                                 blockStart(d->m, d->gridCols, c), TRUE);
+                continue;
+            }
+            blockA.rows = blockStart(d->n, d->gridRows, r + 1) -
+                          blockStart(d->n, d->gridRows, r);
+            blockA.cols = blockStart(d->p, d->gridCols, c + 1) -
+                          blockStart(d->p, d->gridCols, c);
+            blockA.m = d->a.m;
+            blockB.rows = blockStart(d->p, d->gridRows, r + 1) -
+                          blockStart(d->p, d->gridRows, r);
+            blockB.cols = blockStart(d->m, d->gridCols, c + 1) -
+                          blockStart(d->m, d->gridCols, c);
+            blockB.m = d->b.m;
+            bVal = moveBlock(d, a, &blockA, r * d->gridCols + c,
+                             blockStart(d->n, d->gridRows, r),
+                             blockStart(d->p, d->gridCols, c), FALSE) &&
+                   moveBlock(d, b, &blockB, r * d->gridCols + c,
+                             blockStart(d->p, d->gridRows, r),
+                             blockStart(d->m, d->gridCols, c), FALSE);
+        }
+    return bVal;
+}
+
+/******************************   runRank   *****************************
+ * static int runRank(DistRank *d, Matrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: Everything one rank does, rank 0 included.
+ *
+ * Process:
+ * 1.) Allocate the local blocks and receive A and B.
+ * 2.) Start the communication thread, then multiply panels as they
+ *     become ready.
+ * 3.) Send the C block back (rank 0 adds them all into c).
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * d             in/out      Rank state with t, grid and sizes set.
+ * a, b, c       in          The whole matrices on rank 0, else NULL.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          This rank's part is done.
+ * FALSE         The transport failed.
+ ***********************************************************************/
+static int runRank(DistRank *d, Matrix *a, Matrix *b, Matrix *c)
+{
+    MatrixView va;
+    MatrixView vb;
+    MatrixView vc;
+    pthread_t comm;
+    int widest;
+    int bVal;
+    int s;
+    int i;
+    d->myRow = d->t->rank / d->gridCols;
+    d->myCol = d->t->rank % d->gridCols;
+    // Rank 0's own blocks are at the top left
+    setUp2D(&d->a, blockStart(d->n, d->gridRows, d->myRow + 1) -
+                   blockStart(d->n, d->gridRows, d->myRow),
+            blockStart(d->p, d->gridCols, d->myCol + 1) -
+            blockStart(d->p, d->gridCols, d->myCol), FALSE);
+    setUp2D(&d->b, blockStart(d->p, d->gridRows, d->myRow + 1) -
+                   blockStart(d->p, d->gridRows, d->myRow),
+            blockStart(d->m, d->gridCols, d->myCol + 1) -
+            blockStart(d->m, d->gridCols, d->myCol), FALSE);
+    setUp2D(&d->c, d->a.rows, d->b.cols, FALSE);
+    widest = planSteps(d);
+    for (i = 0; i < 2; i++)
+    {
+        setUp2D(&d->panelA[i], d->a.rows, widest, FALSE);
+        setUp2D(&d->panelB[i], widest, d->b.cols, FALSE);
+        d->bReady[i] = FALSE;
+    }
+    d->bFailed = FALSE;
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->cond, NULL);
+    bVal = scatter(d, a, b, FALSE);
+    if (bVal && pthread_create(&comm, NULL, commThread, d) == 0)
+    {
+        makeView(&vc, &d->c, FALSE);
+        for (s = 0; s < d->numSteps && bVal; s++)
+        {
+            pthread_mutex_lock(&d->lock);
+            while (!d->bReady[s % 2] && !d->bFailed)
+                pthread_cond_wait(&d->cond, &d->lock);
+            bVal = d->bReady[s % 2];
+            pthread_mutex_unlock(&d->lock);
+            if (!bVal)
+                break;
+            makeView(&va, &d->panelA[s % 2], FALSE);
+            makeView(&vb, &d->panelB[s % 2], FALSE);
+            multiplyView(&va, &vb, &vc);
+            pthread_mutex_lock(&d->lock);
+            d->bReady[s % 2] = FALSE;
+            pthread_cond_broadcast(&d->cond);
+            pthread_mutex_unlock(&d->lock);
+        }
+        pthread_join(comm, NULL);
+    }
+    else
+        bVal = FALSE;
+    if (bVal)
+        bVal = scatter(d, c, NULL, TRUE);
+    pthread_mutex_destroy(&d->lock);
+    pthread_cond_destroy(&d->cond);
+    for (i = 0; i < 2; i++)
+    {
+        free2D(&d->panelA[i]);
+        free2D(&d->panelB[i]);
+    }
+    free(d->steps);
+    free2D(&d->a);
+    free2D(&d->b);
+    free2D(&d->c);
+    return bVal;
+}
+
+/***************************   isSingleThreaded   ***********************
+ * static int isSingleThreaded(void)
+ *
+ * Description: TRUE when the process has no thread besides the caller,
+ * counted in /proc/self/task. An OpenMP pool, once started, keeps its
+ * threads, and libgomp in a forked child then waits on threads that
+ * were not copied. Without /proc it cannot tell and says TRUE.
+ ***********************************************************************/
+static int isSingleThreaded(void)
+{
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *entry;
+    int numThreads = 0;
+    if (dir == NULL)
+        return TRUE;
+    while ((entry = readdir(dir)) != NULL)
+        if (entry->d_name[0] != '.')
+            numThreads++;
+    closedir(dir);
+    return numThreads <= 1;
+}
+
+/******************************   rankLoop   ****************************
+ * static void rankLoop(int rank)
+ *
+ * Description: Body of a forked rank. Runs one job per header received
+ * from rank 0 until a header with n == 0 or a failure, then exits.
+ ***********************************************************************/
+static void rankLoop(int rank)
+{
+    DistRank d;
+    int job[3];
+    int bVal = TRUE;
+    memset(&d, 0, sizeof(d));
+    d.t = &pool.t;
+    d.gridRows = pool.gridRows;
+    d.gridCols = pool.gridCols;
+    pool.t.attach(&pool.t, rank);
+    while (bVal)
+    {
+        if (!pool.t.recv(&pool.t, 0, job, sizeof(job)) || job[0] == 0)
+            break;
+        d.n = job[0];
+        d.p = job[1];
+        d.m = job[2];
+        bVal = runRank(&d, NULL, NULL, NULL);
+    }
+    pool.t.destroy(&pool.t);
+    _exit(bVal ? 0 : 1);
+}
+
+/******************************   distInit   ****************************
+ * int distInit(int gridRows, int gridCols, int transport)
+ *
+ * Description: Starts the ranks of a gridRows-by-gridCols grid ahead of
+ * the multiplies, see distMultiply. The other ranks are forked here and
+ * wait for work, each starting its own OpenMP pool when it first
+ * multiplies.
+ *
+ * Process:
+ * 1.) Refuse to fork unless this is the only thread, as fork copies
+ *     only the calling thread.
+ * 2.) Stop ranks started before, create the transport and fork the
+ *     other ranks.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * gridRows      in          Process rows.
+ * gridCols      in          Process columns.
+ * transport     in          TRANSPORT_SOCKET or TRANSPORT_SHM.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Ranks started.
+ * FALSE         Other threads exist (e.g. OpenMP has already run), bad
+ *               grid, or the transport or a fork failed.
+ *
+ * NOTES:
+ * - Call at the start of main, before anything uses OpenMP or starts
+ *   threads. Pair with distFinish.
+ ***********************************************************************/
+int distInit(int gridRows, int gridCols, int transport)
+{
+    int size = gridRows * gridCols;
+    int q;
+    distFinish();
+    if (gridRows < 1 || gridCols < 1 || (size > 1 && !isSingleThreaded()) ||
+        !transportInit(&pool.t, transport, size))
+        return FALSE;
+    pool.pids = malloc(sizeof(pid_t) * size);
+    if (pool.pids == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    pool.gridRows = gridRows;
+    pool.gridCols = gridCols;
+    pool.kind = transport;
+    // Unflushed output would be written again by every child
+    fflush(stdout);
+    fflush(stderr);
+    for (q = 1; q < size; q++)
+    {
+        pool.pids[q] = fork();
+        if (pool.pids[q] == 0)
+            rankLoop(q);
+        if (pool.pids[q] < 0)
+            break;
+    }
+    pool.size = q;
+    pool.t.attach(&pool.t, 0);
+    if (q < size)
+    {
+        pool.bFailed = TRUE;
+        distFinish();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*****************************   distFinish   ***************************
+ * int distFinish(void)
+ *
+ * Description: Stops the ranks started by distInit, if any. They are
+ * told to exit, or killed when a multiply failed and they may be
+ * waiting on a dead peer.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Every rank exited cleanly, or there were none.
+ * FALSE         A rank failed or had to be killed.
+ ***********************************************************************/
+int distFinish(void)
+{
+    int job[3] = { 0, 0, 0 };
+    int bVal = TRUE;
+    int status;
+    int q;
+    if (pool.pids == NULL)
+        return TRUE;
+    for (q = 1; q < pool.size; q++)
+    {
+        if (pool.bFailed || !pool.t.send(&pool.t, q, job, sizeof(job)))
+            kill(pool.pids[q], SIGKILL);
+        if (waitpid(pool.pids[q], &status, 0) != pool.pids[q] ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            bVal = FALSE;
+    }
+    pool.t.destroy(&pool.t);
+    free(pool.pids);
+    memset(&pool, 0, sizeof(pool));
+    return bVal;
+}
+
+/****************************   distMultiply   **************************
+ * int distMultiply(Matrix *a, Matrix *b, Matrix *c, int gridRows,
+ *                  int gridCols, int transport)
+ *
+ * Description: Adds a*b to c using gridRows * gridCols processes on
+ * this machine, see the top of the file.
+ *
+ * Process:
+ * 1.) Use the ranks started by distInit, or start them here and stop
+ *     them at the end when there are none.
+ * 2.) Send every other rank the shape, then run rank 0 here.
+ * 3.) If anything failed, stop the ranks, killing them so none is left
+ *     waiting on a dead peer.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to Matrix structure, n-by-p.
+ * b             in          ptr to Matrix structure, p-by-m.
+ * c             in/out      ptr to Matrix structure, n-by-m.
+ * gridRows      in          Process rows, at most min(n, p).
+ * gridCols      in          Process columns, at most min(m, p).
+ * transport     in          TRANSPORT_SOCKET or TRANSPORT_SHM.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Undefined product, bad grid, ranks from distInit on
+ *               another grid, no ranks and other threads exist so
+ *               they cannot be forked, or a rank or the transport
+ *               failed. c may then be partly updated.
+ *
+ * NOTES:
+ * - Like multiply, accumulates: c += a*b.
+ * - Without distInit the ranks are forked here, which is refused once
+ *   OpenMP has run in this process: call distInit first.
+ ***********************************************************************/
+int distMultiply(Matrix *a, Matrix *b, Matrix *c, int gridRows,
+                 int gridCols, int transport)
+{
+    DistRank d;
+    long long start = 0;
+    int job[3];
+    int bOwnPool = FALSE;
+    int bVal = isDefined(a, b) && c->rows == a->rows && c->cols == b->cols;
+    int q;
+    if (!bVal || gridRows < 1 || gridCols < 1 ||
+        gridRows > a->rows || gridRows > a->cols ||
+        gridCols > b->cols || gridCols > a->cols)
+        return FALSE;
+    if (pool.pids == NULL)
+    {
+        if (!distInit(gridRows, gridCols, transport))
+            return FALSE;
+        bOwnPool = TRUE;
+    }
+    else if (pool.gridRows != gridRows || pool.gridCols != gridCols ||
+             pool.kind != transport)
+        return FALSE;
+    if (metricsEnabled())
+        start = metricsNow();
+    memset(&d, 0, sizeof(d));
+    d.t = &pool.t;
+    d.gridRows = gridRows;
+    d.gridCols = gridCols;
+    d.n = job[0] = a->rows;
+    d.p = job[1] = a->cols;
+    d.m = job[2] = b->cols;
+    for (q = 1; q < pool.size && bVal; q++)
+        bVal = pool.t.send(&pool.t, q, job, sizeof(job));
+    if (bVal)
+        bVal = runRank(&d, a, b, c);
+    if (!bVal)
+        pool.bFailed = TRUE;
+    if (bOwnPool || !bVal)
+        bVal = distFinish() && bVal;
+    if (bVal && metricsEnabled())
+        metricsRecord(BACKEND_DIST, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return bVal;
+}
@@ -0,0 +1,139 @@
+#include "define.h"
+
+/***********************************************************************
+ * epilogue.c written by DSU_410 team ...
+ *
+ * Description: Small runtime lists of element-wise operations (bias,
+ * scale, clamp, ReLU, modulus) applied to the product inside the
+ * multiply kernel, see multiplyEpilogue in matrix.c. Running them on
+ * each C tile while it is still in cache saves the separate pass over C.
+ *
+ * Functions:
+ * - epilogueInit
+ * - epilogueAdd
+ * - applyEpilogue
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/****************************   epilogueInit   **************************
+ * void epilogueInit(Epilogue *e)
+ *
+ * Description: Empties an epilogue.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * e             out         ptr to Epilogue structure, see define.h.
+ ***********************************************************************/
+void epilogueInit(Epilogue *e)
+{
+    e->count = 0;
+}
+
+/****************************   epilogueAdd   ***************************
+ * int epilogueAdd(Epilogue *e, int op, int x, int y, int *vec)
+ *
+ * Description: Appends one operation to an epilogue. Operations run in
+ * the order they were added.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * e             in/out      ptr to Epilogue structure, see define.h.
+ * op            in          EPI_* constant, see define.h.
+ * x             in          EPI_SCALE factor, EPI_CLAMP low bound,
+ *                           EPI_MOD modulus (> 0).
+ * y             in          EPI_CLAMP high bound.
+ * vec           in          EPI_BIAS_ROW: one value per column of C.
+ *                           EPI_BIAS_COL: one value per row of C.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Operation added.
+ * FALSE         Epilogue full or unknown op.
+ *
+ * NOTES:
+ * - vec is read during the multiply, it is not copied.
+ ***********************************************************************/
+int epilogueAdd(Epilogue *e, int op, int x, int y, int *vec)
+{
+    if (e->count >= MAX_EPILOGUE || op < EPI_BIAS_ROW || op > EPI_MOD ||
+        (op == EPI_MOD && x <= 0))
+        return FALSE;
+    e->ops[e->count].op = op;
+    e->ops[e->count].x = x;
+    e->ops[e->count].y = y;
+    e->ops[e->count].vec = vec;
+    e->count++;
+    return TRUE;
+}
+
+/****************************   applyEpilogue   *************************
+ * void applyEpilogue(Epilogue *e, int *tile, int numRows, int numCols,
+ *                    int row0, int col0)
+ *
+ * Description: Runs every operation of e over a row major tile of C.
+ *
+ * Process:
+ * 1.) For each operation, sweep the tile row by row. Each inner loop
+ *     is branch free so the compiler can vectorise it.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * e             in          ptr to Epilogue structure, see define.h.
+ * tile          in/out      numRows * numCols ints, row major.
+ * numRows       in          rows in the tile.
+ * numCols       in          columns in the tile.
+ * row0, col0    in          position of the tile in C, used to index
+ *                           bias vectors.
+ ***********************************************************************/
+void applyEpilogue(Epilogue *e, int *tile, int numRows, int numCols,
+                   int row0, int col0)
+{
+    EpilogueOp *op;
+    int *row;
+    int n;
+    int i;
+    int j;
+    for (n = 0; n < e->count; n++)
+    {
+        op = &e->ops[n];
+        for (i = 0; i < numRows; i++)
+        {
+            row = tile + i * numCols;
+            switch (op->op)
+            {
+                case EPI_BIAS_ROW:
+                    for (j = 0; j < numCols; j++)
+                        row[j] += op->vec[col0 + j];
+                    break;
+                case EPI_BIAS_COL:
+                    for (j = 0; j < numCols; j++)
+                        row[j] += op->vec[row0 + i];
+                    break;
+                case EPI_SCALE:
+                    for (j = 0; j < numCols; j++)
+                        row[j] *= op->x;
+                    break;
+                case EPI_CLAMP:
+                    for (j = 0; j < numCols; j++)
+                        row[j] = row[j] < op->x ? op->x
+                               : row[j] > op->y ? op->y : row[j];
+                    break;
+                case EPI_RELU:
+                    for (j = 0; j < numCols; j++)
+                        row[j] = row[j] < 0 ? 0 : row[j];
+                    break;
+                case EPI_MOD:
+                    for (j = 0; j < numCols; j++)
+                    {
+                        row[j] %= op->x;
+                        row[j] += row[j] < 0 ? op->x : 0;
+                    }
+                    break;
+            }
+        }
+    }
+}
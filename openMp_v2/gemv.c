@@ -0,0 +1,312 @@
+#include "define.h"
+#include <string.h>
+
+/***********************************************************************
+ * gemv.c written by DSU_410 team ...
+ *
+ * Description: Products where one dimension is 1. The blocked kernel
+ * packs and tiles for reuse these shapes do not have: every element of
+ * the matrix operand is used once, so the time is the time to stream
+ * it from memory. Here each has a kernel that reads the big operand
+ * once, in order, with the inner loop vectorised:
+ * - gemv, y = A x (B one column). Four rows of A are dotted with x at
+ *   once, four independent accumulators that share each load of x.
+ * - vecmat, y = x B (A one row). Four rows of B are combined per pass
+ *   over a block of y, so y is loaded and stored a quarter as often.
+ * - ger, the outer product, C += a b (shared dimension 1). Each row of
+ *   C is a scaled copy of b added in.
+ *
+ * Work is shared as blocks of the output. When the output has fewer
+ * blocks than there are threads, the shared dimension is also cut into
+ * slices of at least SPLITK_MIN_K, each with a private partial output
+ * that is summed at the end, as in splitk.c.
+ *
+ * Functions:
+ * - multiplyVector
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/******************************   numKSlices   **************************
+ * static int numKSlices(int numBlocks, int k)
+ *
+ * Description: Returns how many slices of the shared dimension k to
+ * cut so that numBlocks output blocks times the slices cover the
+ * threads, with no slice shorter than SPLITK_MIN_K.
+ ***********************************************************************/
+static int numKSlices(int numBlocks, int k)
+{
+    int numThreads = MAX_THREADS();
+    int numSlices;
+    if (numBlocks < 1)
+        return 1;
+    numSlices = (numThreads + numBlocks - 1) / numBlocks;
+    if (numSlices > k / SPLITK_MIN_K)
+        numSlices = k / SPLITK_MIN_K;
+    return numSlices < 1 ? 1 : numSlices;
+}
+
+/****************************   allocPartial   **************************
+ * static int *allocPartial(int numSlices, int len)
+ *
+ * Description: Returns numSlices zeroed partial outputs of len ints,
+ * one after another, or NULL when there is only one slice, which then
+ * adds straight into C.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+static int *allocPartial(int numSlices, int len)
+{
+    int *partial;
+    if (numSlices == 1)
+        return NULL;
+    partial = allocScratch(sizeof(int) * (size_t) numSlices * len);
+    memset(partial, 0, sizeof(int) * (size_t) numSlices * len);
+    return partial;
+}
+
+/********************************   gemv   ******************************
+ * static void gemv(Matrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: c(:, 0) += A * b(:, 0).
+ *
+ * Process:
+ * 1.) Copy the column of b into a contiguous x.
+ * 2.) Share (block of GEMV_ROW_BLOCK rows, slice) pairs amongst
+ *     threads. Rows are taken four at a time, each group one pass over
+ *     the slice of x.
+ * 3.) Sum the partials of the slices into C.
+ ***********************************************************************/
+static void gemv(Matrix *a, Matrix *b, Matrix *c)
+{
+    int *x = allocScratch(sizeof(int) * a->cols);
+    int numBlocks = (a->rows + GEMV_ROW_BLOCK - 1) / GEMV_ROW_BLOCK;
+    int numSlices = numKSlices(numBlocks, a->cols);
+    int *partial = allocPartial(numSlices, a->rows);
+    int t;
+    int i;
+    int k;
+    #pragma omp parallel for schedule(static)
+    for (k = 0; k < a->cols; k++)
+        x[k] = b->m[k][0];
+    #pragma omp parallel for schedule(static) private(i, k)
+    for (t = 0; t < numBlocks * numSlices; t++)
+    {
+        int row1 = (t / numSlices + 1) * GEMV_ROW_BLOCK;
+        int s = t % numSlices;
+        int k0 = (int) ((long long) a->cols * s / numSlices);
+        int k1 = (int) ((long long) a->cols * (s + 1) / numSlices);
+        int *r0;
+        int *r1;
+        int *r2;
+        int *r3;
+        int s0;
+        int s1;
+        int s2;
+        int s3;
+        if (row1 > a->rows)
+            row1 = a->rows;
+        for (i = t / numSlices * GEMV_ROW_BLOCK; i < row1; i += 4)
+        {
+            // Short last group reuses its last row, results not stored
+            r0 = a->m[i];
+            r1 = a->m[i + 1 < row1 ? i + 1 : i];
+            r2 = a->m[i + 2 < row1 ? i + 2 : i];
+            r3 = a->m[i + 3 < row1 ? i + 3 : i];
+            s0 = 0;
+            s1 = 0;
+            s2 = 0;
+            s3 = 0;
+            #pragma omp simd reduction(+:s0, s1, s2, s3)
+            for (k = k0; k < k1; k++)
+            {
+                s0 += r0[k] * x[k];
+                s1 += r1[k] * x[k];
+                s2 += r2[k] * x[k];
+                s3 += r3[k] * x[k];
+            }
+            if (partial != NULL)
+            {
+                partial[(size_t) s * a->rows + i] = s0;
+                if (i + 1 < row1)
+                    partial[(size_t) s * a->rows + i + 1] = s1;
+                if (i + 2 < row1)
+                    partial[(size_t) s * a->rows + i + 2] = s2;
+                if (i + 3 < row1)
+                    partial[(size_t) s * a->rows + i + 3] = s3;
+            }
+            else
+            {
+                c->m[i][0] += s0;
+                if (i + 1 < row1)
+                    c->m[i + 1][0] += s1;
+                if (i + 2 < row1)
+                    c->m[i + 2][0] += s2;
+                if (i + 3 < row1)
+                    c->m[i + 3][0] += s3;
+            }
+        }
+    }
+    if (partial != NULL)
+    {
+        #pragma omp parallel for schedule(static) private(t)
+        for (i = 0; i < a->rows; i++)
+            for (t = 0; t < numSlices; t++)
+                c->m[i][0] += partial[(size_t) t * a->rows + i];
+        freeScratch(partial);
+    }
+    freeScratch(x);
+}
+
+/*******************************   vecmat   *****************************
+ * static void vecmat(Matrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: c(0, :) += a(0, :) * B.
+ *
+ * Process:
+ * 1.) Share (block of GEMV_COL_BLOCK columns, slice) pairs amongst
+ *     threads.
+ * 2.) Walk the slice's rows of B four at a time, adding all four
+ *     scaled rows into the block of the output in one pass.
+ * 3.) Sum the partials of the slices into C.
+ ***********************************************************************/
+static void vecmat(Matrix *a, Matrix *b, Matrix *c)
+{
+    int numBlocks = (b->cols + GEMV_COL_BLOCK - 1) / GEMV_COL_BLOCK;
+    int numSlices = numKSlices(numBlocks, b->rows);
+    int *partial = allocPartial(numSlices, b->cols);
+    int *x = a->m[0];
+    int t;
+    int j;
+    int k;
+    #pragma omp parallel for schedule(static) private(j, k)
+    for (t = 0; t < numBlocks * numSlices; t++)
+    {
+        int j0 = t / numSlices * GEMV_COL_BLOCK;
+        int j1 = j0 + GEMV_COL_BLOCK < b->cols ? j0 + GEMV_COL_BLOCK
+                                               : b->cols;
+        int s = t % numSlices;
+        int k0 = (int) ((long long) b->rows * s / numSlices);
+        int k1 = (int) ((long long) b->rows * (s + 1) / numSlices);
+        int *y = partial != NULL ? partial + (size_t) s * b->cols
+                                 : c->m[0];
+        int *b0;
+        int *b1;
+        int *b2;
+        int *b3;
+        int x0;
+        int x1;
+        int x2;
+        int x3;
+        for (k = k0; k + 4 <= k1; k += 4)
+        {
+            b0 = b->m[k];
+            b1 = b->m[k + 1];
+            b2 = b->m[k + 2];
+            b3 = b->m[k + 3];
+            x0 = x[k];
+            x1 = x[k + 1];
+            x2 = x[k + 2];
+            x3 = x[k + 3];
+            #pragma omp simd
+            for (j = j0; j < j1; j++)
+                y[j] += x0 * b0[j] + x1 * b1[j] + x2 * b2[j] + x3 * b3[j];
+        }
+        for (; k < k1; k++)
+        {
+            b0 = b->m[k];
+            x0 = x[k];
+            #pragma omp simd
+            for (j = j0; j < j1; j++)
+                y[j] += x0 * b0[j];
+        }
+    }
+    if (partial != NULL)
+    {
+        #pragma omp parallel for schedule(static) private(t)
+        for (j = 0; j < b->cols; j++)
+            for (t = 0; t < numSlices; t++)
+                c->m[0][j] += partial[(size_t) t * b->cols + j];
+        freeScratch(partial);
+    }
+}
+
+/********************************   ger   *******************************
+ * static void ger(Matrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: C += a(:, 0) * b(0, :), the outer product. Work items
+ * are (row, block of GEMV_COL_BLOCK columns), so a few long rows still
+ * keep every thread busy.
+ ***********************************************************************/
+static void ger(Matrix *a, Matrix *b, Matrix *c)
+{
+    int numBlocks = (c->cols + GEMV_COL_BLOCK - 1) / GEMV_COL_BLOCK;
+    int *y = b->m[0];
+    long long t;
+    int j;
+    #pragma omp parallel for schedule(static) private(j)
+    for (t = 0; t < (long long) c->rows * numBlocks; t++)
+    {
+        int i = (int) (t / numBlocks);
+        int j0 = (int) (t % numBlocks) * GEMV_COL_BLOCK;
+        int j1 = j0 + GEMV_COL_BLOCK < c->cols ? j0 + GEMV_COL_BLOCK
+                                               : c->cols;
+        int ai = a->m[i][0];
+        int *row = c->m[i];
+        #pragma omp simd
+        for (j = j0; j < j1; j++)
+            row[j] += ai * y[j];
+    }
+}
+
+/****************************   multiplyVector   ************************
+ * int multiplyVector(Matrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: C += A*B for the shapes with a dimension of 1, using
+ * the kernels above.
+ *
+ * Process:
+ * 1.) Shared dimension 1: outer product.
+ * 2.) B one column: matrix-vector.
+ * 3.) A one row: vector-matrix.
+ * 4.) With metrics on, the call is recorded under BACKEND_VECTOR.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to Matrix structure, left operand.
+ * b             in          ptr to Matrix, a->cols rows.
+ * c             in/out      ptr to Matrix, a->rows by b->cols.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         No dimension is 1, or the shapes do not match. Nothing
+ *               is done.
+ *
+ * NOTES:
+ * - c must not overlap a or b.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int multiplyVector(Matrix *a, Matrix *b, Matrix *c)
+{
+    long long start;
+    if (!isDefined(a, b) || c->rows != a->rows || c->cols != b->cols)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    if (a->cols == 1)
+        ger(a, b, c);
+    else if (b->cols == 1)
+        gemv(a, b, c);
+    else if (a->rows == 1)
+        vecmat(a, b, c);
+    else
+        return FALSE;
+    if (start >= 0)
+        metricsRecord(BACKEND_VECTOR, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
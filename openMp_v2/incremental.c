@@ -0,0 +1,384 @@
+#include "define.h"
+#include <string.h>
+
+/***********************************************************************
+ * incremental.c written by DSU_410 team ...
+ *
+ * Description: Keeps C = A*B (plus whatever C held before) up to date
+ * while A and B change, at a cost that depends on the size of the
+ * change rather than on n^3.
+ *
+ * - New row i of A: C's row i changes by (new - old row) * B.
+ * - New row k of B: C changes by A's column k times the delta row,
+ *   a rank-1 correction limited to the columns that changed.
+ * - Any set of changed elements, collected in a MatrixDelta: the
+ *   changes to B become one low-rank product A[:, K] * dB[K, J] added
+ *   to C's changed columns J, then the changes to A become
+ *   dA[I, K] * B[K, :] added to C's changed rows I. Both use the
+ *   blocked kernel on small packed matrices.
+ *
+ * Each function writes the new values into A or B as well, so the
+ * next update starts from the right state.
+ *
+ * Functions:
+ * - updateRowA
+ * - updateRowB
+ * - deltaInit
+ * - deltaSet
+ * - deltaApply
+ * - deltaFree
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/******************************   updateRowA   **************************
+ * int updateRowA(Matrix *a, Matrix *b, Matrix *c, int i, int *newRow)
+ *
+ * Description: Replaces row i of A and brings row i of C up to date,
+ * in O(p * m) for an n-by-p A and p-by-m B.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in/out      ptr to Matrix structure, row i replaced.
+ * b             in          ptr to Matrix structure.
+ * c             in/out      ptr to Matrix structure, row i updated.
+ * i             in          Row of A that changed.
+ * newRow        in          a->cols new values.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Updated.
+ * FALSE         Shapes do not match or i is out of range.
+ ***********************************************************************/
+int updateRowA(Matrix *a, Matrix *b, Matrix *c, int i, int *newRow)
+{
+    int *row;
+    int d;
+    int j;
+    int k;
+    if (!isDefined(a, b) || c->rows != a->rows || c->cols != b->cols ||
+        i < 0 || i >= a->rows)
+        return FALSE;
+    row = c->m[i];
+    for (k = 0; k < a->cols; k++)
+    {
+        d = newRow[k] - a->m[i][k];
+        if (d == 0)
+            continue;
+        for (j = 0; j < c->cols; j++)
+            row[j] += d * b->m[k][j];
+        a->m[i][k] = newRow[k];
+    }
+    return TRUE;
+}
+
+/******************************   updateRowB   **************************
+ * int updateRowB(Matrix *a, Matrix *b, Matrix *c, int k, int *newRow)
+ *
+ * Description: Replaces row k of B and applies the rank-1 correction
+ * A[:, k] * (new - old row) to C, in O(n * changed columns).
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to Matrix structure.
+ * b             in/out      ptr to Matrix structure, row k replaced.
+ * c             in/out      ptr to Matrix structure.
+ * k             in          Row of B that changed.
+ * newRow        in          b->cols new values.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Updated.
+ * FALSE         Shapes do not match or k is out of range.
+ ***********************************************************************/
+int updateRowB(Matrix *a, Matrix *b, Matrix *c, int k, int *newRow)
+{
+    int *cols;
+    int *delta;
+    int numChanged = 0;
+    int aik;
+    int i;
+    int j;
+    if (!isDefined(a, b) || c->rows != a->rows || c->cols != b->cols ||
+        k < 0 || k >= b->rows)
+        return FALSE;
+    cols = malloc(sizeof(int) * 2 * b->cols);
+    if (cols == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    delta = cols + b->cols;
+    for (j = 0; j < b->cols; j++)
+        if (newRow[j] != b->m[k][j])
+        {
+            cols[numChanged] = j;
+            delta[numChanged++] = newRow[j] - b->m[k][j];
+            b->m[k][j] = newRow[j];
+        }
+    #pragma omp parallel for schedule(static) private(aik, j) \
+        if (numChanged * c->rows > 4096)
+    for (i = 0; i < c->rows; i++)
+    {
+        aik = a->m[i][k];
+        if (aik != 0)
+            for (j = 0; j < numChanged; j++)
+                c->m[i][cols[j]] += aik * delta[j];
+    }
+    free(cols);
+    return TRUE;
+}
+
+/*****************************   deltaInit   ****************************
+ * void deltaInit(MatrixDelta *d)
+ *
+ * Description: Empties a batch of changes.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * d             out         ptr to MatrixDelta structure, see define.h.
+ ***********************************************************************/
+void deltaInit(MatrixDelta *d)
+{
+    d->entries = NULL;
+    d->count = 0;
+    d->capacity = 0;
+}
+
+/*****************************   deltaSet   *****************************
+ * void deltaSet(MatrixDelta *d, int bOfB, int row, int col, int value)
+ *
+ * Description: Records a new value for one element of A or B. Nothing
+ * changes until deltaApply. If an element is set twice, the last value
+ * wins.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * d             in/out      ptr to MatrixDelta structure, see define.h.
+ * bOfB          in          TRUE for an element of B, FALSE for A.
+ * row, col      in          Element position.
+ * value         in          New value.
+ ***********************************************************************/
+void deltaSet(MatrixDelta *d, int bOfB, int row, int col, int value)
+{
+    DeltaEntry *grown;
+    if (d->count == d->capacity)
+    {
+        d->capacity = d->capacity ? d->capacity * 2 : 64;
+        grown = realloc(d->entries, sizeof(DeltaEntry) * d->capacity);
+        if (grown == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
+        d->entries = grown;
+    }
+    d->entries[d->count].bOfB = bOfB ? TRUE : FALSE;
+    d->entries[d->count].row = row;
+    d->entries[d->count].col = col;
+    d->entries[d->count].value = value;
+    d->count++;
+}
+
+/****************************   indexOf   *******************************
+ * static int indexOf(int *map, int *list, int *count, int x)
+ *
+ * Description: Compact index of x, adding it to list if new. map holds
+ * -1 for values not seen yet.
+ ***********************************************************************/
+static int indexOf(int *map, int *list, int *count, int x)
+{
+    if (map[x] < 0)
+    {
+        map[x] = *count;
+        list[(*count)++] = x;
+    }
+    return map[x];
+}
+
+/*****************************   lowRank   ******************************
+ * static void lowRank(Matrix *u, Matrix *v, Matrix *c, int *rows,
+ *                     int *cols)
+ *
+ * Description: Adds u*v to the elements of c picked out by rows and
+ * cols (rows[i], cols[j] receives (u*v)[i][j]), then frees u and v.
+ * rows or cols NULL means all, in order.
+ ***********************************************************************/
+static void lowRank(Matrix *u, Matrix *v, Matrix *c, int *rows, int *cols)
+{
+    MatrixView vu;
+    MatrixView vv;
+    MatrixView vw;
+    Matrix w;
+    int *dst;
+    int i;
+    int j;
+    setUp2D(&w, u->rows, v->cols, FALSE);
+    makeView(&vu, u, FALSE);
+    makeView(&vv, v, FALSE);
+    makeView(&vw, &w, FALSE);
+    multiplyView(&vu, &vv, &vw);
+    #pragma omp parallel for schedule(static) private(dst, j)
+    for (i = 0; i < w.rows; i++)
+    {
+        dst = c->m[rows != NULL ? rows[i] : i];
+        for (j = 0; j < w.cols; j++)
+            dst[cols != NULL ? cols[j] : j] += w.m[i][j];
+    }
+    free2D(&w);
+    free2D(u);
+    free2D(v);
+}
+
+/*****************************   applyHalf   ****************************
+ * static void applyHalf(Matrix *a, Matrix *b, Matrix *c, MatrixDelta *d,
+ *                       int bOfB, int *work, int size)
+ *
+ * Description: Applies the changes to one operand, see deltaApply.
+ *
+ * Process:
+ * 1.) Number the changed rows and columns of the operand in order of
+ *     first appearance.
+ * 2.) For B: u = A[:, K], v = dB[K, J], add u*v to C[:, J].
+ *     For A: u = dA[I, K], v = B[K, :], add u*v to C[I, :].
+ * 3.) Write the new values into the operand.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * work          in          4 * size ints of scratch.
+ * size          in          At least every dimension of A, B and C.
+ ***********************************************************************/
+static void applyHalf(Matrix *a, Matrix *b, Matrix *c, MatrixDelta *d,
+                      int bOfB, int *work, int size)
+{
+    Matrix *target = bOfB ? b : a;
+    Matrix u;
+    Matrix v;
+    DeltaEntry *e;
+    int *rowMap = work;
+    int *colMap = work + size;
+    int *rowList = work + 2 * size;
+    int *colList = work + 3 * size;
+    int numRows = 0;
+    int numCols = 0;
+    int n;
+    int i;
+    int j;
+    memset(work, -1, sizeof(int) * 2 * size);
+    for (n = 0; n < d->count; n++)
+        if (d->entries[n].bOfB == bOfB)
+        {
+            indexOf(rowMap, rowList, &numRows, d->entries[n].row);
+            indexOf(colMap, colList, &numCols, d->entries[n].col);
+        }
+    if (numRows == 0)
+        return;
+    if (bOfB)
+    {
+        setUp2D(&u, a->rows, numRows, FALSE);
+        setUp2D(&v, numRows, numCols, FALSE);
+        for (i = 0; i < a->rows; i++)
+            for (j = 0; j < numRows; j++)
+                u.m[i][j] = a->m[i][rowList[j]];
+    }
+    else
+    {
+        setUp2D(&u, numRows, numCols, FALSE);
+        setUp2D(&v, numCols, b->cols, FALSE);
+        for (i = 0; i < numCols; i++)
+            memcpy(v.m[i], b->m[colList[i]], sizeof(int) * b->cols);
+    }
+    // Assigned, not added, so the last entry for an element wins
+    for (n = 0; n < d->count; n++)
+    {
+        e = &d->entries[n];
+        if (e->bOfB != bOfB)
+            continue;
+        if (bOfB)
+            v.m[rowMap[e->row]][colMap[e->col]] =
+                e->value - b->m[e->row][e->col];
+        else
+            u.m[rowMap[e->row]][colMap[e->col]] =
+                e->value - a->m[e->row][e->col];
+    }
+    lowRank(&u, &v, c, bOfB ? NULL : rowList, bOfB ? colList : NULL);
+    for (n = 0; n < d->count; n++)
+    {
+        e = &d->entries[n];
+        if (e->bOfB == bOfB)
+            target->m[e->row][e->col] = e->value;
+    }
+}
+
+/*****************************   deltaApply   ***************************
+ * int deltaApply(Matrix *a, Matrix *b, Matrix *c, MatrixDelta *d)
+ *
+ * Description: Applies a batch of changes to A and B and brings C up to
+ * date with two low-rank products. With A' = A + dA and B' = B + dB,
+ * A'B' - AB = A dB + dA B'.
+ *
+ * Process:
+ * 1.) Apply the changes to B against the old A.
+ * 2.) Apply the changes to A against the new B.
+ * 3.) Empty d.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a, b          in/out      ptr to Matrix structures, changes written.
+ * c             in/out      ptr to Matrix structure, updated.
+ * d             in/out      ptr to MatrixDelta structure, emptied.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Updated.
+ * FALSE         Shapes do not match or an element is out of range.
+ *               Nothing is changed and d is kept.
+ *
+ * NOTES:
+ * - For B changes in rows K and columns J, costs O(n * |K| * |J|).
+ *   For A changes in rows I and columns K, O(|I| * |K| * m).
+ ***********************************************************************/
+int deltaApply(Matrix *a, Matrix *b, Matrix *c, MatrixDelta *d)
+{
+    Matrix *target;
+    int *work;
+    int size;
+    int n;
+    if (!isDefined(a, b) || c->rows != a->rows || c->cols != b->cols)
+        return FALSE;
+    for (n = 0; n < d->count; n++)
+    {
+        target = d->entries[n].bOfB ? b : a;
+        if (d->entries[n].row < 0 || d->entries[n].row >= target->rows ||
+            d->entries[n].col < 0 || d->entries[n].col >= target->cols)
+            return FALSE;
+    }
+    size = a->rows > a->cols ? a->rows : a->cols;
+    size = size > b->cols ? size : b->cols;
+    work = malloc(sizeof(int) * 4 * size);
+    if (work == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    applyHalf(a, b, c, d, TRUE, work, size);
+    applyHalf(a, b, c, d, FALSE, work, size);
+    free(work);
+    d->count = 0;
+    return TRUE;
+}
+
+/*****************************   deltaFree   ****************************
+ * void deltaFree(MatrixDelta *d)
+ *
+ * Description: Releases a batch's memory. It can be reused after
+ * deltaInit.
+ ***********************************************************************/
+void deltaFree(MatrixDelta *d)
+{
+    free(d->entries);
+    deltaInit(d);
+}
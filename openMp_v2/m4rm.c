@@ -0,0 +1,181 @@
+#include "define.h"
+#include <string.h>
+
+/***********************************************************************
+ * m4rm.c written by DSU_410 team ...
+ *
+ * Description: Method of Four Russians for bit matrices, over GF(2)
+ * (XOR of ANDs) or boolean (OR of ANDs). Bits k0 .. k0+7 of a row of A
+ * select one of the 256 combinations of rows k0 .. k0+7 of B. The table
+ * of all 256 combinations costs 256 row operations to build and then
+ * answers each row of A with one lookup, instead of up to 8 row
+ * operations. That is a log factor less work than the packed cubic
+ * product.
+ *
+ * The table covers a stripe of M4RM_STRIPE_WORDS words of B and C, 64KB
+ * with the defaults, so it stays in L2 while the rows of A look it up.
+ * Work is shared out as (block of M4RM_ROW_BLOCK rows of C, stripe)
+ * pairs. Each pair builds its own tables, about an eighth of its lookup
+ * work at the default block size.
+ *
+ * Unlike bitMultiply, B is packed as is, not transposed, since whole
+ * rows of B are combined.
+ *
+ * Functions:
+ * - m4rm
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/*****************************   buildTable   ***************************
+ * static void buildTable(BitMatrix *b, int k0, int w0, int numWords,
+ *                        int bGF2, uint64_t *table)
+ *
+ * Description: Fills table entry x, numWords words each, with the XOR
+ * (bGF2) or OR of rows k0 + bit of b, words w0 onwards, for the bits
+ * set in x. Rows past the end of b count as zero.
+ *
+ * Process:
+ * 1.) GF(2): walk the Gray code, each entry is the previous one with
+ *     one row toggled.
+ * 2.) Boolean: OR cannot toggle, so each entry is the entry without
+ *     its lowest bit ORed with that bit's row.
+ ***********************************************************************/
+static void buildTable(BitMatrix *b, int k0, int w0, int numWords,
+                       int bGF2, uint64_t *table)
+{
+    uint64_t *dst;
+    uint64_t *prev;
+    uint64_t *row;
+    int gray;
+    int bit;
+    int x;
+    int w;
+    memset(table, 0, sizeof(uint64_t) * numWords);
+    for (x = 1; x < (1 << M4RM_BITS); x++)
+    {
+        bit = __builtin_ctz(x);
+        if (bGF2)
+        {
+            gray = x ^ (x >> 1);
+            prev = table + (size_t) ((x - 1) ^ ((x - 1) >> 1)) * numWords;
+        }
+        else
+        {
+            gray = x;
+            prev = table + (size_t) (x & (x - 1)) * numWords;
+        }
+        dst = table + (size_t) gray * numWords;
+        if (k0 + bit >= b->rows)
+        {
+            memcpy(dst, prev, sizeof(uint64_t) * numWords);
+            continue;
+        }
+        row = BIT_ROW(b, k0 + bit) + w0;
+        if (bGF2)
+            for (w = 0; w < numWords; w++)
+                dst[w] = prev[w] ^ row[w];
+        else
+            for (w = 0; w < numWords; w++)
+                dst[w] = prev[w] | row[w];
+    }
+}
+
+/********************************   m4rm   ******************************
+ * int m4rm(BitMatrix *a, BitMatrix *b, BitMatrix *c, int bGF2)
+ *
+ * Description: C = A*B over GF(2) or the boolean semiring.
+ *
+ * Process:
+ * 1.) Share (row block, column stripe) pairs amongst threads.
+ * 2.) Zero the pair's part of C.
+ * 3.) For each group of M4RM_BITS rows of B build the stripe's table and
+ *     combine the selected entry into every row of the block.
+ * 4.) With metrics on, the call is recorded under BACKEND_M4RM.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to BitMatrix structure, see define.h.
+ * b             in          ptr to BitMatrix, a->cols rows, NOT
+ *                           transposed.
+ * c             out         ptr to BitMatrix, a->rows by b->cols. Its
+ *                           previous bits are replaced.
+ * bGF2          in          TRUE for GF(2), FALSE for boolean.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int m4rm(BitMatrix *a, BitMatrix *b, BitMatrix *c, int bGF2)
+{
+    long long start;
+    int numStripes = (c->words + M4RM_STRIPE_WORDS - 1) / M4RM_STRIPE_WORDS;
+    int numBlocks = (a->rows + M4RM_ROW_BLOCK - 1) / M4RM_ROW_BLOCK;
+    int t;
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    #pragma omp parallel
+    {
+        uint64_t *table = malloc(sizeof(uint64_t) * M4RM_STRIPE_WORDS *
+                                 (1 << M4RM_BITS));
+        uint64_t *src;
+        uint64_t *dst;
+        int numWords;
+        int row0;
+        int row1;
+        int w0;
+        int k0;
+        int x;
+        int i;
+        int w;
+        if (table == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
+        #pragma omp for schedule(dynamic)
+        for (t = 0; t < numBlocks * numStripes; t++)
+        {
+            row0 = t / numStripes * M4RM_ROW_BLOCK;
+            row1 = row0 + M4RM_ROW_BLOCK < a->rows ? row0 + M4RM_ROW_BLOCK
+                                                    : a->rows;
+            w0 = t % numStripes * M4RM_STRIPE_WORDS;
+            numWords = c->words - w0 < M4RM_STRIPE_WORDS ? c->words - w0
+                                                         : M4RM_STRIPE_WORDS;
+            for (i = row0; i < row1; i++)
+                memset(BIT_ROW(c, i) + w0, 0, sizeof(uint64_t) * numWords);
+            for (k0 = 0; k0 < a->cols; k0 += M4RM_BITS)
+            {
+                buildTable(b, k0, w0, numWords, bGF2, table);
+                for (i = row0; i < row1; i++)
+                {
+                    x = (int) (BIT_ROW(a, i)[k0 >> 6] >> (k0 & 63)) &
+                        ((1 << M4RM_BITS) - 1);
+                    if (x == 0)
+                        continue;
+                    src = table + (size_t) x * numWords;
+                    dst = BIT_ROW(c, i) + w0;
+                    if (bGF2)
+                        for (w = 0; w < numWords; w++)
+                            dst[w] ^= src[w];
+                    else
+                        for (w = 0; w < numWords; w++)
+                            dst[w] |= src[w];
+                }
+            }
+        }
+        free(table);
+    }
+    if (start >= 0)
+        metricsRecord(BACKEND_M4RM, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
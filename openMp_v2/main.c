@@ -1,4 +1,5 @@
 #include "define.h"
+#include <string.h>
 /***********************************************************************
  * main.c written by DSU_410 team ...
  *
@@ -6,8 +7,33 @@
  * and store the result. OpenMP implementation version two, does not use
  * global variables for arrays.
  *
- * compile: %gcc main.c 2DArray.c matrix.c -o mmopenmp_v2 -fopenmp
- * execute: ./mmopenmp_v2
+ * compile: %gcc main.c 2DArray.c matrix.c view.c chain.c epilogue.c power.c
+ *          arena.c perf.c metrics.c tune.c transport.c dist.c server.c
+ *          client.c async.c cache.c incremental.c syrk.c band.c
+ *          triangular.c blocksparse.c bitmatrix.c m4rm.c semiring.c
+ *          modular.c transpose.c morton.c splitk.c gemv.c -o mmopenmp_v2
+ *          -fopenmp -lpthread
+ * execute: ./mmopenmp_v2 [--perf] [--metrics] [--tune]
+ *          [--dist RxC] [--shm] [--serve [path]] [--huge [thp|2m|1g]]
+ *
+ * --perf writes hardware counters for each phase, and for each thread
+ * of the multiply, to stderr as JSON lines (see perf.c).
+ * --metrics writes per shape class call counts and latency percentiles
+ * to stderr as JSON at exit (see metrics.c).
+ * --tune searches block sizes, thread count and schedule for this
+ * program's shape and a few squares, then saves them to TUNE_PROFILE
+ * (see tune.c). Later runs on the same machine pick them up.
+ * --dist RxC multiplies with R*C processes in an R-by-C grid (see
+ * dist.c), talking over Unix sockets, or shared memory with --shm. The
+ * ranks are forked first thing, before OpenMP starts its threads.
+ * --serve runs the multiply service on a Unix socket, SERVE_PATH by
+ * default, until a client shuts it down (see server.c).
+ * --huge puts the matrices in an arena on huge pages, explicit 2 MB
+ * pages by default, pre-faulted in parallel, and writes the backing
+ * actually obtained to stderr as JSON lines (see arena.c).
+ *
+ * check.c builds into mmcheck instead of main.c, which compares the
+ * kernels with naive products and exits non-zero on any mismatch.
  *
  * Process:
  * 1.) Fill two 2D arrays matrixA and matrixB with random values.
@@ -23,22 +49,98 @@ static int M = 20;
 int main(int argc, const char * argv[])
 {
     Matrix A, B, C;
+    PerfCounters pc;
+    MatrixArena arena;
+    int hugeMode = -1;
     int bPerformed = TRUE;
+    int bTune = FALSE;
+    int gridRows = 0;
+    int gridCols = 0;
+    int transport = TRANSPORT_SOCKET;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--perf") == 0)
+            perfEnable(stderr);
+        else if (strcmp(argv[i], "--metrics") == 0)
+            metricsEnable(stderr);
+        else if (strcmp(argv[i], "--tune") == 0)
+            bTune = TRUE;
+        else if (strcmp(argv[i], "--shm") == 0)
+            transport = TRANSPORT_SHM;
+        else if (strcmp(argv[i], "--dist") == 0 && i + 1 < argc &&
+                 sscanf(argv[i + 1], "%dx%d", &gridRows, &gridCols) == 2)
+            i++;
+        else if (strcmp(argv[i], "--serve") == 0)
+            return serveMatrices(i + 1 < argc ? argv[i + 1] : SERVE_PATH)
+                   ? 0 : 1;
+        else if (strcmp(argv[i], "--huge") == 0)
+        {
+            hugeMode = ARENA_HUGE_2MB;
+            if (i + 1 < argc && strcmp(argv[i + 1], "thp") == 0)
+                hugeMode = ARENA_HUGE_THP;
+            else if (i + 1 < argc && strcmp(argv[i + 1], "1g") == 0)
+                hugeMode = ARENA_HUGE_1GB;
+            if (i + 1 < argc && (strcmp(argv[i + 1], "thp") == 0 ||
+                                 strcmp(argv[i + 1], "2m") == 0 ||
+                                 strcmp(argv[i + 1], "1g") == 0))
+                i++;
+        }
+    }
+
+    // Fork the ranks while this is the only thread, see dist.c
+    if (gridRows > 0 && !distInit(gridRows, gridCols, transport))
+        fprintf(stderr, "Could not start %dx%d ranks\n", gridRows, gridCols);
+
+    // Tune before the timed run so it already uses the new profile
+    if (bTune)
+    {
+        tuneShape(N, M, P, stderr);
+        for (i = 128; i <= 512; i *= 2)
+            tuneShape(i, i, i, stderr);
+        if (!saveTuneProfile(TUNE_PROFILE))
+            fprintf(stderr, "Could not write %s\n", TUNE_PROFILE);
+    }
     
+    // Matrices come from the huge page arena with --huge
+    if (hugeMode >= 0)
+    {
+        arenaInit(&arena, 0, hugeMode | ARENA_PREFAULT);
+        setArena2D(&arena);
+    }
+
     // Set up Matrices, includes memory allocation and assigning
     // values
+    perfStartProcess(&pc);
     setUpMatrices(&A, &B, &C);
+    perfStop(&pc);
+    perfReport("setup", -1, &pc);
 
     // Try to multiply Matrices A B, store result into Matrix C
     // If not performed FALSE is returned
-    bPerformed = multiply(&A, &B, &C);
+    perfStartProcess(&pc);
+    if (gridRows > 0)
+        bPerformed = distMultiply(&A, &B, &C, gridRows, gridCols, transport);
+    else
+        bPerformed = multiply(&A, &B, &C);
+    perfStop(&pc);
+    perfReport("multiply", -1, &pc);
+    if (hugeMode >= 0)
+        arenaReport(&arena, stderr);
     
     // Matrix multiplication was performed, print out results stored
     // in Matrix C
+    perfStartProcess(&pc);
     printResult(&A, &B, &C, bPerformed);
+    perfStop(&pc);
+    perfReport("output", -1, &pc);
     
     // Free memory
     freeMemory(&A, &B, &C);
+    distFinish();
+    if (hugeMode >= 0)
+        arenaDestroy(&arena);
     
     return 0;
 }
@@ -11,6 +11,9 @@
  * Functions:
  * - isDefined
  * - multiply
+ * - multiplyView
+ * - multiplyEpilogue
+ * - multiplyBlock
  *
  * compile: Used with main.c, not meant to be independently executable
  *
@@ -18,6 +21,19 @@
  * 1.) Used when functions are invoked.
  ************************************************************************/
 
+// Per thread packing buffers used by multiplyBlock
+typedef struct
+{
+    int *packA;     // blockM x blockK block of A, row major
+    int *packB;     // blockK x blockN block of B, row major
+    int *acc;       // blockM x blockN accumulator for one C tile
+    int capA;
+    int capB;
+    int capAcc;
+} GemmWork;
+
+static __thread GemmWork work;
+
 /*******************************   isDefined   ********************************
  * int isDefined(Matrix *a, Matrix *b)
  *
@@ -52,6 +68,247 @@ int isDefined(Matrix *a, Matrix *b)
     return bVal;
 }
 
+/****************************   growBuffer   ********************************
+ * static int *growBuffer(int *p, int *cap, int size)
+ *
+ * Description: Makes sure buffer p holds at least size ints, replacing it
+ * with a larger one if needed. Old contents are not kept.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * p             in          current buffer, may be NULL.
+ * cap           in/out      capacity of p in ints, updated on growth.
+ * size          in          ints required.
+ *
+ * Returns       Description
+ * ----------------------------------------------------------------------------
+ * ptr           Buffer of at least size ints.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ******************************************************************************/
+static int *growBuffer(int *p, int *cap, int size)
+{
+    if (size > *cap)
+    {
+        free(p);
+        p = malloc(sizeof(int) * size);
+        if (p == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
+        *cap = size;
+    }
+    return p;
+}
+
+/*****************************   getWork   **********************************
+ * static GemmWork *getWork(int sizeA, int sizeB, int sizeAcc)
+ *
+ * Description: Returns the calling thread's packing buffers, grown to hold
+ * at least the requested number of ints. Buffers are kept between calls so
+ * repeated multiplies on the same threads allocate nothing.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * sizeA         in          ints needed for a packed block of A.
+ * sizeB         in          ints needed for a packed block of B.
+ * sizeAcc       in          ints needed for the C tile accumulator.
+ *
+ * Returns       Description
+ * ----------------------------------------------------------------------------
+ * ptr           Thread local GemmWork structure.
+ ******************************************************************************/
+static GemmWork *getWork(int sizeA, int sizeB, int sizeAcc)
+{
+    work.packA = growBuffer(work.packA, &work.capA, sizeA);
+    work.packB = growBuffer(work.packB, &work.capB, sizeB);
+    work.acc = growBuffer(work.acc, &work.capAcc, sizeAcc);
+    return &work;
+}
+
+/*****************************   packBlock   *********************************
+ * static void packBlock(MatrixView *v, int row0, int col0, int numRows,
+ *                       int numCols, int *dst)
+ *
+ * Description: Copies the numRows-by-numCols block of view v starting at
+ * (row0, col0) into dst as a contiguous row major array. Transposed views
+ * are handled here, so the compute loop never sees the difference.
+ *
+ * Process:
+ * 1.) Walk the underlying storage row by row so reads stay contiguous.
+ * 2.) Write each value to its logical position in dst.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * v             in          ptr to MatrixView being packed.
+ * row0, col0    in          logical top left corner of the block.
+ * numRows       in          logical rows in the block.
+ * numCols       in          logical columns in the block.
+ * dst           out         numRows * numCols ints, row major.
+ ******************************************************************************/
+static void packBlock(MatrixView *v, int row0, int col0, int numRows,
+                      int numCols, int *dst)
+{
+    int i;
+    int j;
+    int *src;
+    if (v->bTrans)
+    {
+        // storage row (col0 + j) holds logical column col0 + j
+        for (j = 0; j < numCols; j++)
+        {
+            src = v->m[col0 + j] + v->col0 + row0;
+            for (i = 0; i < numRows; i++)
+                dst[i * numCols + j] = src[i];
+        }
+    }
+    else
+    {
+        for (i = 0; i < numRows; i++)
+        {
+            src = v->m[row0 + i] + v->col0 + col0;
+            for (j = 0; j < numCols; j++)
+                dst[i * numCols + j] = src[j];
+        }
+    }
+}
+
+/*****************************   storeTile   *********************************
+ * static void storeTile(MatrixView *c, int row0, int col0, int numRows,
+ *                       int numCols, int *acc, Epilogue *epi)
+ *
+ * Description: Adds a row major accumulator tile into view c at logical
+ * position (row0, col0). With an epilogue, the old C values are folded
+ * into the accumulator, the epilogue runs on it while it is still in
+ * cache, and the finished values are written to C once.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * c             in/out      ptr to MatrixView receiving the tile.
+ * row0, col0    in          logical top left corner of the tile.
+ * numRows       in          logical rows in the tile.
+ * numCols       in          logical columns in the tile.
+ * acc           in/out      numRows * numCols ints, row major.
+ * epi           in          ptr to Epilogue, see define.h, or NULL.
+ ******************************************************************************/
+static void storeTile(MatrixView *c, int row0, int col0, int numRows,
+                      int numCols, int *acc, Epilogue *epi)
+{
+    int i;
+    int j;
+    int *dst;
+    if (epi != NULL && epi->count > 0)
+    {
+        for (i = 0; i < numRows; i++)
+            for (j = 0; j < numCols; j++)
+                acc[i * numCols + j] += VIEW_AT(c, row0 + i, col0 + j);
+        applyEpilogue(epi, acc, numRows, numCols, row0, col0);
+    }
+    if (c->bTrans)
+    {
+        for (j = 0; j < numCols; j++)
+        {
+            dst = c->m[col0 + j] + c->col0 + row0;
+            if (epi != NULL && epi->count > 0)
+                for (i = 0; i < numRows; i++)
+                    dst[i] = acc[i * numCols + j];
+            else
+                for (i = 0; i < numRows; i++)
+                    dst[i] += acc[i * numCols + j];
+        }
+    }
+    else
+    {
+        for (i = 0; i < numRows; i++)
+        {
+            dst = c->m[row0 + i] + c->col0 + col0;
+            if (epi != NULL && epi->count > 0)
+                for (j = 0; j < numCols; j++)
+                    dst[j] = acc[i * numCols + j];
+            else
+                for (j = 0; j < numCols; j++)
+                    dst[j] += acc[i * numCols + j];
+        }
+    }
+}
+
+/****************************   multiplyBlock   ******************************
+ * void multiplyBlock(MatrixView *a, MatrixView *b, MatrixView *c, int row0,
+ *                    int col0, int uplo, Epilogue *epi, TuneParams *tp)
+ *
+ * Description: Computes the tile of C += A*B whose top left corner is
+ * (row0, col0), tp->blockM by tp->blockN or less at the edges of C.
+ *
+ * Process:
+ * 1.) Zero the tile accumulator.
+ * 2.) For every tp->blockK panel of the shared dimension pack the blocks
+ *     of A and B and accumulate their product.
+ * 3.) With uplo, zero the part of the accumulator outside the requested
+ *     triangle of C, so those elements keep their values.
+ * 4.) Add the accumulator into C, applying the epilogue if any.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * a, b          in          ptr to MatrixView operands.
+ * c             in/out      ptr to MatrixView result.
+ * row0, col0    in          top left corner of the tile in C.
+ * uplo          in          UPLO_FULL, or UPLO_UPPER / UPLO_LOWER to keep
+ *                           j >= i / j <= i only (see syrk.c).
+ * epi           in          ptr to Epilogue, see define.h, or NULL. Not
+ *                           meant to be combined with a triangle.
+ * tp            in          ptr to TuneParams giving the block sizes.
+ *
+ * NOTES:
+ * - Called inside parallel regions, uses the calling thread's buffers.
+ ******************************************************************************/
+void multiplyBlock(MatrixView *a, MatrixView *b, MatrixView *c, int row0,
+                   int col0, int uplo, Epilogue *epi, TuneParams *tp)
+{
+    GemmWork *w = getWork(tp->blockM * tp->blockK, tp->blockK * tp->blockN,
+                          tp->blockM * tp->blockN);
+    int numRows = c->rows - row0 < tp->blockM ? c->rows - row0 : tp->blockM;
+    int numCols = c->cols - col0 < tp->blockN ? c->cols - col0 : tp->blockN;
+    int *acc = w->acc;
+    int *accRow;
+    int *aRow;
+    int *bRow;
+    int aik;
+    int kk;
+    int kb;
+    int i;
+    int j;
+    int k;
+    for (i = 0; i < numRows * numCols; i++)
+        acc[i] = 0;
+    for (kk = 0; kk < a->cols; kk += tp->blockK)
+    {
+        kb = a->cols - kk < tp->blockK ? a->cols - kk : tp->blockK;
+        packBlock(a, row0, kk, numRows, kb, w->packA);
+        packBlock(b, kk, col0, kb, numCols, w->packB);
+        for (i = 0; i < numRows; i++)
+        {
+            accRow = acc + i * numCols;
+            aRow = w->packA + i * kb;
+            for (k = 0; k < kb; k++)
+            {
+                aik = aRow[k];
+                bRow = w->packB + k * numCols;
+                for (j = 0; j < numCols; j++)
+                    accRow[j] += aik * bRow[j];
+            }
+        }
+    }
+    if (uplo != UPLO_FULL)
+        for (i = 0; i < numRows; i++)
+            for (j = 0; j < numCols; j++)
+                if (uplo == UPLO_UPPER ? col0 + j < row0 + i
+                                       : col0 + j > row0 + i)
+                    acc[i * numCols + j] = 0;
+    storeTile(c, row0, col0, numRows, numCols, acc, epi);
+}
+
 /*******************************   multiply   ********************************
  * int multiply(Matrix *a, Matrix *b, Matrix *c)
  *
@@ -59,7 +316,10 @@ int isDefined(Matrix *a, Matrix *b)
  * results into Matrix c.
  *
  * Process:
- * 1.) Perform multiplication and store result.
+ * 1.) If the product cache is on, let multiplyCached handle it.
+ * 2.) If a dimension is 1, let multiplyVector handle it.
+ * 3.) Otherwise wrap each Matrix in a full, untransposed view.
+ * 4.) Perform multiplication and store result by calling multiplyView.
  *
  * Parameter     Direction   Description
  * ----------------------------------------------------------------------------
@@ -81,18 +341,143 @@ int isDefined(Matrix *a, Matrix *b)
  ******************************************************************************/
 int multiply(Matrix *a, Matrix *b, Matrix *c)
 {
-    int bVal = TRUE;
-    int i;
-    int j;
-    int k;
-    bVal = isDefined(a, b);
+    MatrixView va;
+    MatrixView vb;
+    MatrixView vc;
+    int bVal = isDefined(a, b);
+    if (bVal && cacheEnabled())
+        bVal = multiplyCached(a, b, c);
+    else if (bVal && (a->rows == 1 || a->cols == 1 || b->cols == 1))
+        bVal = multiplyVector(a, b, c);
+    else if (bVal)
+    {
+        makeView(&va, a, FALSE);
+        makeView(&vb, b, FALSE);
+        makeView(&vc, c, FALSE);
+        bVal = multiplyView(&va, &vb, &vc);
+    }
+    return bVal;
+}
+
+/*****************************   multiplyView   ******************************
+ * int multiplyView(MatrixView *a, MatrixView *b, MatrixView *c)
+ *
+ * Description: Performs C += A*B on views, so any operand may be a block
+ * of a larger Matrix or a transpose. Nothing is copied outside of the
+ * per thread packing buffers.
+ *
+ * Process:
+ * 1.) Call multiplyEpilogue with no epilogue.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * a             in          ptr to MatrixView, left operand.
+ * b             in          ptr to MatrixView, right operand.
+ * c             in/out      ptr to MatrixView, product is added into it.
+ *
+ * Returns       Description
+ * ----------------------------------------------------------------------------
+ * TRUE          Matrix multiplication was performed.
+ * FALSE         Matrix multiplication was not performed.
+ *
+ * NOTES:
+ * - c must not overlap a or b.
+ * - Like multiply, accumulates into c, so c is normally zeroed first.
+ ******************************************************************************/
+int multiplyView(MatrixView *a, MatrixView *b, MatrixView *c)
+{
+    return multiplyEpilogue(a, b, c, NULL);
+}
+
+/***************************   multiplyEpilogue   ****************************
+ * int multiplyEpilogue(MatrixView *a, MatrixView *b, MatrixView *c,
+ *                      Epilogue *epi)
+ *
+ * Description: Performs C = epi(C + A*B) on views. The epilogue (bias,
+ * scale, clamp, ReLU, ...) is applied to each C tile while it is still
+ * in the accumulator, so post-processing costs no extra pass over C.
+ *
+ * Process:
+ * 1.) Check the product is defined and fits c.
+ * 2.) Look up block sizes, thread count and schedule for the shape, see
+ *     tune.c.
+ * 3.) Split C into blockM-by-blockN tiles and share the tiles amongst
+ *     threads, each computed by multiplyBlock. When there are too few
+ *     tiles for the threads and the shared dimension is long, split
+ *     that too, see splitk.c.
+ * 4.) With instrumentation on, each thread reports counters for its
+ *     share of the tiles.
+ * 5.) With metrics on, the call is recorded under its shape class.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * a             in          ptr to MatrixView, left operand.
+ * b             in          ptr to MatrixView, right operand.
+ * c             in/out      ptr to MatrixView, result.
+ * epi           in          ptr to Epilogue, see define.h, or NULL for
+ *                           plain C += A*B.
+ *
+ * Returns       Description
+ * ----------------------------------------------------------------------------
+ * TRUE          Matrix multiplication was performed.
+ * FALSE         Matrix multiplication was not performed.
+ *
+ * NOTES:
+ * - c must not overlap a or b.
+ ******************************************************************************/
+int multiplyEpilogue(MatrixView *a, MatrixView *b, MatrixView *c,
+                     Epilogue *epi)
+{
+    int bVal = isDefinedView(a, b, c);
+    long long start = metricsEnabled() ? metricsNow() : -1;
+    TuneParams tp;
+    int numSlices;
+    int numTiles;
+    int tilesN;
+    int t;
     if (bVal)
     {
-        #pragma omp parallel for private(i, j, k)
-        for (i = 0; i < a->rows; i++)
-            for (j = 0; j < b->cols; j++)
-                for (k = 0; k < b->rows; k++)
-                    c->m[i][j] += a->m[i][k] * b->m[k][j];
+        getTuneParams(c->rows, c->cols, a->cols, &tp);
+        tilesN = (c->cols + tp.blockN - 1) / tp.blockN;
+        numTiles = ((c->rows + tp.blockM - 1) / tp.blockM) * tilesN;
+        numSlices = splitKSlices(c->rows, c->cols, a->cols, &tp);
+        if (numSlices > 1)
+            multiplySplitK(a, b, c, epi, &tp, numSlices);
+        else
+        {
+            #pragma omp parallel num_threads(tp.numThreads > 0 ? tp.numThreads \
+                                                                : MAX_THREADS())
+            {
+                PerfCounters pc;
+                int bMeasure = perfEnabled();
+                if (bMeasure)
+                    perfStart(&pc);
+                if (tp.schedule == SCHED_DYNAMIC)
+                {
+                    #pragma omp for schedule(dynamic)
+                    for (t = 0; t < numTiles; t++)
+                        multiplyBlock(a, b, c, t / tilesN * tp.blockM,
+                                      t % tilesN * tp.blockN, UPLO_FULL, epi,
+                                      &tp);
+                }
+                else
+                {
+                    #pragma omp for schedule(static)
+                    for (t = 0; t < numTiles; t++)
+                        multiplyBlock(a, b, c, t / tilesN * tp.blockM,
+                                      t % tilesN * tp.blockN, UPLO_FULL, epi,
+                                      &tp);
+                }
+                if (bMeasure)
+                {
+                    perfStop(&pc);
+                    perfReport("multiply.thread", THREAD_NUM(), &pc);
+                }
+            }
+        }
+        if (start >= 0)
+            metricsRecord(BACKEND_BLOCKED, c->rows, c->cols, a->cols,
+                          metricsNow() - start);
     }
     return bVal;
 }
\ No newline at end of file
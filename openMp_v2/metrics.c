@@ -0,0 +1,369 @@
+#include "define.h"
+#include <string.h>
+#include <pthread.h>
+
+/***********************************************************************
+ * metrics.c written by DSU_410 team ...
+ *
+ * Description: Per call metrics for the multiply entry points. Every
+ * call is filed under its shape class, the power-of-two buckets of M, N
+ * and K, and the backend that ran it. Each class keeps a call count,
+ * totals for time, flops and bytes touched, and a log-linear latency
+ * histogram (HDR style, 8 sub-buckets per power of two, so about 12%
+ * resolution) from which p50/p90/p99 are read.
+ *
+ * Each thread records into its own table, so recording takes no locks
+ * and no atomics. Tables are merged only when a report is written,
+ * either on demand with metricsDump or at exit.
+ *
+ * When metrics are off the entry points pay one test per call.
+ *
+ * Functions:
+ * - metricsEnable
+ * - metricsEnabled
+ * - metricsNow
+ * - metricsRecord
+ * - metricsDump
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// One shape class / backend on one thread
+typedef struct
+{
+    int bUsed;
+    int backend;
+    int mClass;                     // ceil(log2(M)), same for N and K
+    int nClass;
+    int kClass;
+    long long count;
+    long long totalNs;
+    long long minNs;
+    long long maxNs;
+    double flops;
+    double bytes;
+    long long hist[METRIC_BUCKETS];
+} MetricSlot;
+
+// A thread's table, linked into the global list on first use
+typedef struct MetricTable
+{
+    MetricSlot slot[METRIC_SLOTS];
+    long long dropped;              // calls that found the table full
+    struct MetricTable *next;
+} MetricTable;
+
+// Names used in the report, in the order of the BACKEND_* constants
+static const char *backendNames[NUM_BACKENDS] =
+{
+    "blocked", "dist", "cache", "syrk", "vector", "band", "trmm",
+    "bsparse", "bit", "m4rm", "semiring", "modular", "morton"
+};
+
+static FILE *metricsOut = NULL;
+static int bAtExit = FALSE;
+static MetricTable *tables = NULL;
+static pthread_mutex_t tablesLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread MetricTable *myTable = NULL;
+
+/****************************   metricsAtExit   *************************
+ * static void metricsAtExit(void)
+ *
+ * Description: atexit handler, writes the report if metrics are on.
+ ***********************************************************************/
+static void metricsAtExit(void)
+{
+    if (metricsOut != NULL)
+        metricsDump(metricsOut);
+}
+
+/****************************   metricsEnable   *************************
+ * void metricsEnable(FILE *out)
+ *
+ * Description: Turns metrics on, with the report written to out at
+ * exit, or off when out is NULL.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * out           in          Stream for the exit report, or NULL.
+ ***********************************************************************/
+void metricsEnable(FILE *out)
+{
+    metricsOut = out;
+    if (out != NULL && !bAtExit)
+    {
+        atexit(metricsAtExit);
+        bAtExit = TRUE;
+    }
+}
+
+/****************************   metricsEnabled   ************************
+ * int metricsEnabled(void)
+ *
+ * Description: Tells entry points whether to time the call at all.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Metrics are being recorded.
+ * FALSE         Metrics are off.
+ ***********************************************************************/
+int metricsEnabled(void)
+{
+    return metricsOut != NULL;
+}
+
+/*****************************   metricsNow   ***************************
+ * long long metricsNow(void)
+ *
+ * Description: Monotonic clock in nanoseconds, for timing a call.
+ ***********************************************************************/
+long long metricsNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*****************************   sizeClass   ****************************
+ * static int sizeClass(int n)
+ *
+ * Description: Smallest c with 2^c >= n, the bucket a dimension falls
+ * into.
+ ***********************************************************************/
+static int sizeClass(int n)
+{
+    int c = 0;
+    while (c < 31 && (1 << c) < n)
+        c++;
+    return c;
+}
+
+/****************************   bucketOf   ******************************
+ * static int bucketOf(long long ns)
+ *
+ * Description: Histogram bucket of a latency. Values below 8 get a
+ * bucket each. Above that, each power of two is split into 8 equal
+ * sub-buckets.
+ ***********************************************************************/
+static int bucketOf(long long ns)
+{
+    int e = 0;
+    int b;
+    if (ns < 8)
+        return ns < 0 ? 0 : (int) ns;
+    while ((ns >> e) >= 2)
+        e++;
+    b = (e - 2) * 8 + (int) ((ns >> (e - 3)) & 7);
+    return b < METRIC_BUCKETS ? b : METRIC_BUCKETS - 1;
+}
+
+/****************************   bucketMid   *****************************
+ * static double bucketMid(int b)
+ *
+ * Description: Middle of the latency range covered by bucket b.
+ ***********************************************************************/
+static double bucketMid(int b)
+{
+    int e;
+    double low;
+    if (b < 8)
+        return b;
+    e = b / 8 + 2;
+    low = (double) (8 + b % 8) * (double) (1LL << (e - 3));
+    return low + (double) (1LL << (e - 3)) / 2;
+}
+
+/****************************   metricsRecord   *************************
+ * void metricsRecord(int backend, int m, int n, int k, long long ns)
+ *
+ * Description: Files one multiply call under its shape class.
+ *
+ * Process:
+ * 1.) Find or create the slot in the calling thread's table.
+ * 2.) Update count, totals, min/max and histogram.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * backend       in          BACKEND_* constant, see define.h.
+ * m, n, k       in          C is m-by-n, shared dimension k.
+ * ns            in          Wall time of the call.
+ *
+ * NOTES:
+ * - Each thread gets a table the first time it records. That is the
+ *   only allocation and the only lock.
+ ***********************************************************************/
+void metricsRecord(int backend, int m, int n, int k, long long ns)
+{
+    MetricSlot *s;
+    int mc = sizeClass(m);
+    int nc = sizeClass(n);
+    int kc = sizeClass(k);
+    int h;
+    int i;
+    if (myTable == NULL)
+    {
+        myTable = calloc(1, sizeof(MetricTable));
+        if (myTable == NULL)
+            return;
+        pthread_mutex_lock(&tablesLock);
+        myTable->next = tables;
+        tables = myTable;
+        pthread_mutex_unlock(&tablesLock);
+    }
+    // Open addressing on the key
+    h = ((mc * 32 + nc) * 32 + kc) * NUM_BACKENDS + backend;
+    h %= METRIC_SLOTS;
+    for (i = 0; i < METRIC_SLOTS; i++)
+    {
+        s = &myTable->slot[(h + i) % METRIC_SLOTS];
+        if (!s->bUsed)
+        {
+            s->bUsed = TRUE;
+            s->backend = backend;
+            s->mClass = mc;
+            s->nClass = nc;
+            s->kClass = kc;
+            s->minNs = ns;
+            break;
+        }
+        if (s->backend == backend && s->mClass == mc && s->nClass == nc &&
+            s->kClass == kc)
+            break;
+    }
+    if (i == METRIC_SLOTS)
+    {
+        myTable->dropped++;
+        return;
+    }
+    s->count++;
+    s->totalNs += ns;
+    s->minNs = ns < s->minNs ? ns : s->minNs;
+    s->maxNs = ns > s->maxNs ? ns : s->maxNs;
+    s->flops += 2.0 * m * n * k;
+    s->bytes += (double) sizeof(int) * ((double) m * k + (double) k * n +
+                                        2.0 * m * n);
+    s->hist[bucketOf(ns)]++;
+}
+
+/****************************   percentile   ****************************
+ * static double percentile(MetricSlot *s, double q)
+ *
+ * Description: Latency below which a fraction q of the calls fell.
+ ***********************************************************************/
+static double percentile(MetricSlot *s, double q)
+{
+    long long target = (long long) (q * (s->count - 1));
+    long long seen = 0;
+    int b;
+    for (b = 0; b < METRIC_BUCKETS; b++)
+    {
+        seen += s->hist[b];
+        if (seen > target)
+            return bucketMid(b);
+    }
+    return (double) s->maxNs;
+}
+
+/*****************************   metricsDump   **************************
+ * void metricsDump(FILE *out)
+ *
+ * Description: Writes all metrics recorded so far as one JSON document,
+ * with one entry per (backend, M, N, K) class merged across threads.
+ * m_max, n_max and k_max are the upper bounds of the class.
+ *
+ * Process:
+ * 1.) Merge every thread's slots into one table.
+ * 2.) Print counts, totals, throughput and latency percentiles.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * out           in          Stream receiving the JSON.
+ *
+ * NOTES:
+ * - Reads other threads' tables without stopping them, so calls that
+ *   are being recorded during the dump may be partly counted.
+ ***********************************************************************/
+void metricsDump(FILE *out)
+{
+    MetricTable *merged = calloc(1, sizeof(MetricTable));
+    MetricTable *t;
+    MetricSlot *src;
+    MetricSlot *dst;
+    int bFirst = TRUE;
+    int i;
+    int j;
+    int b;
+    if (merged == NULL)
+        return;
+    pthread_mutex_lock(&tablesLock);
+    for (t = tables; t != NULL; t = t->next)
+    {
+        merged->dropped += t->dropped;
+        for (i = 0; i < METRIC_SLOTS; i++)
+        {
+            src = &t->slot[i];
+            if (!src->bUsed)
+                continue;
+            dst = NULL;
+            for (j = 0; j < METRIC_SLOTS && dst == NULL; j++)
+            {
+                if (!merged->slot[j].bUsed)
+                {
+                    dst = &merged->slot[j];
+                    *dst = *src;
+                    dst->count = 0;
+                    dst->totalNs = 0;
+                    dst->maxNs = 0;
+                    dst->flops = 0;
+                    dst->bytes = 0;
+                    memset(dst->hist, 0, sizeof(dst->hist));
+                }
+                else if (merged->slot[j].backend == src->backend &&
+                         merged->slot[j].mClass == src->mClass &&
+                         merged->slot[j].nClass == src->nClass &&
+                         merged->slot[j].kClass == src->kClass)
+                    dst = &merged->slot[j];
+            }
+            if (dst == NULL)
+            {
+                merged->dropped += src->count;
+                continue;
+            }
+            dst->count += src->count;
+            dst->totalNs += src->totalNs;
+            dst->minNs = src->minNs < dst->minNs ? src->minNs : dst->minNs;
+            dst->maxNs = src->maxNs > dst->maxNs ? src->maxNs : dst->maxNs;
+            dst->flops += src->flops;
+            dst->bytes += src->bytes;
+            for (b = 0; b < METRIC_BUCKETS; b++)
+                dst->hist[b] += src->hist[b];
+        }
+    }
+    pthread_mutex_unlock(&tablesLock);
+    fprintf(out, "{\"dropped\":%lld,\"classes\":[", merged->dropped);
+    for (i = 0; i < METRIC_SLOTS; i++)
+    {
+        dst = &merged->slot[i];
+        if (!dst->bUsed || dst->count == 0)
+            continue;
+        fprintf(out, "%s\n  {\"backend\":\"%s\","
+                "\"m_max\":%d,\"n_max\":%d,\"k_max\":%d,"
+                "\"calls\":%lld,\"total_ns\":%lld,\"min_ns\":%lld,"
+                "\"max_ns\":%lld,\"p50_ns\":%.0f,\"p90_ns\":%.0f,"
+                "\"p99_ns\":%.0f,\"gflops\":%.3f,\"bytes\":%.0f,"
+                "\"gbytes_per_s\":%.3f}",
+                bFirst ? "" : ",", backendNames[dst->backend],
+                1 << dst->mClass, 1 << dst->nClass, 1 << dst->kClass,
+                dst->count, dst->totalNs, dst->minNs, dst->maxNs,
+                percentile(dst, 0.50), percentile(dst, 0.90),
+                percentile(dst, 0.99),
+                dst->totalNs ? dst->flops / dst->totalNs : 0.0, dst->bytes,
+                dst->totalNs ? dst->bytes / dst->totalNs : 0.0);
+        bFirst = FALSE;
+    }
+    fprintf(out, "\n]}\n");
+    free(merged);
+}
@@ -0,0 +1,386 @@
+#include "define.h"
+
+/***********************************************************************
+ * modular.c written by DSU_410 team ...
+ *
+ * Description: Exact integer products. multiply works in int and
+ * silently wraps once rows * max|A| * max|B| passes 2^31.
+ * - modMultiply computes C = (C + A*B) mod p for any p < 2^31. Products
+ *   are summed in 64 bits and reduced only once per block of the shared
+ *   dimension, as many terms as fit 64 bits (lazy reduction), with a
+ *   Barrett reduction instead of a division.
+ * - modMultiplyExact computes A*B exactly as 128 bit integers. It
+ *   multiplies modulo up to MOD_NUM_PRIMES primes of 28 bits and
+ *   rebuilds each result from its residues by the Chinese remainder
+ *   theorem, in Garner's mixed radix form. A and B are read once for
+ *   all the primes: one pass over each reduces it by every prime, and
+ *   one tiled product fills every prime's accumulators.
+ * With 28 bit primes a 64 bit sum holds 256 products, so the reduction
+ * costs little next to the multiply-adds. Four such primes multiply to
+ * about 2^112, past twice the largest product of int matrices
+ * (2^31 * 2^31 * 2^31 = 2^93), so the exact product never fails.
+ *
+ * Functions:
+ * - modMultiply
+ * - modMultiplyExact
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// Primes just below 2^28 used by modMultiplyExact
+static const int modPrimes[MOD_NUM_PRIMES] = {
+    268435399, 268435367, 268435361, 268435337
+};
+
+// Barrett reduction modulo p: x mod p = x - floor(x * m / 2^64) * p,
+// corrected by at most two subtractions
+typedef struct
+{
+    uint64_t p;
+    uint64_t m;     // floor((2^64 - 1) / p)
+    uint64_t shift; // multiple of p >= 2^31, makes any int non-negative
+} Barrett;
+
+/*****************************   barrettInit   **************************
+ * static void barrettInit(Barrett *br, uint64_t p)
+ *
+ * Description: Precomputes the Barrett constant for modulus p.
+ ***********************************************************************/
+static void barrettInit(Barrett *br, uint64_t p)
+{
+    br->p = p;
+    br->m = UINT64_MAX / p;
+    br->shift = ((1ULL << 31) + p - 1) / p * p;
+}
+
+/****************************   barrettReduce   *************************
+ * static uint64_t barrettReduce(Barrett *br, uint64_t x)
+ *
+ * Description: Returns x mod br->p.
+ ***********************************************************************/
+static inline uint64_t barrettReduce(Barrett *br, uint64_t x)
+{
+    uint64_t q = (uint64_t) (((unsigned __int128) x * br->m) >> 64);
+    uint64_t r = x - q * br->p;
+    while (r >= br->p)
+        r -= br->p;
+    return r;
+}
+
+/******************************   powMod   ******************************
+ * static uint64_t powMod(uint64_t x, uint64_t e, uint64_t p)
+ *
+ * Description: Returns x^e mod p, p < 2^32. With e = p - 2 and p prime
+ * this is the inverse of x.
+ ***********************************************************************/
+static uint64_t powMod(uint64_t x, uint64_t e, uint64_t p)
+{
+    uint64_t r = 1;
+    x %= p;
+    for (; e > 0; e >>= 1)
+    {
+        if (e & 1)
+            r = r * x % p;
+        x = x * x % p;
+    }
+    return r;
+}
+
+/******************************   residue   *****************************
+ * static int residue(Barrett *br, int x)
+ *
+ * Description: Returns x mod br->p in [0..p), for any int x, without a
+ * division.
+ ***********************************************************************/
+static inline int residue(Barrett *br, int x)
+{
+    return (int) barrettReduce(br, (uint64_t) ((long long) x + br->shift));
+}
+
+/****************************   copyResidues   **************************
+ * static void copyResidues(Matrix *dst, Matrix *src, Barrett *br,
+ *                          int numMods)
+ *
+ * Description: Allocates dst[q] as src with every value reduced into
+ * [0..br[q].p), for every modulus in one pass over src.
+ ***********************************************************************/
+static void copyResidues(Matrix *dst, Matrix *src, Barrett *br,
+                         int numMods)
+{
+    int i;
+    int j;
+    int q;
+    for (q = 0; q < numMods; q++)
+        setUp2D(&dst[q], src->rows, src->cols, FALSE);
+    #pragma omp parallel for private(j, q)
+    for (i = 0; i < src->rows; i++)
+        for (j = 0; j < src->cols; j++)
+            for (q = 0; q < numMods; q++)
+                dst[q].m[i][j] = residue(&br[q], src->m[i][j]);
+}
+
+/*************************   multiplyResidues   *************************
+ * static void multiplyResidues(Matrix *a, Matrix *b, Matrix *c,
+ *                              const int *p, int numMods)
+ *
+ * Description: c[q] = (c[q] + a*b) mod p[q] for every modulus at once,
+ * with each c[q] already in [0..p[q]).
+ *
+ * Process:
+ * 1.) Reduce A and B by every modulus, one pass over each.
+ * 2.) Find how many products of values below p fit a 64 bit sum on top
+ *     of a value below p, for the largest p, capped at the tuned blockK.
+ * 3.) Share the tiles of C amongst threads. Each thread keeps a 64 bit
+ *     accumulator per modulus for its tile, starting from C, and runs
+ *     all of them in the one pass over the tiles.
+ * 4.) After every block of that many k, reduce the accumulators with
+ *     Barrett so they are below their p again.
+ *
+ * NOTES:
+ * - Works on reduced copies of a and b, numMods of each.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+static void multiplyResidues(Matrix *a, Matrix *b, Matrix *c,
+                             const int *p, int numMods)
+{
+    Matrix ra[MOD_NUM_PRIMES];
+    Matrix rb[MOD_NUM_PRIMES];
+    TuneParams tp;
+    Barrett br[MOD_NUM_PRIMES];
+    uint64_t maxProduct;
+    int maxP = 0;
+    int blockK;
+    int numTiles;
+    int tilesN;
+    int t;
+    int q;
+    for (q = 0; q < numMods; q++)
+    {
+        barrettInit(&br[q], p[q]);
+        maxP = p[q] > maxP ? p[q] : maxP;
+    }
+    copyResidues(ra, a, br, numMods);
+    copyResidues(rb, b, br, numMods);
+    maxProduct = (uint64_t) (maxP - 1) * (maxP - 1);
+    getTuneParams(c->rows, c->cols, a->cols, &tp);
+    blockK = tp.blockK;
+    if (maxProduct > 0 &&
+        (UINT64_MAX - maxP) / maxProduct < (uint64_t) blockK)
+        blockK = (int) ((UINT64_MAX - maxP) / maxProduct);
+    tilesN = (c->cols + tp.blockN - 1) / tp.blockN;
+    numTiles = ((c->rows + tp.blockM - 1) / tp.blockM) * tilesN;
+    #pragma omp parallel private(q) \
+        num_threads(tp.numThreads > 0 ? tp.numThreads : MAX_THREADS())
+    {
+        size_t tileInts = (size_t) tp.blockM * tp.blockN;
+        uint64_t *acc = malloc(sizeof(uint64_t) * numMods * tileInts);
+        uint64_t *accRow;
+        uint64_t aik;
+        int **bRows;
+        int *aRow;
+        int *bRow;
+        int numRows;
+        int numCols;
+        int row0;
+        int col0;
+        int kk;
+        int kEnd;
+        int i;
+        int j;
+        int k;
+        if (acc == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
+        #pragma omp for schedule(static)
+        for (t = 0; t < numTiles; t++)
+        {
+            row0 = t / tilesN * tp.blockM;
+            col0 = t % tilesN * tp.blockN;
+            numRows = c->rows - row0 < tp.blockM ? c->rows - row0 : tp.blockM;
+            numCols = c->cols - col0 < tp.blockN ? c->cols - col0 : tp.blockN;
+            for (q = 0; q < numMods; q++)
+                for (i = 0; i < numRows; i++)
+                    for (j = 0; j < numCols; j++)
+                        acc[q * tileInts + i * numCols + j] =
+                            c[q].m[row0 + i][col0 + j];
+            for (kk = 0; kk < a->cols; kk += blockK)
+            {
+                kEnd = kk + blockK < a->cols ? kk + blockK : a->cols;
+                for (i = 0; i < numRows; i++)
+                    for (q = 0; q < numMods; q++)
+                    {
+                        accRow = acc + q * tileInts + i * numCols;
+                        aRow = ra[q].m[row0 + i];
+                        bRows = rb[q].m;
+                        for (k = kk; k < kEnd; k++)
+                        {
+                            aik = (uint64_t) aRow[k];
+                            bRow = bRows[k] + col0;
+                            for (j = 0; j < numCols; j++)
+                                accRow[j] += aik * (uint64_t) bRow[j];
+                        }
+                        for (j = 0; j < numCols; j++)
+                            accRow[j] = barrettReduce(&br[q], accRow[j]);
+                    }
+            }
+            for (q = 0; q < numMods; q++)
+                for (i = 0; i < numRows; i++)
+                    for (j = 0; j < numCols; j++)
+                        c[q].m[row0 + i][col0 + j] =
+                            (int) acc[q * tileInts + i * numCols + j];
+        }
+        free(acc);
+    }
+    for (q = 0; q < numMods; q++)
+    {
+        free2D(&ra[q]);
+        free2D(&rb[q]);
+    }
+}
+
+/*****************************   modMultiply   **************************
+ * int modMultiply(Matrix *a, Matrix *b, Matrix *c, int modulus)
+ *
+ * Description: Computes c = (c + a*b) mod modulus exactly, whatever the
+ * size of the intermediate sums.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to Matrix structure, any int values.
+ * b             in          ptr to Matrix structure, any int values.
+ * c             in/out      ptr to Matrix, a->rows by b->cols. Ends up
+ *                           in [0..modulus).
+ * modulus       in          p >= 2, need not be prime.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match or modulus < 2.
+ *
+ * NOTES:
+ * - Works on reduced copies of a and b, so it needs their memory again.
+ * - With metrics on, the call is recorded under BACKEND_MODULAR.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int modMultiply(Matrix *a, Matrix *b, Matrix *c, int modulus)
+{
+    Barrett br;
+    long long start;
+    int i;
+    int j;
+    if (!isDefined(a, b) || c->rows != a->rows || c->cols != b->cols ||
+        modulus < 2)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    barrettInit(&br, modulus);
+    #pragma omp parallel for private(j)
+    for (i = 0; i < c->rows; i++)
+        for (j = 0; j < c->cols; j++)
+            c->m[i][j] = residue(&br, c->m[i][j]);
+    multiplyResidues(a, b, c, &modulus, 1);
+    if (start >= 0)
+        metricsRecord(BACKEND_MODULAR, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
+
+/***************************   modMultiplyExact   ***********************
+ * int modMultiplyExact(Matrix *a, Matrix *b, __int128 *c)
+ *
+ * Description: Computes the exact product a*b into 128 bit integers.
+ *
+ * Process:
+ * 1.) Bound the results by a->cols * max|a| * max|b| and choose enough
+ *     primes that their product exceeds twice the bound. All
+ *     MOD_NUM_PRIMES always do.
+ * 2.) Multiply modulo all the chosen primes in one tiled pass.
+ * 3.) Rebuild every element from its residues by Garner's algorithm,
+ *     mapping the upper half of the range to negative values.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to Matrix structure.
+ * b             in          ptr to Matrix structure.
+ * c             out         a->rows * b->cols __int128s, row major.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Exact product stored.
+ * FALSE         Shapes do not match.
+ *
+ * NOTES:
+ * - With metrics on, the call is recorded under BACKEND_MODULAR.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int modMultiplyExact(Matrix *a, Matrix *b, __int128 *c)
+{
+    Matrix res[MOD_NUM_PRIMES];
+    uint64_t inverse[MOD_NUM_PRIMES][MOD_NUM_PRIMES];
+    unsigned __int128 range = 1;
+    unsigned __int128 bound;
+    long long start;
+    long long maxA = 0;
+    long long maxB = 0;
+    int numPrimes = 0;
+    int i;
+    int j;
+    int q;
+    int r;
+    if (!isDefined(a, b))
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    #pragma omp parallel for private(j) reduction(max:maxA)
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < a->cols; j++)
+            maxA = llabs(a->m[i][j]) > maxA ? llabs(a->m[i][j]) : maxA;
+    #pragma omp parallel for private(j) reduction(max:maxB)
+    for (i = 0; i < b->rows; i++)
+        for (j = 0; j < b->cols; j++)
+            maxB = llabs(b->m[i][j]) > maxB ? llabs(b->m[i][j]) : maxB;
+    // below 2^93, while the primes multiply to about 2^112
+    bound = (unsigned __int128) a->cols * maxA * maxB;
+    while (numPrimes == 0 || range <= bound * 2)
+        range *= modPrimes[numPrimes++];
+    // inverse[q][r] = (p_q)^-1 mod p_r, for Garner's steps
+    for (q = 0; q < numPrimes; q++)
+        for (r = q + 1; r < numPrimes; r++)
+            inverse[q][r] = powMod(modPrimes[q], modPrimes[r] - 2,
+                                   modPrimes[r]);
+    for (q = 0; q < numPrimes; q++)
+        setUp2D(&res[q], a->rows, b->cols, FALSE);
+    multiplyResidues(a, b, res, modPrimes, numPrimes);
+    #pragma omp parallel for private(j, q, r)
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < b->cols; j++)
+        {
+            uint64_t digit[MOD_NUM_PRIMES];
+            unsigned __int128 x = 0;
+            unsigned __int128 radix = 1;
+            uint64_t v;
+            // x = digit[0] + digit[1] p_0 + digit[2] p_0 p_1 + ...
+            for (r = 0; r < numPrimes; r++)
+            {
+                v = (uint64_t) res[r].m[i][j];
+                for (q = 0; q < r; q++)
+                    v = (v + modPrimes[r] - digit[q] % modPrimes[r]) %
+                        modPrimes[r] *
+                        inverse[q][r] % modPrimes[r];
+                digit[r] = v;
+                x += radix * v;
+                radix *= modPrimes[r];
+            }
+            c[(size_t) i * b->cols + j] = x > range / 2
+                ? -(__int128) (range - x) : (__int128) x;
+        }
+    for (q = 0; q < numPrimes; q++)
+        free2D(&res[q]);
+    if (start >= 0)
+        metricsRecord(BACKEND_MODULAR, a->rows, b->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
@@ -0,0 +1,333 @@
+#include "define.h"
+#include <string.h>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+/***********************************************************************
+ * morton.c written by DSU_410 team ...
+ *
+ * Description: Matrices stored tile by tile in Morton (Z curve) order.
+ * The matrix is cut into MORTON_TILE x MORTON_TILE tiles, each stored
+ * row major and contiguous, and tile (ti, tj) is placed at position
+ * mortonEncode(ti, tj), the bits of ti and tj interleaved. Every
+ * aligned square of 2^L x 2^L tiles is then one contiguous run of
+ * memory, at every L, so a recursive algorithm that halves the matrix
+ * works on contiguous blocks whatever the cache and TLB sizes are. Only
+ * the leaf tile is fixed, small enough that three tiles fit any L1.
+ *
+ * Index conversion uses BMI2 pdep / pext when the compiler targets it,
+ * e.g. with -march=native, and shift-and-mask bit spreading otherwise.
+ *
+ * Storage runs up to the last tile's Morton position, and the holes
+ * for tiles past the end of the matrix are kept zero. A square matrix
+ * pads at most its last row and column of tiles, but a thin one pads
+ * towards a square of its longer side, so the layout suits roughly
+ * square matrices.
+ *
+ * Functions:
+ * - mortonEncode
+ * - mortonDecode
+ * - mortonInit
+ * - mortonFromMatrix
+ * - mortonToMatrix
+ * - mortonFree
+ * - mortonMultiply
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+#define MORTON_ROW_BITS     0xAAAAAAAAu
+#define MORTON_COL_BITS     0x55555555u
+
+#if !defined(__BMI2__)
+/*******************************   spread   *****************************
+ * static unsigned spread(unsigned x)
+ *
+ * Description: Moves bit b of the low 16 bits of x to bit 2b.
+ ***********************************************************************/
+static unsigned spread(unsigned x)
+{
+    x &= 0xFFFF;
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+/******************************   compact   *****************************
+ * static unsigned compact(unsigned x)
+ *
+ * Description: Inverse of spread, moves bit 2b of x to bit b.
+ ***********************************************************************/
+static unsigned compact(unsigned x)
+{
+    x &= 0x55555555;
+    x = (x | (x >> 1)) & 0x33333333;
+    x = (x | (x >> 2)) & 0x0F0F0F0F;
+    x = (x | (x >> 4)) & 0x00FF00FF;
+    x = (x | (x >> 8)) & 0x0000FFFF;
+    return x;
+}
+#endif
+
+/****************************   mortonEncode   **************************
+ * unsigned mortonEncode(unsigned i, unsigned j)
+ *
+ * Description: Returns the Z curve position of (i, j), the bits of i in
+ * the odd positions and those of j in the even ones. i and j must be
+ * below 65536.
+ ***********************************************************************/
+unsigned mortonEncode(unsigned i, unsigned j)
+{
+#if defined(__BMI2__)
+    return _pdep_u32(i, MORTON_ROW_BITS) | _pdep_u32(j, MORTON_COL_BITS);
+#else
+    return (spread(i) << 1) | spread(j);
+#endif
+}
+
+/****************************   mortonDecode   **************************
+ * void mortonDecode(unsigned z, unsigned *i, unsigned *j)
+ *
+ * Description: Inverse of mortonEncode.
+ ***********************************************************************/
+void mortonDecode(unsigned z, unsigned *i, unsigned *j)
+{
+#if defined(__BMI2__)
+    *i = _pext_u32(z, MORTON_ROW_BITS);
+    *j = _pext_u32(z, MORTON_COL_BITS);
+#else
+    *i = compact(z >> 1);
+    *j = compact(z);
+#endif
+}
+
+/*****************************   mortonInit   ***************************
+ * void mortonInit(MortonMatrix *a, int numRows, int numCols)
+ *
+ * Description: Allocates an all zero Morton order matrix.
+ *
+ * Process:
+ * 1.) Count the tiles up to the last one's Morton position.
+ * 2.) Zero them in parallel, so each thread first touches the tiles it
+ *     converts later.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void mortonInit(MortonMatrix *a, int numRows, int numCols)
+{
+    long long z;
+    a->rows = numRows;
+    a->cols = numCols;
+    a->tilesR = (numRows + MORTON_TILE - 1) / MORTON_TILE;
+    a->tilesC = (numCols + MORTON_TILE - 1) / MORTON_TILE;
+    a->numTiles = 0;
+    if (a->tilesR > 0 && a->tilesC > 0)
+        a->numTiles = (size_t) mortonEncode(a->tilesR - 1, a->tilesC - 1)
+                      + 1;
+    // An empty matrix has no tiles, allocScratch allows the 0 bytes
+    a->data = allocScratch(sizeof(int) * MORTON_TILE * MORTON_TILE *
+                           a->numTiles);
+    #pragma omp parallel for schedule(static)
+    for (z = 0; z < (long long) a->numTiles; z++)
+        memset(MORTON_TILE_AT(a, z), 0,
+               sizeof(int) * MORTON_TILE * MORTON_TILE);
+}
+
+/**************************   mortonFromMatrix   ************************
+ * void mortonFromMatrix(MortonMatrix *a, Matrix *src)
+ *
+ * Description: Allocates a Morton order copy of src.
+ *
+ * Process:
+ * 1.) Share the Morton positions amongst threads.
+ * 2.) Decode each to its tile and copy the tile's rows in.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void mortonFromMatrix(MortonMatrix *a, Matrix *src)
+{
+    long long z;
+    mortonInit(a, src->rows, src->cols);
+    #pragma omp parallel for schedule(static)
+    for (z = 0; z < (long long) a->numTiles; z++)
+    {
+        int *tile = MORTON_TILE_AT(a, z);
+        unsigned ti;
+        unsigned tj;
+        int numRows;
+        int numCols;
+        int i;
+        mortonDecode((unsigned) z, &ti, &tj);
+        if ((int) ti >= a->tilesR || (int) tj >= a->tilesC)
+            continue;
+        numRows = src->rows - (int) ti * MORTON_TILE;
+        numCols = src->cols - (int) tj * MORTON_TILE;
+        if (numRows > MORTON_TILE)
+            numRows = MORTON_TILE;
+        if (numCols > MORTON_TILE)
+            numCols = MORTON_TILE;
+        for (i = 0; i < numRows; i++)
+            memcpy(tile + i * MORTON_TILE,
+                   src->m[ti * MORTON_TILE + i] + tj * MORTON_TILE,
+                   sizeof(int) * numCols);
+    }
+}
+
+/***************************   mortonToMatrix   ************************
+ * void mortonToMatrix(MortonMatrix *a, Matrix *dst)
+ *
+ * Description: Writes a Morton order matrix into an allocated Matrix of
+ * the same shape, tile by tile in parallel.
+ ***********************************************************************/
+void mortonToMatrix(MortonMatrix *a, Matrix *dst)
+{
+    long long z;
+    #pragma omp parallel for schedule(static)
+    for (z = 0; z < (long long) a->numTiles; z++)
+    {
+        int *tile = MORTON_TILE_AT(a, z);
+        unsigned ti;
+        unsigned tj;
+        int numRows;
+        int numCols;
+        int i;
+        mortonDecode((unsigned) z, &ti, &tj);
+        if ((int) ti >= a->tilesR || (int) tj >= a->tilesC)
+            continue;
+        numRows = a->rows - (int) ti * MORTON_TILE;
+        numCols = a->cols - (int) tj * MORTON_TILE;
+        if (numRows > MORTON_TILE)
+            numRows = MORTON_TILE;
+        if (numCols > MORTON_TILE)
+            numCols = MORTON_TILE;
+        for (i = 0; i < numRows; i++)
+            memcpy(dst->m[ti * MORTON_TILE + i] + tj * MORTON_TILE,
+                   tile + i * MORTON_TILE, sizeof(int) * numCols);
+    }
+}
+
+/*****************************   mortonFree   ***************************
+ * void mortonFree(MortonMatrix *a)
+ *
+ * Description: Frees a Morton order matrix's storage.
+ ***********************************************************************/
+void mortonFree(MortonMatrix *a)
+{
+    freeScratch(a->data);
+}
+
+/*****************************   tileKernel   ***************************
+ * static void tileKernel(const int *a, const int *b, int *c)
+ *
+ * Description: c += a*b for three contiguous MORTON_TILE x MORTON_TILE
+ * row major tiles. A row of c is one run of vectors, kept in registers
+ * over the k loop.
+ ***********************************************************************/
+static void tileKernel(const int *a, const int *b, int *c)
+{
+    int i;
+    int j;
+    int k;
+    for (i = 0; i < MORTON_TILE; i++)
+        for (k = 0; k < MORTON_TILE; k++)
+        {
+            #pragma omp simd
+            for (j = 0; j < MORTON_TILE; j++)
+                c[i * MORTON_TILE + j] += a[i * MORTON_TILE + k] *
+                                          b[k * MORTON_TILE + j];
+        }
+}
+
+/*****************************   recurse   ******************************
+ * static void recurse(MortonMatrix *a, MortonMatrix *b, MortonMatrix *c,
+ *                     int ti, int tj, int tk, int side)
+ *
+ * Description: C(ti.., tj..) += A(ti.., tk..) * B(tk.., tj..) over
+ * side x side tiles, side a power of two.
+ *
+ * Process:
+ * 1.) Stop if the block lies past the end of C or of the shared
+ *     dimension, where the tiles are all padding.
+ * 2.) One tile: run the kernel.
+ * 3.) Otherwise split into quadrants. The four quadrants of C are
+ *     independent tasks while the blocks are at least
+ *     MORTON_TASK_TILES on a side; each does its two k halves in turn.
+ ***********************************************************************/
+static void recurse(MortonMatrix *a, MortonMatrix *b, MortonMatrix *c,
+                    int ti, int tj, int tk, int side)
+{
+    int half = side / 2;
+    int q;
+    if (ti >= c->tilesR || tj >= c->tilesC || tk >= a->tilesC)
+        return;
+    if (side == 1)
+    {
+        tileKernel(MORTON_TILE_AT(a, mortonEncode(ti, tk)),
+                   MORTON_TILE_AT(b, mortonEncode(tk, tj)),
+                   MORTON_TILE_AT(c, mortonEncode(ti, tj)));
+        return;
+    }
+    for (q = 0; q < 4; q++)
+    {
+        #pragma omp task if (side >= MORTON_TASK_TILES) \
+            firstprivate(q) shared(a, b, c)
+        {
+            int i0 = ti + (q >> 1) * half;
+            int j0 = tj + (q & 1) * half;
+            recurse(a, b, c, i0, j0, tk, half);
+            recurse(a, b, c, i0, j0, tk + half, half);
+        }
+    }
+    #pragma omp taskwait
+}
+
+/***************************   mortonMultiply   *************************
+ * int mortonMultiply(MortonMatrix *a, MortonMatrix *b, MortonMatrix *c)
+ *
+ * Description: C += A*B with all three in Morton order. The divide and
+ * conquer product keeps each subproblem in contiguous memory, so it is
+ * blocked for every cache level at once without tuned block sizes.
+ *
+ * Process:
+ * 1.) Cover the largest tile count of the three dimensions with a power
+ *     of two square.
+ * 2.) One thread starts the recursion; the tasks spread it over the
+ *     team.
+ * 3.) With metrics on, the call is recorded under BACKEND_MORTON.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to MortonMatrix structure, see define.h.
+ * b             in          ptr to MortonMatrix, a->cols rows.
+ * c             in/out      ptr to MortonMatrix, a->rows by b->cols.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match.
+ ***********************************************************************/
+int mortonMultiply(MortonMatrix *a, MortonMatrix *b, MortonMatrix *c)
+{
+    long long start;
+    int side = 1;
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    while (side < c->tilesR || side < c->tilesC || side < a->tilesC)
+        side *= 2;
+    #pragma omp parallel
+    #pragma omp single
+    recurse(a, b, c, 0, 0, 0, side);
+    if (start >= 0)
+        metricsRecord(BACKEND_MORTON, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
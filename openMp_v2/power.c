@@ -0,0 +1,163 @@
+#include "define.h"
+#include <limits.h>
+
+/***********************************************************************
+ * power.c written by DSU_410 team ...
+ *
+ * Description: Integer powers A^k of square matrices by repeated
+ * squaring, e.g. path counting on adjacency matrices. Needs O(log k)
+ * products and only one temporary Matrix besides the result, the two
+ * are used as ping-pong buffers. Reducing modulo p may add a third,
+ * the reduced copy of A.
+ *
+ * Functions:
+ * - matrixPower
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/*****************************   copyReduce   ***************************
+ * static void copyReduce(Matrix *dst, Matrix *src, int modulus)
+ *
+ * Description: Copies src into dst, reducing every value into
+ * [0..modulus) when modulus is positive.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * dst           out         ptr to Matrix, same shape as src.
+ * src           in          ptr to Matrix being copied.
+ * modulus       in          0 for a plain copy.
+ ***********************************************************************/
+static void copyReduce(Matrix *dst, Matrix *src, int modulus)
+{
+    int i;
+    int j;
+    #pragma omp parallel for private(j)
+    for (i = 0; i < src->rows; i++)
+        for (j = 0; j < src->cols; j++)
+        {
+            dst->m[i][j] = src->m[i][j];
+            if (modulus > 0)
+            {
+                dst->m[i][j] %= modulus;
+                if (dst->m[i][j] < 0)
+                    dst->m[i][j] += modulus;
+            }
+        }
+}
+
+/*****************************   matrixPower   **************************
+ * int matrixPower(Matrix *a, int k, Matrix *c, int modulus)
+ *
+ * Description: Computes c = a^k, optionally with every entry reduced
+ * modulo modulus so integer values do not overflow.
+ *
+ * Process:
+ * 1.) Walk the bits of k from the highest down (left to right binary
+ *     exponentiation): square for every bit, and multiply by a for
+ *     every set bit after the first.
+ * 2.) Products alternate between c and one temporary, starting in
+ *     whichever buffer makes the last product land in c.
+ * 3.) The modulus, if any, is applied by an EPI_MOD epilogue inside
+ *     the multiply kernel, and a is reduced once up front.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to square Matrix.
+ * k             in          Exponent, k >= 0. a^0 is the identity.
+ * c             out         ptr to Matrix, same shape as a. Overwritten.
+ * modulus       in          0 for exact int arithmetic, else p > 1.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Power was computed.
+ * FALSE         Shapes wrong, c is a, k < 0, or rows * (p - 1)^2 does
+ *               not fit an int, so the reduced products could still
+ *               overflow.
+ *
+ * NOTES:
+ * - c must not share storage with a: the products by a read it after c
+ *   has been overwritten.
+ * - Without a modulus, results overflow silently like multiply does.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int matrixPower(Matrix *a, int k, Matrix *c, int modulus)
+{
+    Matrix temp;
+    Matrix base;
+    Matrix *buf[2];
+    MatrixView va;
+    MatrixView vSrc;
+    MatrixView vDst;
+    Epilogue epi;
+    int numProducts;
+    int top;
+    int cur;
+    int bit;
+    int i;
+    if (a->rows != a->cols || c->rows != a->rows || c->cols != a->cols ||
+        c == a || c->m == a->m || k < 0 || modulus < 0 || modulus == 1)
+        return FALSE;
+    if (modulus > 0 && (long long) a->rows * (modulus - 1) * (modulus - 1)
+                       > INT_MAX)
+        return FALSE;
+    if (k == 0)
+    {
+        fillZeroes2D(c);
+        for (i = 0; i < c->rows; i++)
+            c->m[i][i] = modulus == 0 ? 1 : 1 % modulus;
+        return TRUE;
+    }
+    epilogueInit(&epi);
+    if (modulus > 0)
+        epilogueAdd(&epi, EPI_MOD, modulus, 0, NULL);
+    // Squares for every bit below the top one, one more product for
+    // every further set bit
+    top = 0;
+    numProducts = 0;
+    for (bit = 30; bit >= 0; bit--)
+        if (k & (1 << bit))
+        {
+            if (top == 0)
+                top = bit;
+            else
+                numProducts++;
+        }
+    numProducts += top;
+    setUp2D(&temp, a->rows, a->cols, FALSE);
+    buf[0] = c;
+    buf[1] = &temp;
+    cur = numProducts % 2;
+    copyReduce(buf[cur], a, modulus);
+    makeView(&va, a, FALSE);
+    if (modulus > 0 && numProducts > top)
+    {
+        // Set bits multiply by a, which must be reduced too
+        setUp2D(&base, a->rows, a->cols, FALSE);
+        copyReduce(&base, a, modulus);
+        makeView(&va, &base, FALSE);
+    }
+    for (bit = top - 1; bit >= 0; bit--)
+    {
+        makeView(&vSrc, buf[cur], FALSE);
+        makeView(&vDst, buf[!cur], FALSE);
+        fillZeroes2D(buf[!cur]);
+        multiplyEpilogue(&vSrc, &vSrc, &vDst, &epi);
+        cur = !cur;
+        if (k & (1 << bit))
+        {
+            makeView(&vSrc, buf[cur], FALSE);
+            makeView(&vDst, buf[!cur], FALSE);
+            fillZeroes2D(buf[!cur]);
+            multiplyEpilogue(&vSrc, &va, &vDst, &epi);
+            cur = !cur;
+        }
+    }
+    if (modulus > 0 && numProducts > top)
+        free2D(&base);
+    free2D(&temp);
+    return TRUE;
+}
@@ -0,0 +1,305 @@
+#include "define.h"
+
+/***********************************************************************
+ * semiring.c written by DSU_410 team ...
+ *
+ * Description: Matrix products over other semirings, where + and * are
+ * replaced by an add and a mul operation, e.g.
+ * - (min, +), the tropical semiring, shortest paths.
+ * - (max, +), longest / critical paths.
+ * - (max, min), bottleneck (widest) paths.
+ * The product is tiled and shared out like multiplyEpilogue, with the
+ * tuned block sizes from tune.c.
+ *
+ * The tile kernel is one macro, SEMIRING_KERNEL, instantiated with the
+ * operations inlined for the known semirings so the inner loop
+ * vectorises (vpminsd, vpaddd, ...). Any other semiring goes through
+ * the add / mul function pointers, which works but does not vectorise.
+ * The macro takes the element type, but Matrix holds ints, so only int
+ * kernels are instantiated.
+ *
+ * Infinite distances are SEMIRING_INF (INT_MAX / 2), so adding two of
+ * them still fits an int. Weights and path lengths must stay within
+ * (-SEMIRING_INF, SEMIRING_INF). The + of (min, +) and (max, +)
+ * saturates at the semiring's zero: a sum with SEMIRING_INF (for
+ * (max, +) -SEMIRING_INF) as either operand is that zero, so a pair
+ * with no path keeps none whatever the weights of the other edges.
+ * The test is a select, which the kernels still vectorise.
+ *
+ * Functions:
+ * - semiringInit
+ * - semiringMultiply
+ * - semiringClosure
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+#define OP_PLUS(x, y)       ((x) + (y))
+#define OP_PLUS_INF(x, y)   ((x) == SEMIRING_INF || (y) == SEMIRING_INF \
+                             ? SEMIRING_INF : (x) + (y))
+#define OP_PLUS_NINF(x, y)  ((x) == -SEMIRING_INF || (y) == -SEMIRING_INF \
+                             ? -SEMIRING_INF : (x) + (y))
+#define OP_TIMES(x, y)      ((x) * (y))
+#define OP_MIN(x, y)        ((x) < (y) ? (x) : (y))
+#define OP_MAX(x, y)        ((x) > (y) ? (x) : (y))
+#define OP_CALL_ADD(x, y)   (sr->add((x), (y)))
+#define OP_CALL_MUL(x, y)   (sr->mul((x), (y)))
+
+/***************************   SEMIRING_KERNEL   ************************
+ * static void name(T **a, T **b, T **c, int row0, int col0, int k0,
+ *                  int numRows, int numCols, int numK, Semiring *sr)
+ *
+ * Description: Defines a tile kernel, c = c ADD (a MUL b) for the
+ * numRows x numCols tile of c at (row0, col0), over the numK values of
+ * the shared dimension from k0. C's tile stays in cache over the k loop.
+ ***********************************************************************/
+#define SEMIRING_KERNEL(name, T, ADD, MUL)                               \
+static void name(T **a, T **b, T **c, int row0, int col0, int k0,       \
+                 int numRows, int numCols, int numK, Semiring *sr)      \
+{                                                                        \
+    T *cRow;                                                             \
+    T *bRow;                                                             \
+    T aik;                                                               \
+    int i;                                                               \
+    int j;                                                               \
+    int k;                                                               \
+    (void) sr;                                                           \
+    for (i = 0; i < numRows; i++)                                        \
+    {                                                                    \
+        cRow = c[row0 + i] + col0;                                       \
+        for (k = k0; k < k0 + numK; k++)                                 \
+        {                                                                \
+            aik = a[row0 + i][k];                                        \
+            bRow = b[k] + col0;                                          \
+            _Pragma("omp simd")                                          \
+            for (j = 0; j < numCols; j++)                                \
+                cRow[j] = ADD(cRow[j], MUL(aik, bRow[j]));               \
+        }                                                                \
+    }                                                                    \
+}
+
+SEMIRING_KERNEL(kernelPlusTimes, int, OP_PLUS, OP_TIMES)
+SEMIRING_KERNEL(kernelMinPlus, int, OP_MIN, OP_PLUS_INF)
+SEMIRING_KERNEL(kernelMaxPlus, int, OP_MAX, OP_PLUS_NINF)
+SEMIRING_KERNEL(kernelMaxMin, int, OP_MAX, OP_MIN)
+SEMIRING_KERNEL(kernelGeneric, int, OP_CALL_ADD, OP_CALL_MUL)
+
+// The operations as functions, for the add and mul fields of Semiring
+static int opPlus(int x, int y) { return OP_PLUS(x, y); }
+static int opPlusInf(int x, int y) { return OP_PLUS_INF(x, y); }
+static int opPlusNinf(int x, int y) { return OP_PLUS_NINF(x, y); }
+static int opTimes(int x, int y) { return OP_TIMES(x, y); }
+static int opMin(int x, int y) { return OP_MIN(x, y); }
+static int opMax(int x, int y) { return OP_MAX(x, y); }
+
+/*****************************   semiringInit   *************************
+ * int semiringInit(Semiring *sr, int kind)
+ *
+ * Description: Fills in one of the built in semirings.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * sr            out         ptr to Semiring structure, see define.h.
+ * kind          in          SEMIRING_PLUS_TIMES, SEMIRING_MIN_PLUS,
+ *                           SEMIRING_MAX_PLUS or SEMIRING_MAX_MIN.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          sr filled in.
+ * FALSE         Unknown kind.
+ *
+ * NOTES:
+ * - For other semirings set kind to SEMIRING_GENERIC and fill in the
+ *   fields by hand.
+ ***********************************************************************/
+int semiringInit(Semiring *sr, int kind)
+{
+    sr->kind = kind;
+    switch (kind)
+    {
+    case SEMIRING_PLUS_TIMES:
+        sr->add = opPlus;
+        sr->mul = opTimes;
+        sr->zero = 0;
+        sr->one = 1;
+        break;
+    case SEMIRING_MIN_PLUS:
+        sr->add = opMin;
+        sr->mul = opPlusInf;
+        sr->zero = SEMIRING_INF;
+        sr->one = 0;
+        break;
+    case SEMIRING_MAX_PLUS:
+        sr->add = opMax;
+        sr->mul = opPlusNinf;
+        sr->zero = -SEMIRING_INF;
+        sr->one = 0;
+        break;
+    case SEMIRING_MAX_MIN:
+        sr->add = opMax;
+        sr->mul = opMin;
+        sr->zero = INT_MIN;
+        sr->one = INT_MAX;
+        break;
+    default:
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/***************************   semiringMultiply   ***********************
+ * int semiringMultiply(Matrix *a, Matrix *b, Matrix *c, Semiring *sr)
+ *
+ * Description: c = c add (a mul b) over semiring sr, the analogue of
+ * multiply's C += A*B.
+ *
+ * Process:
+ * 1.) Look up block sizes, thread count and schedule for the shape.
+ * 2.) Share the tiles of C amongst threads.
+ * 3.) Each tile runs the kernel for sr's kind over every blockK panel.
+ * 4.) With metrics on, the call is recorded under BACKEND_SEMIRING.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to Matrix structure, left operand.
+ * b             in          ptr to Matrix structure, right operand.
+ * c             in/out      ptr to Matrix, a->rows by b->cols. Start it
+ *                           at sr->zero everywhere for the plain product.
+ * sr            in          ptr to Semiring structure, see define.h.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match.
+ *
+ * NOTES:
+ * - c must not overlap a or b.
+ ***********************************************************************/
+int semiringMultiply(Matrix *a, Matrix *b, Matrix *c, Semiring *sr)
+{
+    long long start;
+    TuneParams tp;
+    int numTiles;
+    int tilesN;
+    int row0;
+    int col0;
+    int kk;
+    int t;
+    void (*kernel)(int **, int **, int **, int, int, int, int, int, int,
+                   Semiring *);
+    if (!isDefined(a, b) || c->rows != a->rows || c->cols != b->cols)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    switch (sr->kind)
+    {
+    case SEMIRING_PLUS_TIMES:
+        kernel = kernelPlusTimes;
+        break;
+    case SEMIRING_MIN_PLUS:
+        kernel = kernelMinPlus;
+        break;
+    case SEMIRING_MAX_PLUS:
+        kernel = kernelMaxPlus;
+        break;
+    case SEMIRING_MAX_MIN:
+        kernel = kernelMaxMin;
+        break;
+    default:
+        kernel = kernelGeneric;
+        break;
+    }
+    getTuneParams(c->rows, c->cols, a->cols, &tp);
+    tilesN = (c->cols + tp.blockN - 1) / tp.blockN;
+    numTiles = ((c->rows + tp.blockM - 1) / tp.blockM) * tilesN;
+    #pragma omp parallel for schedule(static) private(row0, col0, kk) \
+        num_threads(tp.numThreads > 0 ? tp.numThreads : MAX_THREADS())
+    for (t = 0; t < numTiles; t++)
+    {
+        row0 = t / tilesN * tp.blockM;
+        col0 = t % tilesN * tp.blockN;
+        for (kk = 0; kk < a->cols; kk += tp.blockK)
+            kernel(a->m, b->m, c->m, row0, col0, kk,
+                   c->rows - row0 < tp.blockM ? c->rows - row0 : tp.blockM,
+                   c->cols - col0 < tp.blockN ? c->cols - col0 : tp.blockN,
+                   a->cols - kk < tp.blockK ? a->cols - kk : tp.blockK, sr);
+    }
+    if (start >= 0)
+        metricsRecord(BACKEND_SEMIRING, c->rows, c->cols, a->cols,
+                      metricsNow() - start);
+    return TRUE;
+}
+
+/***************************   semiringClosure   ************************
+ * int semiringClosure(Matrix *d, Semiring *sr)
+ *
+ * Description: Replaces the edge matrix d by its closure, the best
+ * value over paths of any length, by repeated squaring. With
+ * SEMIRING_MIN_PLUS this is all pairs shortest paths, with
+ * SEMIRING_MAX_MIN all pairs widest paths.
+ *
+ * Process:
+ * 1.) Add sr->one to the diagonal, the empty path from i to i.
+ * 2.) Square: next = d add d mul d covers paths of twice the length.
+ * 3.) Stop after paths of n - 1 edges are covered, or sooner when a
+ *     squaring changes nothing.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * d             in/out      ptr to square Matrix, d(i, j) the weight of
+ *                           edge i -> j, sr->zero where there is none.
+ * sr            in          ptr to Semiring structure, see define.h.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Closure computed.
+ * FALSE         d is not square.
+ *
+ * NOTES:
+ * - O(n^3 log n), but each step is one tiled parallel product.
+ * - With negative cycles under (min, +) the values are meaningless.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int semiringClosure(Matrix *d, Semiring *sr)
+{
+    Matrix temp;
+    Matrix *cur = d;
+    Matrix *next = &temp;
+    Matrix *swap;
+    int bChanged = TRUE;
+    int span;
+    int i;
+    int j;
+    if (d->rows != d->cols)
+        return FALSE;
+    for (i = 0; i < d->rows; i++)
+        d->m[i][i] = sr->add(d->m[i][i], sr->one);
+    setUp2D(&temp, d->rows, d->cols, FALSE);
+    for (span = 1; span < d->rows - 1 && bChanged; span *= 2)
+    {
+        #pragma omp parallel for private(j)
+        for (i = 0; i < d->rows; i++)
+            for (j = 0; j < d->cols; j++)
+                next->m[i][j] = cur->m[i][j];
+        semiringMultiply(cur, cur, next, sr);
+        bChanged = FALSE;
+        #pragma omp parallel for private(j) reduction(|:bChanged)
+        for (i = 0; i < d->rows; i++)
+            for (j = 0; j < d->cols; j++)
+                bChanged |= next->m[i][j] != cur->m[i][j];
+        swap = cur;
+        cur = next;
+        next = swap;
+    }
+    if (cur != d)
+    {
+        #pragma omp parallel for private(j)
+        for (i = 0; i < d->rows; i++)
+            for (j = 0; j < d->cols; j++)
+                d->m[i][j] = cur->m[i][j];
+    }
+    free2D(&temp);
+    return TRUE;
+}
@@ -0,0 +1,370 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "define.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/***********************************************************************
+ * server.c written by DSU_410 team ...
+ *
+ * Description: Long running multiply service on a Unix domain socket.
+ * Processes that would otherwise start their own OpenMP team, and
+ * allocate their own pack buffers, for every multiply send the work
+ * here instead. The daemon's worker thread keeps the team and buffers
+ * warm across requests.
+ *
+ * Operands are never copied. A client puts A, B and C one after another
+ * in a memfd (see client.c) and passes the descriptor along with a
+ * ServeRequest. The worker maps it, multiplies in place and replies with
+ * a status. The client then reads C out of its own mapping.
+ *
+ * Admission control: requests with bad sizes, or a memfd smaller than
+ * the sizes need, are refused with SERVE_ERROR. So are memfds that are
+ * not sealed against shrinking and growing: a client could otherwise
+ * truncate one after the size check, and the worker would take SIGBUS
+ * touching the lost pages. Requests arriving while
+ * SERVE_QUEUE_DEPTH others are waiting are refused with SERVE_BUSY, so
+ * an overloaded daemon sheds load rather than queueing without bound.
+ *
+ * Only the daemon's own user (and root) may use it. The socket file is
+ * made 0600, and the peer's credentials are checked on every
+ * connection, SERVE_SHUTDOWN included.
+ *
+ * Functions:
+ * - serveMatrices
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Accept thread: read a request and its memfd, check it, queue it.
+ * 2.) Worker thread: map, multiply, reply, in arrival order.
+ ************************************************************************/
+
+// A queued request with its connection and operand descriptor
+typedef struct
+{
+    int conn;
+    int memfd;
+    ServeRequest req;
+} ServeJob;
+
+// Bounded queue between the accept thread and the worker
+typedef struct
+{
+    ServeJob jobs[SERVE_QUEUE_DEPTH];
+    int head;
+    int count;
+    int bStop;              // set on shutdown, worker drains then exits
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} ServeQueue;
+
+/*****************************   sendStatus   ***************************
+ * static void sendStatus(int conn, int status)
+ *
+ * Description: Replies to a request and closes the connection. A client
+ * that has gone away is ignored.
+ ***********************************************************************/
+static void sendStatus(int conn, int status)
+{
+    ServeReply reply;
+    reply.status = status;
+    send(conn, &reply, sizeof(reply), MSG_NOSIGNAL);
+    close(conn);
+}
+
+/****************************   recvRequest   ***************************
+ * static int recvRequest(int conn, ServeRequest *req, int *memfd)
+ *
+ * Description: Reads a request and the descriptor passed with it.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          req filled. memfd is -1 if none was passed.
+ * FALSE         Short read, timeout or closed connection.
+ ***********************************************************************/
+static int recvRequest(int conn, ServeRequest *req, int *memfd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cm;
+    char control[CMSG_SPACE(sizeof(int))];
+    ssize_t n;
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = req;
+    iov.iov_len = sizeof(*req);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    *memfd = -1;
+    n = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+    for (cm = CMSG_FIRSTHDR(&msg); n >= 0 && cm != NULL;
+         cm = CMSG_NXTHDR(&msg, cm))
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+            memcpy(memfd, CMSG_DATA(cm), sizeof(int));
+    return n == sizeof(*req);
+}
+
+/****************************   checkRequest   **************************
+ * static int checkRequest(ServeRequest *req, int memfd)
+ *
+ * Description: Admission check, done before a request is queued.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Sizes are sane and fit in the memfd, whose size is
+ *               sealed.
+ * FALSE         Refuse with SERVE_ERROR.
+ ***********************************************************************/
+static int checkRequest(ServeRequest *req, int memfd)
+{
+    struct stat st;
+    size_t bytes;
+    int seals;
+    if (req->n <= 0 || req->p <= 0 || req->m <= 0 ||
+        req->n > SERVE_MAX_DIM || req->p > SERVE_MAX_DIM ||
+        req->m > SERVE_MAX_DIM || memfd < 0 || fstat(memfd, &st) != 0)
+        return FALSE;
+    // Unsealed, the size checked here could change before runJob
+    seals = fcntl(memfd, F_GET_SEALS);
+    if (seals < 0 || (seals & (F_SEAL_SHRINK | F_SEAL_GROW)) !=
+                     (F_SEAL_SHRINK | F_SEAL_GROW))
+        return FALSE;
+    bytes = servedBytes(req->n, req->p, req->m);
+    return bytes <= SERVE_MAX_BYTES && (size_t) st.st_size >= bytes;
+}
+
+/*****************************   mapMatrix   ****************************
+ * static void mapMatrix(Matrix *a, int *data, int numRows, int numCols)
+ *
+ * Description: Makes a Matrix over row major data already in memory.
+ * Only the row pointers are allocated.
+ ***********************************************************************/
+static void mapMatrix(Matrix *a, int *data, int numRows, int numCols)
+{
+    int i;
+    a->rows = numRows;
+    a->cols = numCols;
+    a->m = malloc(sizeof(int *) * numRows);
+    if (a->m == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    for (i = 0; i < numRows; i++)
+        a->m[i] = data + (size_t) i * numCols;
+}
+
+/****************************   runJob   ********************************
+ * static int runJob(ServeJob *job)
+ *
+ * Description: Maps the job's memfd, multiplies in place and unmaps.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * SERVE_OK      C now holds C + A*B.
+ * SERVE_ERROR   The memfd could not be mapped.
+ ***********************************************************************/
+static int runJob(ServeJob *job)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    size_t bytes = servedBytes(job->req.n, job->req.p, job->req.m);
+    int *base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     job->memfd, 0);
+    if (base == MAP_FAILED)
+        return SERVE_ERROR;
+    mapMatrix(&a, base, job->req.n, job->req.p);
+    mapMatrix(&b, base + (size_t) job->req.n * job->req.p, job->req.p,
+              job->req.m);
+    mapMatrix(&c, base + (size_t) job->req.n * job->req.p +
+              (size_t) job->req.p * job->req.m, job->req.n, job->req.m);
+    multiply(&a, &b, &c);
+    free(a.m);
+    free(b.m);
+    free(c.m);
+    munmap(base, bytes);
+    return SERVE_OK;
+}
+
+/****************************   workerThread   **************************
+ * static void *workerThread(void *arg)
+ *
+ * Description: Runs queued jobs one at a time, each with the whole
+ * OpenMP team, until the queue is stopped and empty.
+ ***********************************************************************/
+static void *workerThread(void *arg)
+{
+    ServeQueue *q = arg;
+    ServeJob job;
+    for (;;)
+    {
+        pthread_mutex_lock(&q->lock);
+        while (q->count == 0 && !q->bStop)
+            pthread_cond_wait(&q->cond, &q->lock);
+        if (q->count == 0)
+        {
+            pthread_mutex_unlock(&q->lock);
+            return NULL;
+        }
+        job = q->jobs[q->head];
+        q->head = (q->head + 1) % SERVE_QUEUE_DEPTH;
+        q->count--;
+        pthread_mutex_unlock(&q->lock);
+        sendStatus(job.conn, runJob(&job));
+        close(job.memfd);
+    }
+}
+
+/****************************   isTrustedPeer   *************************
+ * static int isTrustedPeer(int conn)
+ *
+ * Description: TRUE when the process at the other end of conn runs as
+ * this daemon's user or as root.
+ ***********************************************************************/
+static int isTrustedPeer(int conn)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+        return FALSE;
+    return cred.uid == geteuid() || cred.uid == 0;
+}
+
+/****************************   serveMatrices   *************************
+ * int serveMatrices(const char *path)
+ *
+ * Description: Runs the multiply service on a Unix domain socket until
+ * a client sends SERVE_SHUTDOWN.
+ *
+ * Process:
+ * 1.) Bind and listen on path, replacing any stale socket file. Any
+ *     other kind of file at path is left alone and refused. The file
+ *     is made 0600 before listening.
+ * 2.) Start the worker thread.
+ * 3.) Accept connections. Each carries one request, which is refused,
+ *     queued, or (for SERVE_SHUTDOWN) ends the loop. Peers running as
+ *     another user are refused whatever they ask.
+ * 4.) Let the worker finish the queue, then remove the socket file.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * path          in          Socket file name.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Served until shut down.
+ * FALSE         Could not set up the socket or the worker, or path
+ *               names something other than a socket.
+ *
+ * NOTES:
+ * - A client that connects but does not send within SERVE_TIMEOUT_MS
+ *   is dropped, so it cannot stall the accept loop.
+ ***********************************************************************/
+int serveMatrices(const char *path)
+{
+    struct sockaddr_un addr;
+    struct timeval tv;
+    ServeQueue q;
+    ServeJob job;
+    struct stat st;
+    pthread_t worker;
+    int listener;
+    int bRunning = TRUE;
+    int status;
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return FALSE;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+        return FALSE;
+    // only ever remove a stale socket, never a file or link at path
+    if (lstat(path, &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode) || unlink(path) != 0)
+        {
+            close(listener);
+            return FALSE;
+        }
+    }
+    if (bind(listener, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+        chmod(path, S_IRUSR | S_IWUSR) != 0 ||
+        listen(listener, SERVE_QUEUE_DEPTH) != 0)
+    {
+        close(listener);
+        return FALSE;
+    }
+    memset(&q, 0, sizeof(q));
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.cond, NULL);
+    if (pthread_create(&worker, NULL, workerThread, &q) != 0)
+    {
+        close(listener);
+        unlink(path);
+        return FALSE;
+    }
+    tv.tv_sec = SERVE_TIMEOUT_MS / 1000;
+    tv.tv_usec = SERVE_TIMEOUT_MS % 1000 * 1000;
+    while (bRunning)
+    {
+        job.conn = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+        if (job.conn < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+        setsockopt(job.conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        if (!recvRequest(job.conn, &job.req, &job.memfd) ||
+            !isTrustedPeer(job.conn))
+            status = SERVE_ERROR;
+        else if (job.req.op == SERVE_SHUTDOWN)
+        {
+            status = SERVE_OK;
+            bRunning = FALSE;
+        }
+        else if (job.req.op != SERVE_MULTIPLY ||
+                 !checkRequest(&job.req, job.memfd))
+            status = SERVE_ERROR;
+        else
+        {
+            pthread_mutex_lock(&q.lock);
+            status = q.count < SERVE_QUEUE_DEPTH ? SERVE_OK : SERVE_BUSY;
+            if (status == SERVE_OK)
+            {
+                q.jobs[(q.head + q.count) % SERVE_QUEUE_DEPTH] = job;
+                q.count++;
+                pthread_cond_signal(&q.cond);
+            }
+            pthread_mutex_unlock(&q.lock);
+            if (status == SERVE_OK)
+                continue;       // the worker replies
+        }
+        if (job.memfd >= 0)
+            close(job.memfd);
+        sendStatus(job.conn, status);
+    }
+    pthread_mutex_lock(&q.lock);
+    q.bStop = TRUE;
+    pthread_cond_signal(&q.cond);
+    pthread_mutex_unlock(&q.lock);
+    pthread_join(worker, NULL);
+    pthread_mutex_destroy(&q.lock);
+    pthread_cond_destroy(&q.cond);
+    close(listener);
+    unlink(path);
+    return TRUE;
+}
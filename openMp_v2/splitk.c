@@ -0,0 +1,165 @@
+#include "define.h"
+
+/***********************************************************************
+ * splitk.c written by DSU_410 team ...
+ *
+ * Description: Multiplies where the shared dimension is split as well
+ * as C. multiplyEpilogue shares the tiles of C amongst threads, which
+ * leaves cores idle when C has fewer tiles than there are threads, e.g.
+ * 16 x 1,000,000 times 1,000,000 x 16 has a single tile. Here each
+ * thread takes a slice of the shared dimension instead, computes every
+ * tile of C for it with multiplyBlock into a private partial C, and the
+ * partials are then summed in parallel, each thread adding up all the
+ * partials for its own rows of C with vectorised loops.
+ *
+ * The number of slices, and so of threads, comes from the shape: up to
+ * one per thread while every slice keeps at least SPLITK_MIN_K of the
+ * shared dimension, so zeroing and summing the partials stays small
+ * next to the products. C larger than SPLITK_MAX_C elements is never
+ * split, since it has tiles enough and its partials would be costly.
+ *
+ * Functions:
+ * - splitKSlices
+ * - multiplySplitK
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/*****************************   splitKSlices   *************************
+ * int splitKSlices(int m, int n, int k, TuneParams *tp)
+ *
+ * Description: Returns how many slices of the shared dimension an m x n
+ * result with shared dimension k should be split into, 1 when the
+ * tiles of C already keep the threads busy or C is empty.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * m, n          in          rows and columns of C.
+ * k             in          shared dimension.
+ * tp            in          ptr to TuneParams for the shape, giving the
+ *                           tile sizes and thread count.
+ ***********************************************************************/
+int splitKSlices(int m, int n, int k, TuneParams *tp)
+{
+    int numThreads = tp->numThreads > 0 ? tp->numThreads : MAX_THREADS();
+    int numTiles = ((m + tp->blockM - 1) / tp->blockM) *
+                   ((n + tp->blockN - 1) / tp->blockN);
+    int numSlices = k / SPLITK_MIN_K;
+    if (m == 0 || n == 0 || numTiles >= numThreads ||
+        (long long) m * n > SPLITK_MAX_C)
+        return 1;
+    return numSlices < numThreads ? numSlices : numThreads;
+}
+
+/****************************   multiplySplitK   ************************
+ * void multiplySplitK(MatrixView *a, MatrixView *b, MatrixView *c,
+ *                     Epilogue *epi, TuneParams *tp, int numSlices)
+ *
+ * Description: C = epi(C + A*B) with the shared dimension split into
+ * numSlices slices, one thread each.
+ *
+ * Process:
+ * 1.) Share the slices amongst threads. Each slice's partial C is
+ *     allocated and zeroed by the thread that fills it.
+ * 2.) View the slice's columns of A and rows of B and run multiplyBlock
+ *     over every tile of the partial.
+ * 3.) After a barrier the rows of C are shared out. Each row sums the
+ *     partials into a row buffer, adds the old C row, runs the
+ *     epilogue on it if any, and is stored.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to MatrixView, left operand.
+ * b             in          ptr to MatrixView, right operand.
+ * c             in/out      ptr to MatrixView, result.
+ * epi           in          ptr to Epilogue, see define.h, or NULL.
+ * tp            in          ptr to TuneParams giving the block sizes.
+ * numSlices     in          slices of the shared dimension, from
+ *                           splitKSlices.
+ *
+ * NOTES:
+ * - Shapes are checked by the caller, multiplyEpilogue. C is not
+ *   empty, splitKSlices gives 1 slice then, so the row buffer is never
+ *   a 0 byte malloc.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void multiplySplitK(MatrixView *a, MatrixView *b, MatrixView *c,
+                    Epilogue *epi, TuneParams *tp, int numSlices)
+{
+    Matrix *part = malloc(sizeof(Matrix) * numSlices);
+    int tilesN = (c->cols + tp->blockN - 1) / tp->blockN;
+    int numTiles = ((c->rows + tp->blockM - 1) / tp->blockM) * tilesN;
+    int i;
+    if (part == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    #pragma omp parallel num_threads(numSlices)
+    {
+        MatrixView va;
+        MatrixView vb;
+        MatrixView vp;
+        PerfCounters pc;
+        int bMeasure = perfEnabled();
+        int *acc = malloc(sizeof(int) * c->cols);
+        int k0;
+        int k1;
+        int s;
+        int t;
+        int j;
+        if (acc == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
+        if (bMeasure)
+            perfStart(&pc);
+        // One slice per thread, unless the team comes up short
+        #pragma omp for schedule(static)
+        for (s = 0; s < numSlices; s++)
+        {
+            k0 = (int) ((long long) a->cols * s / numSlices);
+            k1 = (int) ((long long) a->cols * (s + 1) / numSlices);
+            setUp2D(&part[s], c->rows, c->cols, FALSE);
+            subView(&va, a, 0, k0, a->rows, k1 - k0);
+            subView(&vb, b, k0, 0, k1 - k0, b->cols);
+            makeView(&vp, &part[s], FALSE);
+            for (t = 0; t < numTiles; t++)
+                multiplyBlock(&va, &vb, &vp, t / tilesN * tp->blockM,
+                              t % tilesN * tp->blockN, UPLO_FULL, NULL, tp);
+        }
+        #pragma omp for schedule(static)
+        for (i = 0; i < c->rows; i++)
+        {
+            #pragma omp simd
+            for (j = 0; j < c->cols; j++)
+                acc[j] = VIEW_AT(c, i, j);
+            for (s = 0; s < numSlices; s++)
+            {
+                #pragma omp simd
+                for (j = 0; j < c->cols; j++)
+                    acc[j] += part[s].m[i][j];
+            }
+            if (epi != NULL && epi->count > 0)
+                applyEpilogue(epi, acc, 1, c->cols, i, 0);
+            for (j = 0; j < c->cols; j++)
+                VIEW_AT(c, i, j) = acc[j];
+        }
+        // Same static schedule, so each partial is freed by the thread
+        // (and arena) that allocated it
+        #pragma omp for schedule(static)
+        for (s = 0; s < numSlices; s++)
+            free2D(&part[s]);
+        free(acc);
+        if (bMeasure)
+        {
+            perfStop(&pc);
+            perfReport("multiply.thread", THREAD_NUM(), &pc);
+        }
+    }
+    free(part);
+}
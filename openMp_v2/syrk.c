@@ -0,0 +1,129 @@
+#include "define.h"
+
+/***********************************************************************
+ * syrk.c written by DSU_410 team ...
+ *
+ * Description: Gram matrices, C += A*A^T or C += A^T*A. C is symmetric,
+ * so only the tiles on and to one side of the diagonal are computed,
+ * with the blocked kernel from matrix.c. That is about half the flops
+ * and half the writes to C of a full multiply. The other triangle can
+ * be filled in afterwards by mirroring.
+ *
+ * Tiles are square. The T(T+1)/2 tiles of the triangle are numbered in
+ * one list and the list is split evenly between threads. Splitting rows
+ * of C instead would give the threads owning the long rows of the
+ * triangle most of the work.
+ *
+ * Functions:
+ * - syrk
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/*****************************   mirror   *******************************
+ * static void mirror(Matrix *c, int uplo)
+ *
+ * Description: Copies the uplo triangle of a square c onto the other.
+ ***********************************************************************/
+static void mirror(Matrix *c, int uplo)
+{
+    int i;
+    int j;
+    #pragma omp parallel for schedule(dynamic, 16) private(j)
+    for (i = 0; i < c->rows; i++)
+        for (j = 0; j < i; j++)
+        {
+            if (uplo == UPLO_UPPER)
+                c->m[i][j] = c->m[j][i];
+            else
+                c->m[j][i] = c->m[i][j];
+        }
+}
+
+/*******************************   syrk   *******************************
+ * int syrk(Matrix *a, Matrix *c, int bTrans, int uplo, int bMirror)
+ *
+ * Description: Adds A*A^T (or A^T*A) to one triangle of c.
+ *
+ * Process:
+ * 1.) Choose a square tile size from the tuned block sizes.
+ * 2.) List the tiles of the triangle, row by row.
+ * 3.) Compute them in parallel, static shares of the list. Diagonal
+ *     tiles only update their own triangle.
+ * 4.) Mirror if asked.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to Matrix structure, see define.h.
+ * c             in/out      ptr to Matrix structure, a->rows square, or
+ *                           a->cols square with bTrans.
+ * bTrans        in          FALSE for A*A^T, TRUE for A^T*A.
+ * uplo          in          UPLO_UPPER or UPLO_LOWER, the triangle
+ *                           (diagonal included) that is updated.
+ * bMirror       in          TRUE to then copy that triangle over the
+ *                           other one.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Triangle updated.
+ * FALSE         c has the wrong shape or uplo is not a triangle.
+ *
+ * NOTES:
+ * - Without bMirror the other triangle is left as it was.
+ * - Mirroring overwrites the other triangle, it does not add to it.
+ ***********************************************************************/
+int syrk(Matrix *a, Matrix *c, int bTrans, int uplo, int bMirror)
+{
+    MatrixView va;
+    MatrixView vb;
+    MatrixView vc;
+    TuneParams tp;
+    long long start = metricsEnabled() ? metricsNow() : -1;
+    int n = bTrans ? a->cols : a->rows;
+    int *tiles;
+    int numTiles = 0;
+    int side;
+    int ti;
+    int tj;
+    int t;
+    if (c->rows != n || c->cols != n ||
+        (uplo != UPLO_UPPER && uplo != UPLO_LOWER))
+        return FALSE;
+    makeView(&va, a, bTrans);
+    makeView(&vb, a, !bTrans);
+    makeView(&vc, c, FALSE);
+    getTuneParams(n, n, va.cols, &tp);
+    tp.blockM = tp.blockM < tp.blockN ? tp.blockM : tp.blockN;
+    tp.blockN = tp.blockM;
+    side = (n + tp.blockM - 1) / tp.blockM;
+    // one (row, column) pair per tile on and beside the diagonal
+    tiles = malloc(sizeof(int) * 2 * ((size_t) side * (side + 1) / 2));
+    if (tiles == NULL && side > 0)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    for (ti = 0; ti < side; ti++)
+        for (tj = uplo == UPLO_UPPER ? ti : 0;
+             tj < (uplo == UPLO_UPPER ? side : ti + 1); tj++)
+        {
+            tiles[2 * numTiles] = ti * tp.blockM;
+            tiles[2 * numTiles + 1] = tj * tp.blockM;
+            numTiles++;
+        }
+    #pragma omp parallel for schedule(static) \
+        num_threads(tp.numThreads > 0 ? tp.numThreads : MAX_THREADS())
+    for (t = 0; t < numTiles; t++)
+        multiplyBlock(&va, &vb, &vc, tiles[2 * t], tiles[2 * t + 1],
+                      tiles[2 * t] == tiles[2 * t + 1] ? uplo : UPLO_FULL,
+                      NULL, &tp);
+    free(tiles);
+    if (bMirror)
+        mirror(c, uplo);
+    if (start >= 0)
+        metricsRecord(BACKEND_SYRK, n, n, va.cols, metricsNow() - start);
+    return TRUE;
+}
@@ -0,0 +1,325 @@
+#include "define.h"
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+/***********************************************************************
+ * transport.c written by DSU_410 team ...
+ *
+ * Description: Point to point byte streams between the ranks of a
+ * distributed multiply, see dist.c. A Transport is a table of function
+ * pointers, so dist.c does not care how bytes move. Each ordered pair of
+ * ranks has its own stream, and bytes arrive in the order they were
+ * sent.
+ *
+ * Two transports are provided, both for processes on one machine that
+ * are forked after the transport is created:
+ * - TRANSPORT_SOCKET: a Unix domain socket pair per pair of ranks.
+ * - TRANSPORT_SHM: a ring buffer per ordered pair in a shared anonymous
+ *   mapping, guarded by a process shared mutex and condition variable.
+ * A network transport only needs another init function filling in the
+ * same table.
+ *
+ * Functions:
+ * - transportInit
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) transportInit in the parent, before forking the ranks.
+ * 2.) t->attach(t, rank) in every rank, parent included.
+ * 3.) t->send and t->recv.
+ * 4.) t->destroy in every rank.
+ ************************************************************************/
+
+// One direction of a shared memory stream, head and tail only increase
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    size_t head;                // bytes written so far
+    size_t tail;                // bytes read so far
+    char data[SHM_RING_SIZE];
+} ShmChannel;
+
+/*****************************   socketSend   ***************************
+ * static int socketSend(Transport *t, int peer, const void *buf,
+ *                       size_t bytes)
+ *
+ * Description: Writes all of buf to peer's socket. MSG_NOSIGNAL turns a
+ * dead peer into an error instead of SIGPIPE.
+ ***********************************************************************/
+static int socketSend(Transport *t, int peer, const void *buf,
+                      size_t bytes)
+{
+    int fd = ((int *) t->state)[peer];
+    const char *p = buf;
+    ssize_t n;
+    while (bytes > 0)
+    {
+        n = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FALSE;
+        p += n;
+        bytes -= n;
+    }
+    return TRUE;
+}
+
+/*****************************   socketRecv   ***************************
+ * static int socketRecv(Transport *t, int peer, void *buf, size_t bytes)
+ *
+ * Description: Reads exactly bytes from peer's socket. End of file,
+ * which is what a dead peer looks like, is an error.
+ ***********************************************************************/
+static int socketRecv(Transport *t, int peer, void *buf, size_t bytes)
+{
+    int fd = ((int *) t->state)[peer];
+    char *p = buf;
+    ssize_t n;
+    while (bytes > 0)
+    {
+        n = recv(fd, p, bytes, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FALSE;
+        p += n;
+        bytes -= n;
+    }
+    return TRUE;
+}
+
+/****************************   socketAttach   **************************
+ * static void socketAttach(Transport *t, int rank)
+ *
+ * Description: Keeps the rank's own socket ends and closes the rest, so
+ * a peer that exits is seen as end of file. Afterwards state holds one
+ * descriptor per peer.
+ ***********************************************************************/
+static void socketAttach(Transport *t, int rank)
+{
+    int *fds = t->state;
+    int i;
+    int j;
+    for (i = 0; i < t->size; i++)
+        for (j = 0; j < t->size; j++)
+            if (i != rank && i != j)
+                close(fds[i * t->size + j]);
+    t->rank = rank;
+    memmove(fds, fds + rank * t->size, sizeof(int) * t->size);
+}
+
+/****************************   socketDestroy   *************************
+ * static void socketDestroy(Transport *t)
+ *
+ * Description: Closes an attached rank's sockets.
+ ***********************************************************************/
+static void socketDestroy(Transport *t)
+{
+    int *fds = t->state;
+    int j;
+    for (j = 0; j < t->size; j++)
+        if (j != t->rank)
+            close(fds[j]);
+    free(fds);
+    t->state = NULL;
+}
+
+/*****************************   channelOf   ****************************
+ * static ShmChannel *channelOf(Transport *t, int from, int to)
+ *
+ * Description: The ring carrying bytes from rank from to rank to.
+ ***********************************************************************/
+static ShmChannel *channelOf(Transport *t, int from, int to)
+{
+    return (ShmChannel *) t->state + (size_t) from * t->size + to;
+}
+
+/******************************   shmSend   *****************************
+ * static int shmSend(Transport *t, int peer, const void *buf,
+ *                    size_t bytes)
+ *
+ * Description: Copies buf into the ring towards peer, waiting whenever
+ * the ring is full.
+ ***********************************************************************/
+static int shmSend(Transport *t, int peer, const void *buf, size_t bytes)
+{
+    ShmChannel *ch = channelOf(t, t->rank, peer);
+    const char *p = buf;
+    size_t pos;
+    size_t n;
+    pthread_mutex_lock(&ch->lock);
+    while (bytes > 0)
+    {
+        while (ch->head - ch->tail == SHM_RING_SIZE)
+            pthread_cond_wait(&ch->cond, &ch->lock);
+        pos = ch->head % SHM_RING_SIZE;
+        n = SHM_RING_SIZE - (ch->head - ch->tail);
+        n = n < SHM_RING_SIZE - pos ? n : SHM_RING_SIZE - pos;
+        n = n < bytes ? n : bytes;
+        memcpy(ch->data + pos, p, n);
+        ch->head += n;
+        p += n;
+        bytes -= n;
+        pthread_cond_broadcast(&ch->cond);
+    }
+    pthread_mutex_unlock(&ch->lock);
+    return TRUE;
+}
+
+/******************************   shmRecv   *****************************
+ * static int shmRecv(Transport *t, int peer, void *buf, size_t bytes)
+ *
+ * Description: Copies bytes out of the ring from peer, waiting whenever
+ * the ring is empty.
+ ***********************************************************************/
+static int shmRecv(Transport *t, int peer, void *buf, size_t bytes)
+{
+    ShmChannel *ch = channelOf(t, peer, t->rank);
+    char *p = buf;
+    size_t pos;
+    size_t n;
+    pthread_mutex_lock(&ch->lock);
+    while (bytes > 0)
+    {
+        while (ch->head == ch->tail)
+            pthread_cond_wait(&ch->cond, &ch->lock);
+        pos = ch->tail % SHM_RING_SIZE;
+        n = ch->head - ch->tail;
+        n = n < SHM_RING_SIZE - pos ? n : SHM_RING_SIZE - pos;
+        n = n < bytes ? n : bytes;
+        memcpy(p, ch->data + pos, n);
+        ch->tail += n;
+        p += n;
+        bytes -= n;
+        pthread_cond_broadcast(&ch->cond);
+    }
+    pthread_mutex_unlock(&ch->lock);
+    return TRUE;
+}
+
+/*****************************   shmAttach   ****************************
+ * static void shmAttach(Transport *t, int rank)
+ *
+ * Description: The mapping is inherited across fork, only the rank
+ * needs setting.
+ ***********************************************************************/
+static void shmAttach(Transport *t, int rank)
+{
+    t->rank = rank;
+}
+
+/*****************************   shmDestroy   ***************************
+ * static void shmDestroy(Transport *t)
+ *
+ * Description: Unmaps the rings. Rank 0, which outlives the others,
+ * also destroys the locks.
+ ***********************************************************************/
+static void shmDestroy(Transport *t)
+{
+    int i;
+    if (t->rank == 0)
+        for (i = 0; i < t->size * t->size; i++)
+        {
+            pthread_mutex_destroy(&((ShmChannel *) t->state)[i].lock);
+            pthread_cond_destroy(&((ShmChannel *) t->state)[i].cond);
+        }
+    munmap(t->state, sizeof(ShmChannel) * t->size * t->size);
+    t->state = NULL;
+}
+
+/***************************   transportInit   **************************
+ * int transportInit(Transport *t, int kind, int size)
+ *
+ * Description: Creates the streams between size ranks and fills in the
+ * function table.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * t             out         ptr to Transport structure, see define.h.
+ * kind          in          TRANSPORT_SOCKET or TRANSPORT_SHM.
+ * size          in          Number of ranks.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Transport ready to be inherited by forked ranks.
+ * FALSE         Unknown kind or the system refused sockets or memory.
+ *
+ * NOTES:
+ * - Shared memory rings are never torn down when a rank dies, so a
+ *   rank waiting on a dead peer waits for ever. Sockets report it.
+ ***********************************************************************/
+int transportInit(Transport *t, int kind, int size)
+{
+    pthread_mutexattr_t ma;
+    pthread_condattr_t ca;
+    ShmChannel *ch;
+    int *fds;
+    int sv[2];
+    int i;
+    int j;
+    t->rank = -1;
+    t->size = size;
+    t->kind = kind;
+    if (kind == TRANSPORT_SOCKET)
+    {
+        fds = malloc(sizeof(int) * size * size);
+        if (fds == NULL)
+            return FALSE;
+        for (i = 0; i < size * size; i++)
+            fds[i] = -1;
+        for (i = 0; i < size; i++)
+            for (j = i + 1; j < size; j++)
+            {
+                if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+                {
+                    for (i = 0; i < size * size; i++)
+                        if (fds[i] >= 0)
+                            close(fds[i]);
+                    free(fds);
+                    return FALSE;
+                }
+                fds[i * size + j] = sv[0];
+                fds[j * size + i] = sv[1];
+            }
+        t->state = fds;
+        t->send = socketSend;
+        t->recv = socketRecv;
+        t->attach = socketAttach;
+        t->destroy = socketDestroy;
+        return TRUE;
+    }
+    if (kind == TRANSPORT_SHM)
+    {
+        ch = mmap(NULL, sizeof(ShmChannel) * size * size,
+                  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (ch == MAP_FAILED)
+            return FALSE;
+        pthread_mutexattr_init(&ma);
+        pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+        pthread_condattr_init(&ca);
+        pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+        for (i = 0; i < size * size; i++)
+        {
+            pthread_mutex_init(&ch[i].lock, &ma);
+            pthread_cond_init(&ch[i].cond, &ca);
+            ch[i].head = 0;
+            ch[i].tail = 0;
+        }
+        pthread_mutexattr_destroy(&ma);
+        pthread_condattr_destroy(&ca);
+        t->state = ch;
+        t->send = shmSend;
+        t->recv = shmRecv;
+        t->attach = shmAttach;
+        t->destroy = shmDestroy;
+        return TRUE;
+    }
+    return FALSE;
+}
@@ -0,0 +1,421 @@
+#include "define.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/***********************************************************************
+ * transpose.c written by DSU_410 team ...
+ *
+ * Description: Matrix transposes.
+ * - transposeMatrix, out of place. Tiles of TRANSPOSE_BLOCK x
+ *   TRANSPOSE_BLOCK are shared amongst threads. Both the source and the
+ *   destination tile stay in L1/L2 while a tile is moved, so neither
+ *   side strides through memory a column at a time.
+ * - transposeInPlace. Square matrices swap tile pairs across the
+ *   diagonal. Rectangular ones are permuted by following the cycles of
+ *   i*cols + j -> j*rows + i through the contiguous rows, with a visited
+ *   bitmap (one bit per element) as the only extra memory.
+ *
+ * With AVX2, whole 8x8 blocks are moved through registers: 8 row loads,
+ * 24 unpack/permute instructions and 8 row stores. Destinations larger
+ * than TRANSPOSE_STREAM_BYTES are written with non-temporal stores, a
+ * full cache line at a time, so the output does not evict the source
+ * from cache on its way to memory. AVX-512 targets use the same 8x8
+ * kernel.
+ *
+ * Functions:
+ * - transposeMatrix
+ * - transposeInPlace
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+#if defined(__AVX2__)
+/****************************   transpose8x8   **************************
+ * static void transpose8x8(__m256i *r)
+ *
+ * Description: Transposes 8 rows of 8 ints held in r, in registers.
+ *
+ * Process:
+ * 1.) Interleave 32 bit pairs of neighbouring rows.
+ * 2.) Interleave 64 bit pairs of those, giving 4x4 transposes in each
+ *     128 bit lane.
+ * 3.) Combine the lanes of rows 0-3 with those of rows 4-7.
+ ***********************************************************************/
+static void transpose8x8(__m256i *r)
+{
+    __m256i t[8];
+    __m256i u[8];
+    int i;
+    for (i = 0; i < 8; i += 2)
+    {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (i = 0; i < 8; i += 4)
+    {
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (i = 0; i < 4; i++)
+    {
+        r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+/******************************   load8x8   *****************************
+ * static void load8x8(Matrix *a, int row0, int col0, __m256i *r)
+ *
+ * Description: Loads the 8x8 block of a at (row0, col0) into r.
+ ***********************************************************************/
+static void load8x8(Matrix *a, int row0, int col0, __m256i *r)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+        r[i] = _mm256_loadu_si256((__m256i *) (a->m[row0 + i] + col0));
+}
+
+/*****************************   store8x8   *****************************
+ * static void store8x8(Matrix *a, int row0, int col0, __m256i *r)
+ *
+ * Description: Stores r as the 8x8 block of a at (row0, col0).
+ ***********************************************************************/
+static void store8x8(Matrix *a, int row0, int col0, __m256i *r)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+        _mm256_storeu_si256((__m256i *) (a->m[row0 + i] + col0), r[i]);
+}
+
+/****************************   stream8x16   ****************************
+ * static void stream8x16(Matrix *a, int row0, int col0, __m256i *x,
+ *                        __m256i *y)
+ *
+ * Description: Stores x and y side by side as the 8x16 block of a at
+ * (row0, col0), each row as two consecutive non-temporal stores. A 64
+ * byte aligned row fills its cache line at once, so the write combining
+ * buffer goes to memory whole. Partly filled lines would have to be
+ * flushed piecemeal, which is slower than ordinary stores, so rows not
+ * on a 64 byte boundary use those.
+ ***********************************************************************/
+static void stream8x16(Matrix *a, int row0, int col0, __m256i *x,
+                       __m256i *y)
+{
+    int *dst;
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        dst = a->m[row0 + i] + col0;
+        if (((uintptr_t) dst & 63) == 0)
+        {
+            _mm256_stream_si256((__m256i *) dst, x[i]);
+            _mm256_stream_si256((__m256i *) (dst + 8), y[i]);
+        }
+        else
+        {
+            _mm256_storeu_si256((__m256i *) dst, x[i]);
+            _mm256_storeu_si256((__m256i *) (dst + 8), y[i]);
+        }
+    }
+}
+#endif
+
+/*****************************   copyTile   *****************************
+ * static void copyTile(Matrix *a, Matrix *t, int row0, int col0,
+ *                      int numRows, int numCols, int bStream)
+ *
+ * Description: t(j, i) = a(i, j) for the numRows x numCols tile of a at
+ * (row0, col0), 8x8 blocks in registers where the tile allows. With
+ * bStream, blocks are taken in vertical pairs so every row of t gets 16
+ * ints, a whole cache line, from non-temporal stores.
+ ***********************************************************************/
+static void copyTile(Matrix *a, Matrix *t, int row0, int col0,
+                     int numRows, int numCols, int bStream)
+{
+    int fullRows = 0;
+    int fullCols = 0;
+    int i = 0;
+    int j;
+#if defined(__AVX2__)
+    __m256i x[8];
+    __m256i y[8];
+    fullRows = numRows / 8 * 8;
+    fullCols = numCols / 8 * 8;
+    if (bStream)
+        for (; i + 16 <= fullRows; i += 16)
+            for (j = 0; j < fullCols; j += 8)
+            {
+                load8x8(a, row0 + i, col0 + j, x);
+                load8x8(a, row0 + i + 8, col0 + j, y);
+                transpose8x8(x);
+                transpose8x8(y);
+                stream8x16(t, col0 + j, row0 + i, x, y);
+            }
+    for (; i < fullRows; i += 8)
+        for (j = 0; j < fullCols; j += 8)
+        {
+            load8x8(a, row0 + i, col0 + j, x);
+            transpose8x8(x);
+            store8x8(t, col0 + j, row0 + i, x);
+        }
+#else
+    (void) bStream;
+#endif
+    // Ragged right edge of the tile, then its bottom edge
+    for (i = 0; i < fullRows; i++)
+        for (j = fullCols; j < numCols; j++)
+            t->m[col0 + j][row0 + i] = a->m[row0 + i][col0 + j];
+    for (i = fullRows; i < numRows; i++)
+        for (j = 0; j < numCols; j++)
+            t->m[col0 + j][row0 + i] = a->m[row0 + i][col0 + j];
+}
+
+/*****************************   swapTiles   ****************************
+ * static void swapTiles(Matrix *a, int row0, int col0, int numRows,
+ *                       int numCols)
+ *
+ * Description: Exchanges a(i, j) and a(j, i) for the tile of a square a
+ * at (row0, col0), row0 <= col0. On the diagonal only the elements above
+ * it are exchanged with those below.
+ ***********************************************************************/
+static void swapTiles(Matrix *a, int row0, int col0, int numRows,
+                      int numCols)
+{
+    int fullRows = 0;
+    int fullCols = 0;
+    int tmp;
+    int i;
+    int j;
+#if defined(__AVX2__)
+    __m256i x[8];
+    __m256i y[8];
+    fullRows = numRows / 8 * 8;
+    fullCols = numCols / 8 * 8;
+    for (i = 0; i < fullRows; i += 8)
+        for (j = 0; j < fullCols; j += 8)
+        {
+            // blocks below the diagonal go with their mirror image
+            if (row0 + i > col0 + j)
+                continue;
+            load8x8(a, row0 + i, col0 + j, x);
+            transpose8x8(x);
+            if (row0 + i < col0 + j)
+            {
+                load8x8(a, col0 + j, row0 + i, y);
+                transpose8x8(y);
+                store8x8(a, row0 + i, col0 + j, y);
+            }
+            store8x8(a, col0 + j, row0 + i, x);
+        }
+#endif
+    // Elements outside the 8x8 blocks, the tile's ragged edges
+    for (i = 0; i < numRows; i++)
+        for (j = i < fullRows ? fullCols : 0; j < numCols; j++)
+            if (row0 + i < col0 + j)
+            {
+                tmp = a->m[row0 + i][col0 + j];
+                a->m[row0 + i][col0 + j] = a->m[col0 + j][row0 + i];
+                a->m[col0 + j][row0 + i] = tmp;
+            }
+}
+
+/***************************   transposeMatrix   ************************
+ * int transposeMatrix(Matrix *a, Matrix *t)
+ *
+ * Description: Out of place transpose, t = a^T.
+ *
+ * Process:
+ * 1.) Share the TRANSPOSE_BLOCK tiles of a amongst threads.
+ * 2.) Move each tile with copyTile, streaming stores for large t.
+ * 3.) Fence so streamed stores are visible before returning.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to Matrix structure, see define.h.
+ * t             out         ptr to Matrix, a->cols by a->rows.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Transpose stored in t.
+ * FALSE         t has the wrong shape.
+ *
+ * NOTES:
+ * - t must not overlap a, see transposeInPlace.
+ ***********************************************************************/
+int transposeMatrix(Matrix *a, Matrix *t)
+{
+    int tilesC = (a->cols + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK;
+    int numTiles = (a->rows + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK * tilesC;
+    int bStream = sizeof(int) * (size_t) t->rows * t->cols >=
+                  TRANSPOSE_STREAM_BYTES;
+    int row0;
+    int col0;
+    int k;
+    if (t->rows != a->cols || t->cols != a->rows)
+        return FALSE;
+    #pragma omp parallel private(row0, col0)
+    {
+        #pragma omp for schedule(static)
+        for (k = 0; k < numTiles; k++)
+        {
+            row0 = k / tilesC * TRANSPOSE_BLOCK;
+            col0 = k % tilesC * TRANSPOSE_BLOCK;
+            copyTile(a, t, row0, col0,
+                     a->rows - row0 < TRANSPOSE_BLOCK ? a->rows - row0
+                                                      : TRANSPOSE_BLOCK,
+                     a->cols - col0 < TRANSPOSE_BLOCK ? a->cols - col0
+                                                      : TRANSPOSE_BLOCK,
+                     bStream);
+        }
+#if defined(__AVX2__)
+        if (bStream)
+            _mm_sfence();
+#endif
+    }
+    return TRUE;
+}
+
+/*************************   cycleDestination   *************************
+ * static size_t cycleDestination(size_t k, size_t rows, size_t last)
+ *
+ * Description: Where element k of a rows x cols array goes in its
+ * transpose, k * rows mod (rows * cols - 1). last = rows * cols - 1
+ * stays put.
+ ***********************************************************************/
+static size_t cycleDestination(size_t k, size_t rows, size_t last)
+{
+    return k == last ? last
+                     : (size_t) ((unsigned __int128) k * rows % last);
+}
+
+/***************************   permuteCycles   **************************
+ * static void permuteCycles(int *data, int rows, int cols)
+ *
+ * Description: Transposes rows x cols ints in place by cycle following.
+ *
+ * Process:
+ * 1.) Hand out start positions to threads dynamically.
+ * 2.) A start already marked visited is skipped. Otherwise walk its
+ *     cycle; only the thread starting from the cycle's smallest
+ *     position (its leader) moves it, so every cycle moves once.
+ * 3.) The leader carries each element to its destination around the
+ *     cycle and marks the positions visited, so later starts on the
+ *     cycle skip the walk.
+ ***********************************************************************/
+static void permuteCycles(int *data, int rows, int cols)
+{
+    size_t last = (size_t) rows * cols - 1;
+    size_t numWords = last / 64 + 1;
+    uint64_t *visited = calloc(numWords, sizeof(uint64_t));
+    uint64_t word;
+    size_t start;
+    size_t k;
+    int carry;
+    int tmp;
+    if (visited == NULL)
+    {
+        printf("Error: no memory for array\n");
+        exit(ARRAY_MEMORY_ERROR);
+    }
+    #pragma omp parallel for schedule(dynamic, 4096) \
+        private(word, k, carry, tmp)
+    for (start = 1; start < last; start++)
+    {
+        #pragma omp atomic read
+        word = visited[start / 64];
+        if (word >> (start % 64) & 1)
+            continue;
+        for (k = cycleDestination(start, rows, last); k > start;
+             k = cycleDestination(k, rows, last))
+            ;
+        if (k < start)
+            continue;
+        carry = data[start];
+        k = start;
+        do
+        {
+            k = cycleDestination(k, rows, last);
+            tmp = data[k];
+            data[k] = carry;
+            carry = tmp;
+            #pragma omp atomic
+            visited[k / 64] |= (uint64_t) 1 << (k % 64);
+        } while (k != start);
+    }
+    free(visited);
+}
+
+/**************************   transposeInPlace   ************************
+ * int transposeInPlace(Matrix *a)
+ *
+ * Description: Replaces a by its transpose without a second matrix.
+ *
+ * Process:
+ * 1.) Square: swap the tiles above the diagonal with those below, in
+ *     parallel, tiles handed out dynamically.
+ * 2.) Rectangular: permute the contiguous rows by cycle following,
+ *     swap rows and cols, and point the row pointers at the new rows.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in/out      ptr to Matrix structure, see define.h.
+ *                           Becomes cols by rows.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          a transposed.
+ * FALSE         Rectangular a whose rows are not one contiguous block
+ *               from allocate2D, a is unchanged.
+ *
+ * NOTES:
+ * - allocate2D leaves room for max(rows, cols) row pointers, other
+ *   rectangular matrices cannot be transposed in place.
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+int transposeInPlace(Matrix *a)
+{
+    int side = (a->rows + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK;
+    int *data;
+    int row0;
+    int col0;
+    int swap;
+    int i;
+    int k;
+    if (a->rows == a->cols)
+    {
+        #pragma omp parallel for schedule(dynamic) private(row0, col0)
+        for (k = 0; k < side * side; k++)
+        {
+            row0 = k / side * TRANSPOSE_BLOCK;
+            col0 = k % side * TRANSPOSE_BLOCK;
+            if (row0 <= col0)
+                swapTiles(a, row0, col0,
+                          a->rows - row0 < TRANSPOSE_BLOCK
+                              ? a->rows - row0 : TRANSPOSE_BLOCK,
+                          a->cols - col0 < TRANSPOSE_BLOCK
+                              ? a->cols - col0 : TRANSPOSE_BLOCK);
+        }
+        return TRUE;
+    }
+    data = (int *) ((char *) a->m + (sizeof(int *) *
+                                     (a->rows > a->cols ? a->rows : a->cols)
+                                     + ARENA_ALIGN - 1) / ARENA_ALIGN *
+                                    ARENA_ALIGN);
+    for (i = 0; i < a->rows; i++)
+        if (a->m[i] != data + (size_t) i * a->cols)
+            return FALSE;
+    if (a->rows > 1 && a->cols > 1)
+        permuteCycles(data, a->rows, a->cols);
+    swap = a->rows;
+    a->rows = a->cols;
+    a->cols = swap;
+    for (i = 0; i < a->rows; i++)
+        a->m[i] = data + (size_t) i * a->cols;
+    return TRUE;
+}
@@ -0,0 +1,136 @@
+#include "define.h"
+#include <string.h>
+
+/***********************************************************************
+ * triangular.c written by DSU_410 team ...
+ *
+ * Description: Square triangular matrices in packed storage, only the
+ * n(n+1)/2 elements of the triangle, row by row (see TRI_AT), and
+ * triangular times dense (TRMM) touching only those elements, half the
+ * work of a dense multiply.
+ *
+ * Rows of a triangle have different lengths, so TRMM hands out row
+ * blocks dynamically rather than in equal static shares.
+ *
+ * Functions:
+ * - triInit
+ * - triFromDense
+ * - triFree
+ * - trmm
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/*******************************   triInit   ****************************
+ * void triInit(TriMatrix *a, int n, int uplo)
+ *
+ * Description: Allocates a zeroed packed triangular matrix.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             out         ptr to TriMatrix structure, see define.h.
+ * n             in          Rows and columns.
+ * uplo          in          UPLO_UPPER (j >= i stored) or UPLO_LOWER.
+ *
+ * NOTES:
+ * - Aborts program if memory allocation fails.
+ ***********************************************************************/
+void triInit(TriMatrix *a, int n, int uplo)
+{
+    size_t bytes = sizeof(int) * (size_t) n * (n + 1) / 2;
+    a->n = n;
+    a->uplo = uplo;
+    a->data = allocScratch(bytes);
+    memset(a->data, 0, bytes);
+}
+
+/*****************************   triFromDense   *************************
+ * void triFromDense(TriMatrix *a, Matrix *dense, int uplo)
+ *
+ * Description: Allocates a packed copy of one triangle of a square
+ * dense matrix. The other triangle is ignored.
+ ***********************************************************************/
+void triFromDense(TriMatrix *a, Matrix *dense, int uplo)
+{
+    int i;
+    int j;
+    triInit(a, dense->rows, uplo);
+    for (i = 0; i < a->n; i++)
+        for (j = uplo == UPLO_UPPER ? i : 0;
+             j < (uplo == UPLO_UPPER ? a->n : i + 1); j++)
+            TRI_AT(a, i, j) = dense->m[i][j];
+}
+
+/*******************************   triFree   ****************************
+ * void triFree(TriMatrix *a)
+ *
+ * Description: Frees a packed triangular matrix's storage.
+ ***********************************************************************/
+void triFree(TriMatrix *a)
+{
+    freeScratch(a->data);
+}
+
+/********************************   trmm   ******************************
+ * int trmm(TriMatrix *a, Matrix *b, Matrix *c)
+ *
+ * Description: C += A*B for packed triangular A and dense B.
+ *
+ * Process:
+ * 1.) Hand out blocks of BAND_ROW_BLOCK rows of C dynamically.
+ * 2.) Row i of C adds a(i, k) * row k of B for the k in row i of the
+ *     triangle, k >= i for upper, k <= i for lower.
+ * 3.) With metrics on, the call is recorded under BACKEND_TRMM.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to TriMatrix structure, see define.h.
+ * b             in          ptr to Matrix structure, a->n rows.
+ * c             in/out      ptr to Matrix structure, a->n by b->cols.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Multiplication performed.
+ * FALSE         Shapes do not match.
+ ***********************************************************************/
+int trmm(TriMatrix *a, Matrix *b, Matrix *c)
+{
+    long long start;
+    int numBlocks = (a->n + BAND_ROW_BLOCK - 1) / BAND_ROW_BLOCK;
+    int *row;
+    int *aRow;
+    int *bRow;
+    int k0;
+    int k1;
+    int blk;
+    int i;
+    int j;
+    int k;
+    if (b->rows != a->n || c->rows != a->n || c->cols != b->cols)
+        return FALSE;
+    start = metricsEnabled() ? metricsNow() : -1;
+    #pragma omp parallel for schedule(dynamic) \
+        private(row, aRow, bRow, k0, k1, i, j, k)
+    for (blk = 0; blk < numBlocks; blk++)
+        for (i = blk * BAND_ROW_BLOCK;
+             i < a->n && i < (blk + 1) * BAND_ROW_BLOCK; i++)
+        {
+            row = c->m[i];
+            k0 = a->uplo == UPLO_UPPER ? i : 0;
+            k1 = a->uplo == UPLO_UPPER ? a->n : i + 1;
+            aRow = &TRI_AT(a, i, k0);
+            for (k = k0; k < k1; k++)
+            {
+                bRow = b->m[k];
+                for (j = 0; j < c->cols; j++)
+                    row[j] += aRow[k - k0] * bRow[j];
+            }
+        }
+    if (start >= 0)
+        metricsRecord(BACKEND_TRMM, c->rows, c->cols, a->n,
+                      metricsNow() - start);
+    return TRUE;
+}
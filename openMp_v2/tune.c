@@ -0,0 +1,403 @@
+#include "define.h"
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/***********************************************************************
+ * tune.c written by DSU_410 team ...
+ *
+ * Description: Per machine tuning of the blocked multiply. For a shape
+ * class (the power-of-two buckets of M, N and K) the tuner times the
+ * multiply with different block sizes, thread counts and OpenMP
+ * schedules, and keeps the fastest. Winners are saved to a profile file
+ * whose header names the CPU model and cache sizes. A profile written
+ * on another machine is ignored.
+ *
+ * multiplyEpilogue asks getTuneParams for every call. The first call
+ * loads the profile from $MM_TUNE_PROFILE, or TUNE_PROFILE in the
+ * working directory. Shapes with no tuned class use the nearest tuned
+ * class, or the BLOCK_* defaults when the profile is empty.
+ *
+ * The search is guided rather than exhaustive. Starting from the
+ * defaults, it sweeps one parameter at a time over its candidates,
+ * keeps the best value, and makes two passes.
+ *
+ * Functions:
+ * - getTuneParams
+ * - loadTuneProfile
+ * - saveTuneProfile
+ * - tuneShape
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+// Tuned parameters for one shape class
+typedef struct
+{
+    int mClass;
+    int nClass;
+    int kClass;
+    TuneParams params;
+} TuneEntry;
+
+// Candidates searched by tuneShape, 0 threads means all of them
+static const int blockMs[] = { 16, 32, 64, 128 };
+static const int blockNs[] = { 32, 64, 128, 256 };
+static const int blockKs[] = { 64, 128, 256, 512 };
+static const int schedules[] = { SCHED_STATIC, SCHED_DYNAMIC };
+
+static TuneEntry entries[TUNE_MAX_CLASSES];
+static int numEntries = 0;
+// Set while tuneShape is timing, on its own thread only, so multiplies
+// running on other threads keep their real parameters
+static __thread TuneParams *forced = NULL;
+static pthread_once_t loadOnce = PTHREAD_ONCE_INIT;
+
+/****************************   defaultParams   *************************
+ * static void defaultParams(TuneParams *tp)
+ *
+ * Description: Untuned parameters, the BLOCK_* constants with every
+ * thread and a static schedule.
+ ***********************************************************************/
+static void defaultParams(TuneParams *tp)
+{
+    tp->blockM = BLOCK_M;
+    tp->blockN = BLOCK_N;
+    tp->blockK = BLOCK_K;
+    tp->numThreads = 0;
+    tp->schedule = SCHED_STATIC;
+}
+
+/*****************************   dimClass   *****************************
+ * static int dimClass(int n)
+ *
+ * Description: Smallest c with 2^c >= n.
+ ***********************************************************************/
+static int dimClass(int n)
+{
+    int c = 0;
+    while (c < 31 && (1 << c) < n)
+        c++;
+    return c;
+}
+
+/****************************   machineKey   ****************************
+ * static void machineKey(char *cpu, int size, long *caches)
+ *
+ * Description: Identifies the host: CPU model name from /proc/cpuinfo
+ * and L1D, L2 and L3 sizes from sysconf. Unknown values are "unknown"
+ * and 0.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * cpu           out         Model name, spaces replaced by '_'.
+ * size          in          Bytes available in cpu.
+ * caches        out         3 cache sizes in bytes.
+ ***********************************************************************/
+static void machineKey(char *cpu, int size, long *caches)
+{
+    char line[256];
+    char *p;
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    snprintf(cpu, size, "unknown");
+    if (fp != NULL)
+    {
+        while (fgets(line, sizeof(line), fp) != NULL)
+        {
+            if (strncmp(line, "model name", 10) == 0 &&
+                (p = strchr(line, ':')) != NULL)
+            {
+                p += strspn(p + 1, " \t") + 1;
+                p[strcspn(p, "\n")] = '\0';
+                snprintf(cpu, size, "%s", p);
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    for (p = cpu; *p != '\0'; p++)
+        if (*p == ' ' || *p == '\t')
+            *p = '_';
+    caches[0] = caches[1] = caches[2] = 0;
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    caches[0] = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    caches[1] = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    caches[2] = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+}
+
+/*************************   loadDefaultProfile   ***********************
+ * static void loadDefaultProfile(void)
+ *
+ * Description: Run once by the first getTuneParams, loads the profile
+ * named by $MM_TUNE_PROFILE or TUNE_PROFILE.
+ ***********************************************************************/
+static void loadDefaultProfile(void)
+{
+    const char *path = getenv("MM_TUNE_PROFILE");
+    loadTuneProfile(path != NULL ? path : TUNE_PROFILE);
+}
+
+/****************************   getTuneParams   *************************
+ * void getTuneParams(int m, int n, int k, TuneParams *tp)
+ *
+ * Description: Parameters the multiply should use for an m-by-k times
+ * k-by-n product.
+ *
+ * Process:
+ * 1.) Load the profile the first time through.
+ * 2.) Take the tuned class nearest to the shape's class, measured as
+ *     the sum of class differences, or the defaults if none.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * m, n, k       in          Shape of the product.
+ * tp            out         ptr to TuneParams structure, see define.h.
+ ***********************************************************************/
+void getTuneParams(int m, int n, int k, TuneParams *tp)
+{
+    int mc = dimClass(m);
+    int nc = dimClass(n);
+    int kc = dimClass(k);
+    int best = -1;
+    int bestDist = 0;
+    int dist;
+    int i;
+    if (forced != NULL)
+    {
+        *tp = *forced;
+        return;
+    }
+    pthread_once(&loadOnce, loadDefaultProfile);
+    for (i = 0; i < numEntries; i++)
+    {
+        dist = abs(entries[i].mClass - mc) + abs(entries[i].nClass - nc) +
+               abs(entries[i].kClass - kc);
+        if (best < 0 || dist < bestDist)
+        {
+            best = i;
+            bestDist = dist;
+        }
+    }
+    if (best < 0)
+        defaultParams(tp);
+    else
+        *tp = entries[best].params;
+}
+
+/***************************   loadTuneProfile   ************************
+ * int loadTuneProfile(const char *path)
+ *
+ * Description: Replaces the tuned classes with those in a profile file.
+ *
+ * Process:
+ * 1.) Check the header matches this machine's CPU model and caches.
+ * 2.) Read one "class" line per shape class.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * path          in          Profile written by saveTuneProfile.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Profile loaded.
+ * FALSE         Missing, unreadable or from another machine. The
+ *               tuned classes are left empty, so defaults apply.
+ ***********************************************************************/
+int loadTuneProfile(const char *path)
+{
+    char cpu[128];
+    char fileCpu[128];
+    long caches[3];
+    long fileCaches[3];
+    TuneEntry e;
+    FILE *fp = fopen(path, "r");
+    numEntries = 0;
+    if (fp == NULL)
+        return FALSE;
+    machineKey(cpu, sizeof(cpu), caches);
+    if (fscanf(fp, " cpu %127s caches %ld %ld %ld", fileCpu, &fileCaches[0],
+               &fileCaches[1], &fileCaches[2]) != 4 ||
+        strcmp(cpu, fileCpu) != 0 || caches[0] != fileCaches[0] ||
+        caches[1] != fileCaches[1] || caches[2] != fileCaches[2])
+    {
+        fclose(fp);
+        return FALSE;
+    }
+    while (numEntries < TUNE_MAX_CLASSES &&
+           fscanf(fp, " class %d %d %d block %d %d %d threads %d schedule %d",
+                  &e.mClass, &e.nClass, &e.kClass, &e.params.blockM,
+                  &e.params.blockN, &e.params.blockK, &e.params.numThreads,
+                  &e.params.schedule) == 8)
+    {
+        if (e.params.blockM > 0 && e.params.blockN > 0 &&
+            e.params.blockK > 0 && e.params.numThreads >= 0)
+            entries[numEntries++] = e;
+    }
+    fclose(fp);
+    return TRUE;
+}
+
+/***************************   saveTuneProfile   ************************
+ * int saveTuneProfile(const char *path)
+ *
+ * Description: Writes the tuned classes, headed by this machine's key.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * path          in          File to write.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          Profile written.
+ * FALSE         File could not be opened.
+ ***********************************************************************/
+int saveTuneProfile(const char *path)
+{
+    char cpu[128];
+    long caches[3];
+    FILE *fp = fopen(path, "w");
+    int i;
+    if (fp == NULL)
+        return FALSE;
+    machineKey(cpu, sizeof(cpu), caches);
+    fprintf(fp, "cpu %s caches %ld %ld %ld\n", cpu, caches[0], caches[1],
+            caches[2]);
+    for (i = 0; i < numEntries; i++)
+        fprintf(fp, "class %d %d %d block %d %d %d threads %d schedule %d\n",
+                entries[i].mClass, entries[i].nClass, entries[i].kClass,
+                entries[i].params.blockM, entries[i].params.blockN,
+                entries[i].params.blockK, entries[i].params.numThreads,
+                entries[i].params.schedule);
+    fclose(fp);
+    return TRUE;
+}
+
+/****************************   timeParams   ****************************
+ * static long long timeParams(MatrixView *a, MatrixView *b, Matrix *c,
+ *                             TuneParams *tp)
+ *
+ * Description: Best of TUNE_REPEATS runs of the multiply with tp forced.
+ ***********************************************************************/
+static long long timeParams(MatrixView *a, MatrixView *b, Matrix *c,
+                            TuneParams *tp)
+{
+    MatrixView vc;
+    long long best = -1;
+    long long start;
+    long long ns;
+    int r;
+    makeView(&vc, c, FALSE);
+    forced = tp;
+    for (r = 0; r < TUNE_REPEATS; r++)
+    {
+        fillZeroes2D(c);
+        start = metricsNow();
+        multiplyView(a, b, &vc);
+        ns = metricsNow() - start;
+        if (best < 0 || ns < best)
+            best = ns;
+    }
+    forced = NULL;
+    return best;
+}
+
+/*****************************   tuneShape   ****************************
+ * void tuneShape(int m, int n, int k, FILE *log)
+ *
+ * Description: Finds good parameters for an m-by-k times k-by-n product
+ * on this machine and stores them for the shape's class.
+ *
+ * Process:
+ * 1.) Make random operands of the shape.
+ * 2.) Starting from the defaults, sweep blockM, blockN, blockK, thread
+ *     count and schedule in turn, keeping the fastest value of each.
+ *     Two passes.
+ * 3.) Replace or add the class entry.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * m, n, k       in          Shape to tune for.
+ * log           in          Stream for progress lines, or NULL.
+ *
+ * NOTES:
+ * - Call saveTuneProfile afterwards to keep the result.
+ ***********************************************************************/
+void tuneShape(int m, int n, int k, FILE *log)
+{
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    MatrixView va;
+    MatrixView vb;
+    TuneParams best;
+    TuneParams trial;
+    long long bestNs;
+    long long ns;
+    int threads[3];
+    int pass;
+    int param;
+    int count;
+    int i;
+    pthread_once(&loadOnce, loadDefaultProfile);  // keep other classes
+    setUp2D(&a, m, k, TRUE);
+    setUp2D(&b, k, n, TRUE);
+    setUp2D(&c, m, n, FALSE);
+    makeView(&va, &a, FALSE);
+    makeView(&vb, &b, FALSE);
+    threads[0] = 1;
+    threads[1] = MAX_THREADS() / 2 > 1 ? MAX_THREADS() / 2 : 1;
+    threads[2] = MAX_THREADS();
+    defaultParams(&best);
+    best.numThreads = MAX_THREADS();
+    bestNs = timeParams(&va, &vb, &c, &best);
+    for (pass = 0; pass < 2; pass++)
+        for (param = 0; param < 5; param++)
+        {
+            count = param == 3 ? 3 : param == 4 ? 2 : 4;
+            for (i = 0; i < count; i++)
+            {
+                trial = best;
+                switch (param)
+                {
+                    case 0: trial.blockM = blockMs[i]; break;
+                    case 1: trial.blockN = blockNs[i]; break;
+                    case 2: trial.blockK = blockKs[i]; break;
+                    case 3: trial.numThreads = threads[i]; break;
+                    case 4: trial.schedule = schedules[i]; break;
+                }
+                ns = timeParams(&va, &vb, &c, &trial);
+                if (ns < bestNs)
+                {
+                    best = trial;
+                    bestNs = ns;
+                }
+            }
+        }
+    for (i = 0; i < numEntries; i++)
+        if (entries[i].mClass == dimClass(m) &&
+            entries[i].nClass == dimClass(n) &&
+            entries[i].kClass == dimClass(k))
+            break;
+    if (i < TUNE_MAX_CLASSES)
+    {
+        entries[i].mClass = dimClass(m);
+        entries[i].nClass = dimClass(n);
+        entries[i].kClass = dimClass(k);
+        entries[i].params = best;
+        if (i == numEntries)
+            numEntries++;
+    }
+    if (log != NULL)
+        fprintf(log, "tuned %dx%dx%d: block %d %d %d threads %d "
+                "schedule %s, %lld ns\n", m, n, k, best.blockM, best.blockN,
+                best.blockK, best.numThreads,
+                best.schedule == SCHED_DYNAMIC ? "dynamic" : "static",
+                bestNs);
+    free2D(&a);
+    free2D(&b);
+    free2D(&c);
+}
@@ -5,14 +5,39 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
+#include <time.h>
+
+/**** Structs ****/
+// Hardware counters for one phase on one thread, see perf.c
+#define PERF_EVENTS     5
+typedef struct
+{
+    int fd[PERF_EVENTS];            // counter descriptors, -1 unavailable
+    long long value[PERF_EVENTS];   // counts, -1 unavailable
+    long long wallNs;               // elapsed wall time
+    struct timespec start;
+    int *taskFd;                    // other threads, perfStartProcess
+    int numTasks;                   // PERF_EVENTS fds each in taskFd
+} PerfCounters;
 
 /**** Constants ****/
 // Booleans
 #define FALSE   0
 #define TRUE    1
 
+// Errors
+#define ARRAY_MEMORY_ERROR  10
+
 // Threads
 #define NUM_THREADS     5
+#define SPLITK_MIN_K    256     // shortest slice of P a thread is given
+
+// Performance counters, index into PerfCounters arrays
+#define PERF_CYCLES         0
+#define PERF_INSTRUCTIONS   1
+#define PERF_L1D_MISSES     2
+#define PERF_LLC_MISSES     3
+#define PERF_DTLB_MISSES    4
 
 // Random numbers
 #define RANGE 5    // [0..RANGE)
@@ -24,4 +49,12 @@ void fillRandom2D(int rows, int cols, int a[][cols]);
 void fillZeroes2D(int rows, int cols, int a[][cols]);
 void print2D(int rows, int cols, int a[][cols]);
 
+// perf.c prototypes
+void perfEnable(FILE *out);
+int perfEnabled(void);
+void perfStart(PerfCounters *pc);
+void perfStartProcess(PerfCounters *pc);
+void perfStop(PerfCounters *pc);
+void perfReport(const char *phase, int thread, PerfCounters *pc);
+
 #endif /* define_h */
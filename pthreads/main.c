@@ -1,4 +1,5 @@
 #include "define.h"
+#include <string.h>
 /***********************************************************************
  * main.c written by DSU_410 team ...
  *
@@ -6,8 +7,11 @@
  * and store the result. Performs matrix multiplication concurrently 
  * using pthreads.
  *
- * compile: %gcc main.c 2DArray.c -o mmpthreads -lpthread
- * execute: ./mmpthreads
+ * compile: %gcc main.c 2DArray.c perf.c -o mmpthreads -lpthread
+ * execute: ./mmpthreads [--perf]
+ *
+ * --perf writes hardware counters for each phase, and for each thread
+ * in partition, to stderr as JSON lines (see perf.c).
  *
  * Process:
  * 1.) Fill two 2D arrays A and B with random values.
@@ -24,6 +28,9 @@ int A[N][P];
 int B[P][M];
 int C[N][M];
 
+// Guards C while threads add in partial rows, see multiplySlice
+pthread_mutex_t cLock = PTHREAD_MUTEX_INITIALIZER;
+
 /*******************************   multiplyMatrices  ***************************
  * int multiplyMatrices(int row)
  *
@@ -57,6 +64,60 @@ void multiplyMatrices(int row)
             C[row][j] += A[row][k] * B[k][j];
 }
 
+/*******************************   multiplySlice  ******************************
+ * void multiplySlice(int row, int k0, int k1, int *acc)
+ *
+ * Description: Adds the products of row of A and columns k0 to k1 - 1 of A
+ * (rows k0 to k1 - 1 of B) into row of C.
+ *
+ * Process:
+ * 1.) Sum the slice's products into acc.
+ * 2.) Add acc into C under cLock, as other threads add other slices of the
+ *     same row.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * row           in          index of row A and of row C.
+ * k0, k1        in          slice [k0..k1) of the shared dimension P.
+ * acc           in          M ints of scratch owned by the calling thread.
+ *
+ * Returns       Method      Description
+ * ----------------------------------------------------------------------------
+ * Product       Side effect Adds the slice's share of the product into C.
+ ******************************************************************************/
+void multiplySlice(int row, int k0, int k1, int *acc)
+{
+    int j, k;
+    for (j = 0; j < M; j++)
+    {
+        acc[j] = 0;
+        for (k = k0; k < k1; k++)
+            acc[j] += A[row][k] * B[k][j];
+    }
+    pthread_mutex_lock(&cLock);
+    for (j = 0; j < M; j++)
+        C[row][j] += acc[j];
+    pthread_mutex_unlock(&cLock);
+}
+
+/*******************************   numKSlices  *********************************
+ * int numKSlices()
+ *
+ * Description: Returns how many slices the shared dimension P is cut into,
+ * 1 when there are at least as many rows as threads. With fewer rows the
+ * spare threads take slices of P instead, none shorter than SPLITK_MIN_K.
+ ******************************************************************************/
+int numKSlices()
+{
+    int numSlices;
+    if (N >= NUM_THREADS)
+        return 1;
+    numSlices = NUM_THREADS / N;
+    if (numSlices > P / SPLITK_MIN_K)
+        numSlices = P / SPLITK_MIN_K;
+    return numSlices < 1 ? 1 : numSlices;
+}
+
 /* Initial conjecture for implementing openMp version
 void multiplyMatrices(int row)
 {
@@ -74,11 +135,15 @@ void multiplyMatrices(int row)
  *
  * Description: Partitions matrix multiplication by dividing rows amongst
  * threads.  Every thread calls multilpyMatrices for each of its assigned
- * rows.
+ * rows.  When there are fewer rows than threads, the shared dimension P is
+ * also cut into slices (see numKSlices): threads form one group per slice,
+ * the rows are divided amongst each group, and every thread calls
+ * multiplySlice for its rows and slice.
  *
  * Process:
- * 1.) Divide work.
- * 2.) Call multiplyMatrices.
+ * 1.) Divide work, thread tid taking group tid / slices, slice tid % slices.
+ * 2.) Call multiplyMatrices or multiplySlice, measuring the thread's share
+ *     with perf.c.
  * 3.) Threads exit.
  *
  * Parameter     Direction   Description
@@ -98,29 +163,56 @@ void multiplyMatrices(int row)
  ******************************************************************************/
 void *partition(void *p)
 {
+    PerfCounters pc;
     int i;
     long tid = (long) p;
-    int numRows = N / NUM_THREADS;
-    int remainingRows = N % NUM_THREADS;
-    int startRow = numRows * tid;
+    int numSlices = numKSlices();
+    int numGroups = NUM_THREADS / numSlices;
+    int group = tid / numSlices;
+    int slice = tid % numSlices;
+    int numRows = N / numGroups;
+    int remainingRows = N % numGroups;
+    int startRow = numRows * group;
     int endRow;
-    // last thread is one less than NUM_THREADS [0..NUM_THREADS)
-    // last thread is assigned remaining number of rows, in the worst case is
+    int k0 = P * slice / numSlices;
+    int k1 = P * (slice + 1) / numSlices;
+    int *acc = NULL;
+    // last group is one less than numGroups [0..numGroups)
+    // last group is assigned remaining number of rows, in the worst case is
     // N - 1
-    if (tid == NUM_THREADS - 1)
+    if (group == numGroups - 1)
     {
-        endRow = numRows * tid + numRows + remainingRows;
+        endRow = numRows * group + numRows + remainingRows;
     }
     else
     {
-        endRow = numRows * tid + numRows;
+        endRow = numRows * group + numRows;
+    }
+    // threads left over when slices do not divide NUM_THREADS sit out
+    if (group >= numGroups)
+        endRow = startRow;
+    if (numSlices > 1 && endRow > startRow)
+    {
+        acc = malloc(sizeof(int) * M);
+        if (acc == NULL)
+        {
+            printf("Error: no memory for array\n");
+            exit(ARRAY_MEMORY_ERROR);
+        }
     }
     /* Used for testing work distribution
     for (i = startRow; i < endRow; i++)
         printf("Tid %d does row %d\n", tid, i);
     */
+    perfStart(&pc);
     for (i = startRow; i < endRow; i++)
-        multiplyMatrices(i);
+        if (numSlices == 1)
+            multiplyMatrices(i);
+        else
+            multiplySlice(i, k0, k1, acc);
+    perfStop(&pc);
+    free(acc);
+    perfReport("multiply.thread", (int) tid, &pc);
     pthread_exit(NULL);
 }
 
@@ -228,17 +320,34 @@ void printResult()
 
 int main(int argc, const char * argv[])
 {
+    PerfCounters pc;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--perf") == 0)
+            perfEnable(stderr);
+    }
     
     // Set up Matrices, includes memory allocation and assigning values
+    perfStartProcess(&pc);
     setUpMatrices();
+    perfStop(&pc);
+    perfReport("setup", -1, &pc);
     
     // Try to multiply Matrices A B, store result into Matrix C
     // If multiplication not performed FALSE is returned
+    perfStartProcess(&pc);
     multiply();
+    perfStop(&pc);
+    perfReport("multiply", -1, &pc);
     
     // Matrix multiplication was performed, print out results stored
     // in Matrix C
+    perfStartProcess(&pc);
     printResult();
+    perfStop(&pc);
+    perfReport("output", -1, &pc);
     
     return 0;
 }
@@ -13,6 +13,18 @@ typedef struct
     int **m;    // 2D matrix
 } Matrix;
 
+// Zero-copy window into a Matrix, optionally transposed. Rows are
+// reached through the Matrix's own row pointers (which play the part
+// of the leading dimension), so blocks of any Matrix can be viewed.
+typedef struct
+{
+    int **m;    // row pointers of the underlying storage, offset to block
+    int col0;   // column offset of the block within each storage row
+    int rows;   // logical rows (after any transpose)
+    int cols;   // logical columns (after any transpose)
+    int bTrans; // TRUE when logical (i, j) is storage (j, i)
+} MatrixView;
+
 /**** Constants ****/
 // Booleans
 #define FALSE               0
@@ -24,6 +36,11 @@ typedef struct
 // Random numbers
 #define RANGE 4    // [0..RANGE)
 
+/**** Macros ****/
+// Logical element (i, j) of a MatrixView
+#define VIEW_AT(v, i, j)    (*((v)->bTrans ? &(v)->m[(j)][(v)->col0 + (i)] \
+                                           : &(v)->m[(i)][(v)->col0 + (j)]))
+
 /***** Function Prototypes *****/
 // main.c prototypes
 void test(Matrix *A, Matrix *B, Matrix *C);
@@ -42,5 +59,13 @@ void free2D(Matrix *a);
 // matrix.c prototypes
 int isDefined(Matrix *a, Matrix *b);
 int multiply(Matrix *a, Matrix *b, Matrix *c);
+int multiplyView(MatrixView *a, MatrixView *b, MatrixView *c);
+
+// view.c prototypes
+void makeView(MatrixView *v, Matrix *a, int bTrans);
+int subView(MatrixView *v, MatrixView *parent, int row0, int col0,
+            int numRows, int numCols);
+void transposeView(MatrixView *v);
+int isDefinedView(MatrixView *a, MatrixView *b, MatrixView *c);
 
 #endif /* define_h */
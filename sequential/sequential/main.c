@@ -7,7 +7,7 @@
  * the sequential version. The next two will be concurrent versions
  * using slightly different parallel approaches.
  *
- * compile: %gcc main.c 2DArray.c matrix.c -o mmseq
+ * compile: %gcc main.c 2DArray.c matrix.c view.c -o mmseq
  * execute: ./mmseq
  *
  * Process:
@@ -11,6 +11,7 @@
  * Functions:
  * - isDefined
  * - multiply
+ * - multiplyView
  *
  * compile: Used with main.c, not meant to be independently executable
  *
@@ -59,7 +60,8 @@ int isDefined(Matrix *a, Matrix *b)
  * results into Matrix c.
  *
  * Process:
- * 1.) Perform multiplication and store result.
+ * 1.) Wrap each Matrix in a full, untransposed view.
+ * 2.) Perform multiplication and store result by calling multiplyView.
  *
  * Parameter     Direction   Description
  * ----------------------------------------------------------------------------
@@ -81,17 +83,61 @@ int isDefined(Matrix *a, Matrix *b)
  ******************************************************************************/
 int multiply(Matrix *a, Matrix *b, Matrix *c)
 {
-    int bVal = TRUE;
+    MatrixView va;
+    MatrixView vb;
+    MatrixView vc;
+    int bVal = isDefined(a, b);
+    if (bVal)
+    {
+        makeView(&va, a, FALSE);
+        makeView(&vb, b, FALSE);
+        makeView(&vc, c, FALSE);
+        bVal = multiplyView(&va, &vb, &vc);
+    }
+    return bVal;
+}
+
+/*****************************   multiplyView   ******************************
+ * int multiplyView(MatrixView *a, MatrixView *b, MatrixView *c)
+ *
+ * Description: Performs C += A*B on views, so any operand may be a block
+ * of a larger Matrix or a transpose. Nothing is copied.
+ *
+ * Process:
+ * 1.) Check the product is defined and fits c.
+ * 2.) Perform multiplication and store result.
+ *
+ * Parameter     Direction   Description
+ * ----------------------------------------------------------------------------
+ * a             in          ptr to MatrixView, left operand.
+ * b             in          ptr to MatrixView, right operand.
+ * c             in/out      ptr to MatrixView, product is added into it.
+ *
+ * Returns       Description
+ * ----------------------------------------------------------------------------
+ * TRUE          Matrix multiplication was performed.
+ * FALSE         Matrix multiplication was not performed.
+ *
+ * NOTES:
+ * - c must not overlap a or b.
+ ******************************************************************************/
+int multiplyView(MatrixView *a, MatrixView *b, MatrixView *c)
+{
+    int bVal = isDefinedView(a, b, c);
     int i;
     int j;
     int k;
-    bVal = isDefined(a, b);
+    int sum;
     if (bVal)
     {
-        for (i = 0; i < a->rows; i++)
-            for (j = 0; j < b->cols; j++)
-                for (k = 0; k < b->rows; k++)
-                    c->m[i][j] += a->m[i][k] * b->m[k][j];
+        for (i = 0; i < c->rows; i++)
+            for (j = 0; j < c->cols; j++)
+            {
+                sum = 0;
+                for (k = 0; k < a->cols; k++)
+                    sum += VIEW_AT(a, i, k) * VIEW_AT(b, k, j);
+                VIEW_AT(c, i, j) += sum;
+            }
     }
     return bVal;
 }
\ No newline at end of file
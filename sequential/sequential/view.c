@@ -0,0 +1,159 @@
+#include "define.h"
+
+/***********************************************************************
+ * view.c written by DSU_410 team ...
+ *
+ * Description: Lightweight views into Matrix structures. A view names a
+ * rectangular block of an existing Matrix, optionally transposed,
+ * without allocating or copying any of its values. Every multiply
+ * routine accepts views for A, B and C, so sub-block products and
+ * products with transposed operands (A^T*B, A*B^T) need no temporaries.
+ *
+ * Functions:
+ * - makeView
+ * - subView
+ * - transposeView
+ * - isDefinedView
+ *
+ * compile: Used with main.c, not meant to be independently executable
+ *
+ * Process:
+ * 1.) Used when functions are invoked.
+ ************************************************************************/
+
+/*****************************   makeView   *****************************
+ * void makeView(MatrixView *v, Matrix *a, int bTrans)
+ *
+ * Description: Makes a view covering all of Matrix a, or all of its
+ * transpose.
+ *
+ * Process:
+ * 1.) Point the view at a's row pointers with no column offset.
+ * 2.) Swap the logical dimensions if the view is transposed.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * v             out         ptr to MatrixView structure, see define.h.
+ * a             in          ptr to Matrix structure the view reads from.
+ * bTrans        in          Boolean, TRUE makes v a view of a^T.
+ *
+ * NOTES:
+ * - Assumes Matrix a was properly set up and allocated.
+ * - The view is only valid while a's memory is.
+ ***********************************************************************/
+void makeView(MatrixView *v, Matrix *a, int bTrans)
+{
+    v->m = a->m;
+    v->col0 = 0;
+    v->bTrans = bTrans;
+    if (bTrans)
+    {
+        v->rows = a->cols;
+        v->cols = a->rows;
+    }
+    else
+    {
+        v->rows = a->rows;
+        v->cols = a->cols;
+    }
+}
+
+/*****************************   subView   ******************************
+ * int subView(MatrixView *v, MatrixView *parent, int row0, int col0,
+ *             int numRows, int numCols)
+ *
+ * Description: Makes a view of the numRows-by-numCols block of parent
+ * whose top left corner is (row0, col0) in parent's logical coordinates.
+ *
+ * Process:
+ * 1.) Check the block lies inside parent.
+ * 2.) Offset the row pointers and column offset of the underlying
+ *     storage. For a transposed parent logical rows are storage columns
+ *     and logical columns are storage rows.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * v             out         ptr to MatrixView structure, see define.h.
+ * parent        in          ptr to MatrixView the block is taken from.
+ * row0          in          First logical row of the block.
+ * col0          in          First logical column of the block.
+ * numRows       in          Number of rows in the block.
+ * numCols       in          Number of columns in the block.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          View was made.
+ * FALSE         Block does not lie inside parent, v is left untouched.
+ *
+ * NOTES:
+ * - v may be the same structure as parent.
+ ***********************************************************************/
+int subView(MatrixView *v, MatrixView *parent, int row0, int col0,
+            int numRows, int numCols)
+{
+    if (row0 < 0 || col0 < 0 || numRows < 0 || numCols < 0 ||
+        row0 + numRows > parent->rows || col0 + numCols > parent->cols)
+        return FALSE;
+    if (parent->bTrans)
+    {
+        v->m = parent->m + col0;
+        v->col0 = parent->col0 + row0;
+    }
+    else
+    {
+        v->m = parent->m + row0;
+        v->col0 = parent->col0 + col0;
+    }
+    v->bTrans = parent->bTrans;
+    v->rows = numRows;
+    v->cols = numCols;
+    return TRUE;
+}
+
+/***************************   transposeView   **************************
+ * void transposeView(MatrixView *v)
+ *
+ * Description: Turns v into a view of its own transpose in place.
+ *
+ * Process:
+ * 1.) Flip the transpose flag and swap the logical dimensions.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * v             in/out      ptr to MatrixView structure, see define.h.
+ *
+ * NOTES:
+ * - No values are moved, only the way the view reads them changes.
+ ***********************************************************************/
+void transposeView(MatrixView *v)
+{
+    int temp = v->rows;
+    v->rows = v->cols;
+    v->cols = temp;
+    v->bTrans = !v->bTrans;
+}
+
+/***************************   isDefinedView   **************************
+ * int isDefinedView(MatrixView *a, MatrixView *b, MatrixView *c)
+ *
+ * Description: Ensures the product of views a and b is mathematically
+ * defined and fits into view c.
+ *
+ * Parameter     Direction   Description
+ * ---------------------------------------------------------------------
+ * a             in          ptr to MatrixView, left operand.
+ * b             in          ptr to MatrixView, right operand.
+ * c             in          ptr to MatrixView, result.
+ *
+ * Returns       Description
+ * ---------------------------------------------------------------------
+ * TRUE          a*b is defined and c is a->rows-by-b->cols.
+ * FALSE         Otherwise.
+ ***********************************************************************/
+int isDefinedView(MatrixView *a, MatrixView *b, MatrixView *c)
+{
+    int bVal = TRUE;
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols)
+        bVal = FALSE;
+    return bVal;
+}